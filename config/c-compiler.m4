@@ -637,6 +637,63 @@ undefine([Ac_cachevar])dnl
 ])# PGAC_SSE42_CRC32_INTRINSICS
 
 
+# PGAC_PCLMUL_INTRINSICS
+# -----------------------
+# Check if the compiler supports the carry-less multiplication instruction
+# PCLMULQDQ, using the _mm_clmulepi64_si128 intrinsic function.
+#
+# An optional compiler flag can be passed as argument (e.g. -mpclmul). If the
+# intrinsic is supported, sets pgac_pclmul_intrinsics, and CFLAGS_PCLMUL.
+AC_DEFUN([PGAC_PCLMUL_INTRINSICS],
+[define([Ac_cachevar], [AS_TR_SH([pgac_cv_pclmul_intrinsics_$1])])dnl
+AC_CACHE_CHECK([for _mm_clmulepi64_si128 with CFLAGS=$1], [Ac_cachevar],
+[pgac_save_CFLAGS=$CFLAGS
+CFLAGS="$pgac_save_CFLAGS $1"
+AC_LINK_IFELSE([AC_LANG_PROGRAM([#include <wmmintrin.h>],
+  [__m128i x = _mm_set1_epi32(1);
+   x = _mm_clmulepi64_si128(x, x, 0x00);
+   /* return computed value, to prevent the above being optimized away */
+   return _mm_cvtsi128_si32(x) == 0;])],
+  [Ac_cachevar=yes],
+  [Ac_cachevar=no])
+CFLAGS="$pgac_save_CFLAGS"])
+if test x"$Ac_cachevar" = x"yes"; then
+  CFLAGS_PCLMUL="$1"
+  pgac_pclmul_intrinsics=yes
+fi
+undefine([Ac_cachevar])dnl
+])# PGAC_PCLMUL_INTRINSICS
+
+
+# PGAC_AVX2_INTRINSICS
+# -----------------------
+# Check if the compiler supports the AVX2 instructions used by the data page
+# checksum calculation, using the _mm256_mullo_epi32 and _mm256_srli_epi32
+# intrinsic functions.
+#
+# An optional compiler flag can be passed as argument (e.g. -mavx2). If the
+# intrinsics are supported, sets pgac_avx2_intrinsics, and CFLAGS_AVX2.
+AC_DEFUN([PGAC_AVX2_INTRINSICS],
+[define([Ac_cachevar], [AS_TR_SH([pgac_cv_avx2_intrinsics_$1])])dnl
+AC_CACHE_CHECK([for _mm256_mullo_epi32 and _mm256_srli_epi32 with CFLAGS=$1], [Ac_cachevar],
+[pgac_save_CFLAGS=$CFLAGS
+CFLAGS="$pgac_save_CFLAGS $1"
+AC_LINK_IFELSE([AC_LANG_PROGRAM([#include <immintrin.h>],
+  [__m256i x = _mm256_set1_epi32(1);
+   x = _mm256_mullo_epi32(x, _mm256_srli_epi32(x, 17));
+   /* return computed value, to prevent the above being optimized away */
+   return _mm256_movemask_epi8(x) == 0;])],
+  [Ac_cachevar=yes],
+  [Ac_cachevar=no])
+CFLAGS="$pgac_save_CFLAGS"])
+if test x"$Ac_cachevar" = x"yes"; then
+  CFLAGS_AVX2="$1"
+  pgac_avx2_intrinsics=yes
+fi
+undefine([Ac_cachevar])dnl
+])# PGAC_AVX2_INTRINSICS
+
+
 # PGAC_ARMV8_CRC32C_INTRINSICS
 # -----------------------
 # Check if the compiler supports the CRC32C instructions using the __crc32cb,
@@ -0,0 +1,18 @@
+/* contrib/pg_calibrate/pg_calibrate--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION pg_calibrate" to load this file. \quit
+
+-- Register the function.
+CREATE FUNCTION pg_calibrate_costs(IN rel regclass,
+								   IN sample_blocks int4 default 1024,
+								   OUT name text,
+								   OUT setting float8,
+								   OUT proposed float8,
+								   OUT command text)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_calibrate_costs'
+LANGUAGE C STRICT VOLATILE PARALLEL RESTRICTED;
+
+-- The measurements can take a while and disturb the buffer cache.
+REVOKE ALL ON FUNCTION pg_calibrate_costs(regclass, int4) FROM PUBLIC;
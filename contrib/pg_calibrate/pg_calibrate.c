@@ -0,0 +1,421 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_calibrate.c
+ *		  measure planner cost parameters on the local machine
+ *
+ * The planner's cost parameters are all relative to the cost of fetching
+ * one page sequentially.  We time reads of a sample of a relation's blocks
+ * through the buffer manager, both in random order and sequentially, then
+ * a scan over the tuples on the sequentially read blocks, then a large
+ * number of calls to a cheap operator function.  The proposed parameter
+ * values have the same ratios to each other as the measured times.
+ *
+ * Copyright (c) 2010-2019, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		  contrib/pg_calibrate/pg_calibrate.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/heapam.h"
+#include "access/relation.h"
+#include "access/tableam.h"
+#include "catalog/pg_am.h"
+#include "catalog/pg_class.h"
+#include "commands/tablespace.h"
+#include "executor/instrument.h"
+#include "executor/tuptable.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "optimizer/optimizer.h"
+#include "portability/instr_time.h"
+#include "storage/bufmgr.h"
+#include "utils/acl.h"
+#include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+#include "utils/sampling.h"
+#include "utils/snapmgr.h"
+#include "utils/spccache.h"
+#include "utils/tuplestore.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(pg_calibrate_costs);
+
+/* Number of operator function calls to time */
+#define CALIBRATE_OPERATOR_CALLS	4000000
+
+static double time_block_reads(Relation rel, BufferAccessStrategy strategy,
+							   BlockNumber *blocks, int nblocks);
+static double time_tuple_scan(Relation rel, BlockNumber startblk,
+							  BlockNumber nblocks, int64 *ntuples);
+static double time_operator_calls(int ncalls);
+static void add_result(Tuplestorestate *tupstore, TupleDesc tupdesc,
+					   const char *name, double setting, double proposed,
+					   char *command);
+
+/*
+ * pg_calibrate_costs(rel regclass, sample_blocks int4)
+ *
+ * Measure the relative costs of page fetches, tuple processing and operator
+ * evaluation using up to sample_blocks blocks of each half of the given
+ * table, and return one row per cost parameter with its current setting,
+ * the proposed value, and a command that would apply the proposal.
+ *
+ * If the table is in the database's default tablespace, the page costs
+ * measured there define the cost unit: we propose random_page_cost and the
+ * CPU cost parameters relative to the seq_page_cost currently in effect for
+ * that tablespace.  Otherwise, since the CPU costs don't depend on the
+ * tablespace, we use the current cpu_tuple_cost as the yardstick and propose
+ * per-tablespace seq_page_cost and random_page_cost settings.  So the
+ * default tablespace should be calibrated first.
+ *
+ * Blocks that are already cached, whether in shared buffers or by the
+ * kernel, are read much faster than blocks that must come from storage, so
+ * the page costs reflect the cache state at the time of the call.  We warn
+ * if most of the sampled blocks were found in shared buffers, but can't
+ * detect kernel caching.
+ */
+Datum
+pg_calibrate_costs(PG_FUNCTION_ARGS)
+{
+	Oid			relOid = PG_GETARG_OID(0);
+	int32		sample_blocks = PG_GETARG_INT32(1);
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	Relation	rel;
+	AclResult	aclresult;
+	Oid			spcid;
+	BlockNumber nblocks;
+	BlockNumber half;
+	int			nsample;
+	BlockNumber *blocks;
+	BlockSamplerData bs;
+	BufferAccessStrategy strategy;
+	long		hits_before;
+	long		hits;
+	int			i;
+	int64		ntuples;
+	double		random_time;
+	double		seq_time;
+	double		tuple_time;
+	double		operator_time;
+	double		random_page;
+	double		seq_page;
+	double		tuple;
+	double		oper;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	if (sample_blocks <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("sample_blocks must be greater than zero")));
+
+	/* Open relation and check privileges. */
+	rel = relation_open(relOid, AccessShareLock);
+	aclresult = pg_class_aclcheck(relOid, GetUserId(), ACL_SELECT);
+	if (aclresult != ACLCHECK_OK)
+		aclcheck_error(aclresult, get_relkind_objtype(rel->rd_rel->relkind),
+					   RelationGetRelationName(rel));
+
+	if ((rel->rd_rel->relkind != RELKIND_RELATION &&
+		 rel->rd_rel->relkind != RELKIND_MATVIEW) ||
+		rel->rd_rel->relam != HEAP_TABLE_AM_OID)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("\"%s\" is not a heap table or materialized view",
+						RelationGetRelationName(rel))));
+
+	/*
+	 * Random reads use the first half of the table and sequential reads the
+	 * second half, so that neither test reads blocks the other just cached.
+	 */
+	nblocks = RelationGetNumberOfBlocks(rel);
+	half = nblocks / 2;
+	if (half == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("relation \"%s\" is too small to calibrate with",
+						RelationGetRelationName(rel)),
+				 errdetail("At least two blocks are needed.")));
+	nsample = Min((BlockNumber) sample_blocks, half);
+
+	strategy = GetAccessStrategy(BAS_BULKREAD);
+	hits_before = pgBufferUsage.shared_blks_hit;
+
+	/* Pick distinct blocks from the first half, and shuffle them. */
+	blocks = (BlockNumber *) palloc(nsample * sizeof(BlockNumber));
+	BlockSampler_Init(&bs, half, nsample, random());
+	for (i = 0; BlockSampler_HasMore(&bs); i++)
+		blocks[i] = BlockSampler_Next(&bs);
+	Assert(i == nsample);
+	for (i = nsample - 1; i > 0; i--)
+	{
+		int			j = random() % (i + 1);
+		BlockNumber tmp = blocks[i];
+
+		blocks[i] = blocks[j];
+		blocks[j] = tmp;
+	}
+	random_time = time_block_reads(rel, strategy, blocks, nsample);
+
+	for (i = 0; i < nsample; i++)
+		blocks[i] = half + i;
+	seq_time = time_block_reads(rel, strategy, blocks, nsample);
+
+	hits = pgBufferUsage.shared_blks_hit - hits_before;
+	if (hits > nsample)
+		ereport(WARNING,
+				(errmsg("%ld of the %d sampled blocks were found in shared buffers",
+						hits, 2 * nsample),
+				 errhint("The proposed page costs describe cached reads.  Use a table much larger than memory to measure storage.")));
+
+	tuple_time = time_tuple_scan(rel, half, nsample, &ntuples);
+	if (ntuples == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("no visible tuples found in the sampled blocks of relation \"%s\"",
+						RelationGetRelationName(rel))));
+
+	operator_time = time_operator_calls(CALIBRATE_OPERATOR_CALLS);
+
+	if (seq_time <= 0 || tuple_time <= 0 || operator_time <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("sampled operations completed too quickly to be timed"),
+				 errhint("Use a larger sample.")));
+
+	random_page = random_time / nsample;
+	seq_page = seq_time / nsample;
+	tuple = tuple_time / ntuples;
+	oper = operator_time / CALIBRATE_OPERATOR_CALLS;
+
+	elog(DEBUG1, "pg_calibrate_costs: random page %.3f us, sequential page %.3f us, tuple %.4f us, operator %.4f us",
+		 random_page * 1e6, seq_page * 1e6, tuple * 1e6, oper * 1e6);
+
+	spcid = rel->rd_rel->reltablespace;
+
+	FreeAccessStrategy(strategy);
+	relation_close(rel, AccessShareLock);
+
+	/* Switch into long-lived context to construct returned data structures */
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (!OidIsValid(spcid))
+	{
+		double		spc_seq_page_cost;
+		double		unit;
+		double		proposed_tuple;
+		double		proposed;
+
+		/* the default tablespace may have its own seq_page_cost setting */
+		get_tablespace_page_costs(MyDatabaseTableSpace, NULL,
+								  &spc_seq_page_cost);
+		unit = spc_seq_page_cost / seq_page;
+		proposed_tuple = tuple * unit;
+
+		proposed = random_page * unit;
+		add_result(tupstore, tupdesc, "random_page_cost",
+				   random_page_cost, proposed,
+				   psprintf("ALTER SYSTEM SET random_page_cost = %g",
+							proposed));
+
+		add_result(tupstore, tupdesc, "cpu_tuple_cost",
+				   cpu_tuple_cost, proposed_tuple,
+				   psprintf("ALTER SYSTEM SET cpu_tuple_cost = %g",
+							proposed_tuple));
+
+		/*
+		 * Processing an index tuple isn't measured separately; keep its
+		 * current ratio to the cost of processing a heap tuple.
+		 */
+		proposed = cpu_index_tuple_cost * proposed_tuple / cpu_tuple_cost;
+		add_result(tupstore, tupdesc, "cpu_index_tuple_cost",
+				   cpu_index_tuple_cost, proposed,
+				   psprintf("ALTER SYSTEM SET cpu_index_tuple_cost = %g",
+							proposed));
+
+		proposed = oper * unit;
+		add_result(tupstore, tupdesc, "cpu_operator_cost",
+				   cpu_operator_cost, proposed,
+				   psprintf("ALTER SYSTEM SET cpu_operator_cost = %g",
+							proposed));
+	}
+	else
+	{
+		double		unit = cpu_tuple_cost / tuple;
+		const char *spcname = quote_identifier(get_tablespace_name(spcid));
+		double		spc_random_page_cost;
+		double		spc_seq_page_cost;
+		double		proposed;
+
+		get_tablespace_page_costs(spcid, &spc_random_page_cost,
+								  &spc_seq_page_cost);
+
+		proposed = seq_page * unit;
+		add_result(tupstore, tupdesc, "seq_page_cost",
+				   spc_seq_page_cost, proposed,
+				   psprintf("ALTER TABLESPACE %s SET (seq_page_cost = %g)",
+							spcname, proposed));
+
+		proposed = random_page * unit;
+		add_result(tupstore, tupdesc, "random_page_cost",
+				   spc_random_page_cost, proposed,
+				   psprintf("ALTER TABLESPACE %s SET (random_page_cost = %g)",
+							spcname, proposed));
+	}
+
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
+
+/*
+ * Read the given blocks into shared buffers in the given order, and return
+ * the elapsed time in seconds.
+ */
+static double
+time_block_reads(Relation rel, BufferAccessStrategy strategy,
+				 BlockNumber *blocks, int nblocks)
+{
+	instr_time	starttime;
+	instr_time	duration;
+	int			i;
+
+	INSTR_TIME_SET_CURRENT(starttime);
+	for (i = 0; i < nblocks; i++)
+	{
+		Buffer		buf;
+
+		CHECK_FOR_INTERRUPTS();
+		buf = ReadBufferExtended(rel, MAIN_FORKNUM, blocks[i], RBM_NORMAL,
+								 strategy);
+		ReleaseBuffer(buf);
+	}
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, starttime);
+
+	return INSTR_TIME_GET_DOUBLE(duration);
+}
+
+/*
+ * Scan the visible tuples in the given range of blocks, and return the
+ * elapsed time in seconds.  The blocks are scanned once first so that the
+ * timed scan doesn't include I/O, which was measured separately.
+ */
+static double
+time_tuple_scan(Relation rel, BlockNumber startblk, BlockNumber nblocks,
+				int64 *ntuples)
+{
+	instr_time	starttime;
+	instr_time	duration;
+	int			pass;
+
+	for (pass = 0; pass < 2; pass++)
+	{
+		TableScanDesc scan;
+		TupleTableSlot *slot;
+
+		scan = table_beginscan_strat(rel, GetActiveSnapshot(), 0, NULL,
+									 false, false);
+		heap_setscanlimits(scan, startblk, nblocks);
+		slot = table_slot_create(rel, NULL);
+
+		*ntuples = 0;
+		INSTR_TIME_SET_CURRENT(starttime);
+		while (table_scan_getnextslot(scan, ForwardScanDirection, slot))
+		{
+			CHECK_FOR_INTERRUPTS();
+			(*ntuples)++;
+		}
+		INSTR_TIME_SET_CURRENT(duration);
+		INSTR_TIME_SUBTRACT(duration, starttime);
+
+		ExecDropSingleTupleTableSlot(slot);
+		table_endscan(scan);
+	}
+
+	return INSTR_TIME_GET_DOUBLE(duration);
+}
+
+/*
+ * Call a cheap operator function (int4eq) the given number of times through
+ * the function manager, as expression evaluation would, and return the
+ * elapsed time in seconds.
+ */
+static double
+time_operator_calls(int ncalls)
+{
+	FmgrInfo	flinfo;
+	instr_time	starttime;
+	instr_time	duration;
+	int			nmatches = 0;
+	int			i;
+
+	fmgr_info(F_INT4EQ, &flinfo);
+
+	INSTR_TIME_SET_CURRENT(starttime);
+	for (i = 0; i < ncalls; i++)
+	{
+		if ((i & 0xFFFF) == 0)
+			CHECK_FOR_INTERRUPTS();
+		if (DatumGetBool(FunctionCall2(&flinfo, Int32GetDatum(i),
+									   Int32GetDatum(ncalls))))
+			nmatches++;
+	}
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, starttime);
+
+	Assert(nmatches == 0);
+
+	return INSTR_TIME_GET_DOUBLE(duration);
+}
+
+/*
+ * Add one row to the result.
+ */
+static void
+add_result(Tuplestorestate *tupstore, TupleDesc tupdesc, const char *name,
+		   double setting, double proposed, char *command)
+{
+	Datum		values[4];
+	bool		nulls[4];
+
+	memset(nulls, 0, sizeof(nulls));
+	values[0] = CStringGetTextDatum(name);
+	values[1] = Float8GetDatum(setting);
+	values[2] = Float8GetDatum(proposed);
+	values[3] = CStringGetTextDatum(command);
+
+	tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+}
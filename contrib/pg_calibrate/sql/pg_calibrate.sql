@@ -0,0 +1,24 @@
+CREATE EXTENSION pg_calibrate;
+
+CREATE TABLE calib (a int, b text);
+INSERT INTO calib SELECT g, repeat('x', 50) FROM generate_series(1, 5000) g;
+
+-- The measurements depend on the machine, so only check the shape of the
+-- result.  The table is freshly loaded, so expect a warning about cached
+-- blocks, which we suppress.
+SET client_min_messages = error;
+SELECT name, proposed > 0 AS positive,
+	   command LIKE 'ALTER SYSTEM SET ' || name || ' = %' AS command_ok
+  FROM pg_calibrate_costs('calib', 16)
+ ORDER BY name;
+RESET client_min_messages;
+
+-- Error cases
+SELECT * FROM pg_calibrate_costs('calib', 0);
+CREATE TABLE calib_small (a int);
+SELECT * FROM pg_calibrate_costs('calib_small');
+CREATE VIEW calib_view AS SELECT * FROM calib;
+SELECT * FROM pg_calibrate_costs('calib_view');
+
+DROP VIEW calib_view;
+DROP TABLE calib, calib_small;
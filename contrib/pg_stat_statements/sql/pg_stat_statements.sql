@@ -253,10 +253,32 @@ SELECT query, calls, rows FROM pg_stat_statements ORDER BY query COLLATE "C";
 SELECT pg_stat_statements_reset(0,0,0);
 SELECT query, calls, rows FROM pg_stat_statements ORDER BY query COLLATE "C";
 
+--
+-- JIT counters
+--
+SELECT jit_functions >= 0 AND jit_generation_time >= 0 AND
+       jit_inlining_count >= 0 AND jit_inlining_time >= 0 AND
+       jit_optimization_count >= 0 AND jit_optimization_time >= 0 AND
+       jit_emission_count >= 0 AND jit_emission_time >= 0 AND
+       jit_cache_hits >= 0 AS jit_counters_ok
+  FROM pg_stat_statements WHERE query = 'SELECT pg_stat_statements_reset(0,0,0)';
+
 --
 -- cleanup
 --
 DROP ROLE regress_stats_user1;
 DROP ROLE regress_stats_user2;
 
+--
+-- update from 1.7, which doesn't have the JIT counters
+--
+DROP EXTENSION pg_stat_statements;
+CREATE EXTENSION pg_stat_statements VERSION '1.7';
+SELECT count(*) FROM pg_attribute
+  WHERE attrelid = 'pg_stat_statements'::regclass AND attname LIKE 'jit%';
+ALTER EXTENSION pg_stat_statements UPDATE TO '1.8';
+SELECT count(*) > 0 AS has_rows,
+       bool_and(jit_functions >= 0 AND jit_cache_hits >= 0) AS jit_counters_ok
+  FROM pg_stat_statements;
+
 DROP EXTENSION pg_stat_statements;
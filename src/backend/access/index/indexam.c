@@ -20,6 +20,7 @@
  *		index_insert	- insert an index tuple into a relation
  *		index_markpos	- mark a scan position
  *		index_restrpos	- restore a scan position
+ *		index_set_prefetch - read ahead in the index to prefetch heap pages
  *		index_parallelscan_estimate - estimate shared memory for parallel scan
  *		index_parallelscan_initialize - initialize parallel scan
  *		index_parallelrescan  - (re)start a parallel scan of an index
@@ -58,6 +59,29 @@
 #include "utils/snapmgr.h"
 
 
+/*
+ * State of a scan that reads ahead in the index, see index_set_prefetch().
+ * TIDs returned by the index AM, along with their recheck flags, are queued
+ * in a circular buffer until the caller asks for them.
+ */
+typedef struct IndexPrefetchEntry
+{
+	ItemPointerData tid;
+	bool		recheck;
+} IndexPrefetchEntry;
+
+typedef struct IndexPrefetchData
+{
+	int			maximum;		/* maximum read-ahead distance, in TIDs */
+	int			target;			/* current read-ahead distance */
+	int			head;			/* index of the next entry to return */
+	int			count;			/* number of queued entries */
+	bool		exhausted;		/* has amgettuple returned false? */
+	BlockNumber last_block;		/* block prefetched last */
+	IndexPrefetchEntry queue[FLEXIBLE_ARRAY_MEMBER];
+} IndexPrefetchData;
+
+
 /* ----------------------------------------------------------------
  *					macros used in index_ routines
  *
@@ -98,6 +122,9 @@ do { \
 			 CppAsString(pname), RelationGetRelationName(scan->indexRelation)); \
 } while(0)
 
+static ItemPointer index_prefetch_getnext_tid(IndexScanDesc scan,
+											  ScanDirection direction);
+static void index_prefetch_reset(IndexScanDesc scan);
 static IndexScanDesc index_beginscan_internal(Relation indexRelation,
 											  int nkeys, int norderbys, Snapshot snapshot,
 											  ParallelIndexScanDesc pscan, bool temp_snap);
@@ -303,6 +330,9 @@ index_rescan(IndexScanDesc scan,
 	scan->kill_prior_tuple = false; /* for safety */
 	scan->xs_heap_continue = false;
 
+	if (scan->xs_prefetch)
+		index_prefetch_reset(scan);
+
 	scan->indexRelation->rd_indam->amrescan(scan, keys, nkeys,
 											orderbys, norderbys);
 }
@@ -333,6 +363,9 @@ index_endscan(IndexScanDesc scan)
 	if (scan->xs_temp_snap)
 		UnregisterSnapshot(scan->xs_snapshot);
 
+	if (scan->xs_prefetch)
+		pfree(scan->xs_prefetch);
+
 	/* Release the scan data structure itself */
 	IndexScanEnd(scan);
 }
@@ -347,6 +380,9 @@ index_markpos(IndexScanDesc scan)
 	SCAN_CHECKS;
 	CHECK_SCAN_PROCEDURE(ammarkpos);
 
+	/* the AM's position would be ahead of what was returned */
+	Assert(scan->xs_prefetch == NULL);
+
 	scan->indexRelation->rd_indam->ammarkpos(scan);
 }
 
@@ -383,6 +419,62 @@ index_restrpos(IndexScanDesc scan)
 	scan->indexRelation->rd_indam->amrestrpos(scan);
 }
 
+/* ----------------
+ *		index_set_prefetch - read ahead in the index to prefetch heap pages
+ *
+ * Heap tuples are otherwise fetched in index order, each one only after the
+ * index AM returned its TID, so that a scan over an uncorrelated index waits
+ * for one random read at a time.  After calling this, index_getnext_tid()
+ * keeps up to maximum TIDs obtained from the index AM queued ahead of the
+ * one it returns, and issues prefetch requests for the heap blocks they
+ * point to, so that the kernel can read them concurrently.  The TIDs are
+ * still returned in index order.  The read-ahead distance starts small and
+ * grows as the scan proceeds, so that scans that stop early, e.g. due to a
+ * LIMIT or as the inner side of a nested loop, don't read far ahead.
+ *
+ * The caller must only scan forward in one direction and must not use
+ * mark/restore, as the index AM's position is ahead of the returned TIDs.
+ * For the same reason, index-only scans can't use this, and the index AM
+ * isn't told about dead tuples (see kill_prior_tuple) while reading ahead.
+ * Must be called before the first index_getnext_tid() call.
+ * ----------------
+ */
+void
+index_set_prefetch(IndexScanDesc scan, int maximum)
+{
+	IndexPrefetchData *prefetch;
+
+	SCAN_CHECKS;
+	Assert(scan->heapRelation != NULL);
+	Assert(!scan->xs_want_itup);
+	Assert(scan->xs_prefetch == NULL);
+
+	if (maximum <= 0)
+		return;
+
+	prefetch = palloc(offsetof(IndexPrefetchData, queue) +
+					  sizeof(IndexPrefetchEntry) * maximum);
+	prefetch->maximum = maximum;
+	scan->xs_prefetch = prefetch;
+
+	index_prefetch_reset(scan);
+}
+
+/*
+ * Forget about queued TIDs, and start reading ahead slowly again.
+ */
+static void
+index_prefetch_reset(IndexScanDesc scan)
+{
+	IndexPrefetchData *prefetch = scan->xs_prefetch;
+
+	prefetch->target = 1;
+	prefetch->head = 0;
+	prefetch->count = 0;
+	prefetch->exhausted = false;
+	prefetch->last_block = InvalidBlockNumber;
+}
+
 /*
  * index_parallelscan_estimate - estimate shared memory for parallel scan
  *
@@ -515,6 +607,9 @@ index_getnext_tid(IndexScanDesc scan, ScanDirection direction)
 
 	Assert(TransactionIdIsValid(RecentGlobalXmin));
 
+	if (scan->xs_prefetch)
+		return index_prefetch_getnext_tid(scan, direction);
+
 	/*
 	 * The AM's amgettuple proc finds the next index entry matching the scan
 	 * keys, and puts the TID into scan->xs_heaptid.  It should also set
@@ -544,6 +639,81 @@ index_getnext_tid(IndexScanDesc scan, ScanDirection direction)
 	return &scan->xs_heaptid;
 }
 
+/*
+ * index_getnext_tid() for scans reading ahead in the index.
+ *
+ * Top up the queue of TIDs to the current read-ahead distance, prefetching
+ * the heap block of each new TID, and return the oldest queued TID.
+ */
+static ItemPointer
+index_prefetch_getnext_tid(IndexScanDesc scan, ScanDirection direction)
+{
+	IndexPrefetchData *prefetch = scan->xs_prefetch;
+	IndexPrefetchEntry *entry;
+
+	while (!prefetch->exhausted && prefetch->count < prefetch->target)
+	{
+		BlockNumber block;
+
+		/*
+		 * The AM's current item isn't the one the caller found dead, so
+		 * don't let it kill anything.
+		 */
+		scan->kill_prior_tuple = false;
+
+		if (!scan->indexRelation->rd_indam->amgettuple(scan, direction))
+		{
+			prefetch->exhausted = true;
+			break;
+		}
+		Assert(ItemPointerIsValid(&scan->xs_heaptid));
+
+		pgstat_count_index_tuples(scan->indexRelation, 1);
+
+		entry = &prefetch->queue[(prefetch->head + prefetch->count) %
+								 prefetch->maximum];
+		entry->tid = scan->xs_heaptid;
+		entry->recheck = scan->xs_recheck;
+		prefetch->count++;
+
+		/* consecutive TIDs often point to the same block */
+		block = ItemPointerGetBlockNumber(&scan->xs_heaptid);
+		if (block != prefetch->last_block)
+		{
+#ifdef USE_PREFETCH
+			PrefetchBuffer(scan->heapRelation, MAIN_FORKNUM, block);
+#endif
+			prefetch->last_block = block;
+		}
+	}
+
+	scan->kill_prior_tuple = false;
+	scan->xs_heap_continue = false;
+
+	/* If we're out of index entries, we're done */
+	if (prefetch->count == 0)
+	{
+		/* release resources (like buffer pins) from table accesses */
+		if (scan->xs_heapfetch)
+			table_index_fetch_reset(scan->xs_heapfetch);
+
+		return NULL;
+	}
+
+	entry = &prefetch->queue[prefetch->head];
+	scan->xs_heaptid = entry->tid;
+	scan->xs_recheck = entry->recheck;
+	prefetch->head = (prefetch->head + 1) % prefetch->maximum;
+	prefetch->count--;
+
+	/* read further ahead the longer the scan goes on */
+	if (prefetch->target < prefetch->maximum)
+		prefetch->target = Min(prefetch->target * 2, prefetch->maximum);
+
+	/* Return the TID of the tuple we found. */
+	return &scan->xs_heaptid;
+}
+
 /* ----------------
  *		index_fetch_heap - get the scan's next heap tuple
  *
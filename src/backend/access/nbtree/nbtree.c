@@ -122,6 +122,7 @@ bthandler(PG_FUNCTION_ARGS)
 	amroutine->amclusterable = true;
 	amroutine->ampredlocks = true;
 	amroutine->amcanparallel = true;
+	amroutine->amcanbuildparallel = true;
 	amroutine->amcaninclude = true;
 	amroutine->amkeytype = InvalidOid;
 
@@ -235,7 +236,18 @@ btgettuple(IndexScanDesc scan, ScanDirection dir)
 		_bt_start_array_keys(scan, dir);
 	}
 
-	/* This loop handles advancing to the next array elements, if any */
+	/* Likewise, find the first value of the first column for a skip scan */
+	if (so->skipKey && !BTScanPosIsValid(so->currPos))
+	{
+		_bt_start_skip_key(scan);
+		if (!_bt_advance_skip_key(scan, dir))
+			return false;
+	}
+
+	/*
+	 * This loop handles advancing to the next array elements, or the next
+	 * value of the first column in a skip scan, if any
+	 */
 	do
 	{
 		/*
@@ -278,7 +290,8 @@ btgettuple(IndexScanDesc scan, ScanDirection dir)
 		if (res)
 			break;
 		/* ... otherwise see if we have more array keys to deal with */
-	} while (so->numArrayKeys && _bt_advance_array_keys(scan, dir));
+	} while ((so->numArrayKeys && _bt_advance_array_keys(scan, dir)) ||
+			 (so->skipKey && _bt_advance_skip_key(scan, dir)));
 
 	return res;
 }
@@ -304,8 +317,17 @@ btgetbitmap(IndexScanDesc scan, TIDBitmap *tbm)
 
 		_bt_start_array_keys(scan, ForwardScanDirection);
 	}
+	else if (so->skipKey)
+	{
+		_bt_start_skip_key(scan);
+		if (!_bt_advance_skip_key(scan, ForwardScanDirection))
+			return ntids;
+	}
 
-	/* This loop handles advancing to the next array elements, if any */
+	/*
+	 * This loop handles advancing to the next array elements, or the next
+	 * value of the first column in a skip scan, if any
+	 */
 	do
 	{
 		/* Fetch the first page & tuple */
@@ -336,7 +358,10 @@ btgetbitmap(IndexScanDesc scan, TIDBitmap *tbm)
 			}
 		}
 		/* Now see if we have more array keys to deal with */
-	} while (so->numArrayKeys && _bt_advance_array_keys(scan, ForwardScanDirection));
+	} while ((so->numArrayKeys &&
+			  _bt_advance_array_keys(scan, ForwardScanDirection)) ||
+			 (so->skipKey &&
+			  _bt_advance_skip_key(scan, ForwardScanDirection)));
 
 	return ntids;
 }
@@ -360,8 +385,10 @@ btbeginscan(Relation rel, int nkeys, int norderbys)
 	so = (BTScanOpaque) palloc(sizeof(BTScanOpaqueData));
 	BTScanPosInvalidate(so->currPos);
 	BTScanPosInvalidate(so->markPos);
+
+	/* Leave room for the implicit first-column key of a skip scan */
 	if (scan->numberOfKeys > 0)
-		so->keyData = (ScanKey) palloc(scan->numberOfKeys * sizeof(ScanKeyData));
+		so->keyData = (ScanKey) palloc((scan->numberOfKeys + 1) * sizeof(ScanKeyData));
 	else
 		so->keyData = NULL;
 
@@ -370,6 +397,9 @@ btbeginscan(Relation rel, int nkeys, int norderbys)
 	so->arrayKeys = NULL;
 	so->arrayContext = NULL;
 
+	so->skipKey = NULL;			/* decided in btrescan */
+	so->skipContext = NULL;
+
 	so->killedItems = NULL;		/* until needed */
 	so->numKilled = 0;
 
@@ -445,6 +475,9 @@ btrescan(IndexScanDesc scan, ScanKey scankey, int nscankeys,
 
 	/* If any keys are SK_SEARCHARRAY type, set up array-key info */
 	_bt_preprocess_array_keys(scan);
+
+	/* If there are no keys on the first column, set up for skipping */
+	_bt_preprocess_skip_key(scan);
 }
 
 /*
@@ -475,6 +508,9 @@ btendscan(IndexScanDesc scan)
 	/* so->arrayKeyData and so->arrayKeys are in arrayContext */
 	if (so->arrayContext != NULL)
 		MemoryContextDelete(so->arrayContext);
+	/* so->skipKey and its values are in skipContext */
+	if (so->skipContext != NULL)
+		MemoryContextDelete(so->skipContext);
 	if (so->killedItems != NULL)
 		pfree(so->killedItems);
 	if (so->currTuples != NULL)
@@ -511,6 +547,10 @@ btmarkpos(IndexScanDesc scan)
 	/* Also record the current positions of any array keys */
 	if (so->numArrayKeys)
 		_bt_mark_array_keys(scan);
+
+	/* ... and the current first column value of a skip scan */
+	if (so->skipKey)
+		_bt_mark_skip_key(scan);
 }
 
 /*
@@ -525,6 +565,10 @@ btrestrpos(IndexScanDesc scan)
 	if (so->numArrayKeys)
 		_bt_restore_array_keys(scan);
 
+	/* Likewise the first column value of a skip scan */
+	if (so->skipKey)
+		_bt_restore_skip_key(scan);
+
 	if (so->markItemIndex >= 0)
 	{
 		/*
@@ -66,6 +66,7 @@
 #include "access/xlog.h"
 #include "access/xloginsert.h"
 #include "catalog/index.h"
+#include "catalog/pg_control.h"
 #include "commands/progress.h"
 #include "miscadmin.h"
 #include "pgstat.h"
@@ -82,6 +83,12 @@
 #define PARALLEL_KEY_TUPLESORT_SPOOL2	UINT64CONST(0xA000000000000003)
 #define PARALLEL_KEY_QUERY_TEXT			UINT64CONST(0xA000000000000004)
 
+/*
+ * Number of completed pages to accumulate before WAL-logging them together,
+ * when the build is WAL-logged.
+ */
+#define BTREE_WAL_BATCH_PAGES	32
+
 /*
  * DISABLE_LEADER_PARTICIPATION disables the leader's participation in
  * parallel index builds.  This may be useful as a debugging aid.
@@ -269,6 +276,9 @@ typedef struct BTWriteState
 	BlockNumber btws_pages_alloced; /* # pages allocated */
 	BlockNumber btws_pages_written; /* # pages written out */
 	Page		btws_zeropage;	/* workspace for filling zeroes */
+	int			btws_npending;	/* # completed pages not yet WAL-logged */
+	Page		btws_pending[BTREE_WAL_BATCH_PAGES];
+	BlockNumber btws_pending_blkno[BTREE_WAL_BATCH_PAGES];
 } BTWriteState;
 
 
@@ -281,6 +291,10 @@ static void _bt_leafbuild(BTSpool *btspool, BTSpool *btspool2);
 static void _bt_build_callback(Relation index, HeapTuple htup, Datum *values,
 							   bool *isnull, bool tupleIsAlive, void *state);
 static Page _bt_blnewpage(uint32 level);
+static void _bt_blwritepage(BTWriteState *wstate, Page page, BlockNumber blkno);
+static void _bt_blflush(BTWriteState *wstate);
+static void _bt_blwritepage_smgr(BTWriteState *wstate, Page page,
+								 BlockNumber blkno);
 static BTPageState *_bt_pagestate(BTWriteState *wstate, uint32 level);
 static void _bt_slideleft(Page page);
 static void _bt_sortaddtup(Page page, Size itemsize,
@@ -583,6 +597,7 @@ _bt_leafbuild(BTSpool *btspool, BTSpool *btspool2)
 	wstate.btws_pages_alloced = BTREE_METAPAGE + 1;
 	wstate.btws_pages_written = 0;
 	wstate.btws_zeropage = NULL;	/* until needed */
+	wstate.btws_npending = 0;
 
 	pgstat_progress_update_param(PROGRESS_CREATEIDX_SUBPHASE,
 								 PROGRESS_BTREE_PHASE_LEAF_LOAD);
@@ -647,19 +662,79 @@ _bt_blnewpage(uint32 level)
 
 /*
  * emit a completed btree page, and release the working storage.
+ *
+ * If the build is WAL-logged, the page is only queued here; the queued pages
+ * are WAL-logged as one batch and written out by _bt_blflush().  The caller
+ * must not touch the page afterwards in either case.
  */
 static void
 _bt_blwritepage(BTWriteState *wstate, Page page, BlockNumber blkno)
 {
-	/* Ensure rd_smgr is open (could have been closed by relcache flush!) */
-	RelationOpenSmgr(wstate->index);
+	if (!wstate->btws_use_wal)
+	{
+		_bt_blwritepage_smgr(wstate, page, blkno);
+		return;
+	}
+
+	wstate->btws_pending[wstate->btws_npending] = page;
+	wstate->btws_pending_blkno[wstate->btws_npending] = blkno;
+	wstate->btws_npending++;
+
+	if (wstate->btws_npending == BTREE_WAL_BATCH_PAGES)
+		_bt_blflush(wstate);
+}
+
+/*
+ * WAL-log and write out all the pages queued by _bt_blwritepage().
+ *
+ * Each page gets its own full-page image record, as log_newpage() would
+ * emit, but all the records are inserted into the WAL at once.  A page must
+ * be WAL-logged before it is written out, so we write the pages only after
+ * the whole batch has been inserted.
+ */
+static void
+_bt_blflush(BTWriteState *wstate)
+{
+	int			i;
 
-	/* XLOG stuff */
-	if (wstate->btws_use_wal)
+	if (wstate->btws_npending == 0)
+		return;
+
+	XLogBeginBatch(wstate->btws_npending, wstate->btws_npending, 0);
+	for (i = 0; i < wstate->btws_npending; i++)
 	{
 		/* We use the heap NEWPAGE record type for this */
-		log_newpage(&wstate->index->rd_node, MAIN_FORKNUM, blkno, page, true);
+		XLogBeginInsert();
+		XLogRegisterBlock(0, &wstate->index->rd_node, MAIN_FORKNUM,
+						  wstate->btws_pending_blkno[i],
+						  wstate->btws_pending[i],
+						  REGBUF_FORCE_IMAGE | REGBUF_STANDARD);
+		(void) XLogBatchAdd(RM_XLOG_ID, XLOG_FPI);
 	}
+	(void) XLogInsertBatch();
+
+	for (i = 0; i < wstate->btws_npending; i++)
+	{
+		Page		page = wstate->btws_pending[i];
+
+		/* see log_newpage() */
+		if (!PageIsNew(page))
+			PageSetLSN(page, XLogBatchRecordEnd(i));
+
+		_bt_blwritepage_smgr(wstate, page, wstate->btws_pending_blkno[i]);
+	}
+
+	wstate->btws_npending = 0;
+}
+
+/*
+ * write a completed btree page to disk, and release the working storage.
+ */
+static void
+_bt_blwritepage_smgr(BTWriteState *wstate, Page page, BlockNumber blkno)
+{
+	/* Ensure rd_smgr is open (could have been closed by relcache flush!) */
+	RelationOpenSmgr(wstate->index);
 
 	/*
 	 * If we have to write pages nonsequentially, fill in the space with
@@ -1134,6 +1209,9 @@ _bt_uppershutdown(BTWriteState *wstate, BTPageState *state)
 	metapage = (Page) palloc(BLCKSZ);
 	_bt_initmetapage(metapage, rootblkno, rootlevel);
 	_bt_blwritepage(wstate, metapage, BTREE_METAPAGE);
+
+	/* WAL-log and write out whatever is still queued */
+	_bt_blflush(wstate);
 }
 
 /*
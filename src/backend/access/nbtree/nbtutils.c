@@ -29,6 +29,12 @@
 #include "utils/rel.h"
 
 
+/*
+ * A skip scan stops skipping once at least this many of the values found by
+ * probing, and more than half of them, shared a leaf page with the next one.
+ */
+#define BTREE_SKIP_MIN_DENSE	8
+
 typedef struct BTSortArrayContext
 {
 	FmgrInfo	flinfo;
@@ -46,6 +52,11 @@ static int	_bt_compare_array_elements(const void *a, const void *b, void *arg);
 static bool _bt_compare_scankey_args(IndexScanDesc scan, ScanKey op,
 									 ScanKey leftarg, ScanKey rightarg,
 									 bool *result);
+static void _bt_skip_set_value(BTSkipKeyInfo *skip, Datum value, bool isnull);
+static void _bt_skip_build_key(IndexScanDesc scan);
+static void _bt_skip_build_probe(IndexScanDesc scan, ScanDirection dir);
+static bool _bt_skip_probe(IndexScanDesc scan, ScanDirection dir,
+						   bool *dense);
 static bool _bt_fix_scankey_strategy(ScanKey skey, int16 *indoption);
 static void _bt_mark_scankey_required(ScanKey skey);
 static bool _bt_check_rowcompare(ScanKey skey,
@@ -655,12 +666,410 @@ _bt_restore_array_keys(IndexScanDesc scan)
 	}
 }
 
+/*
+ *	_bt_preprocess_skip_key() -- Decide whether to skip over leading values
+ *
+ * Without any keys on the first index column, the scan keys for the other
+ * columns can't be used to position the scan, and none of them are required
+ * to continue it, so a plain scan has to read the whole index.  If the first
+ * column has few distinct values, it's much cheaper to do a separate
+ * primitive index scan for each of them instead, adding an implicit "="
+ * key for the value: within each one the keys on the following columns
+ * then bound the scan.  The next value is found by descending the tree
+ * again for the first tuple beyond the current value ("probing").
+ *
+ * This sets up so->skipKey if the scan qualifies, which requires keys on the
+ * second column, since those are the ones that become usable.  Scans with
+ * array keys already run several primitive scans in their own order, and
+ * parallel scans hand out pages one at a time, so neither skips.  Which keys
+ * are present, and on which columns, can't change across rescans; so the
+ * decision, and the operator lookups, are made the first time through only.
+ */
+void
+_bt_preprocess_skip_key(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Relation	rel = scan->indexRelation;
+	BTSkipKeyInfo *skip;
+	MemoryContext oldContext;
+
+	if (so->skipKey == NULL)
+	{
+		Oid			opfamily = rel->rd_opfamily[0];
+		Oid			opcintype = rel->rd_opcintype[0];
+		Form_pg_attribute attr = TupleDescAttr(RelationGetDescr(rel), 0);
+		int			strat;
+
+		if (scan->numberOfKeys == 0 ||
+			scan->keyData[0].sk_attno != 2 ||
+			so->numArrayKeys != 0 ||
+			scan->parallel_scan != NULL)
+			return;
+
+		so->skipContext = AllocSetContextCreate(CurrentMemoryContext,
+												"BTree skip context",
+												ALLOCSET_SMALL_SIZES);
+		oldContext = MemoryContextSwitchTo(so->skipContext);
+
+		skip = (BTSkipKeyInfo *) palloc0(sizeof(BTSkipKeyInfo));
+		for (strat = 1; strat <= BTMaxStrategyNumber; strat++)
+		{
+			Oid			opr;
+
+			opr = get_opfamily_member(opfamily, opcintype, opcintype, strat);
+			if (!OidIsValid(opr))
+				elog(ERROR, "missing operator %d(%u,%u) in opfamily %u",
+					 strat, opcintype, opcintype, opfamily);
+			ScanKeyEntryInitialize(&skip->opKeys[strat - 1],
+								   0,
+								   1,
+								   strat,
+								   InvalidOid,
+								   rel->rd_indcollation[0],
+								   get_opcode(opr),
+								   (Datum) 0);
+		}
+		skip->attlen = attr->attlen;
+		skip->attbyval = attr->attbyval;
+		skip->keyData = (ScanKey)
+			palloc((scan->numberOfKeys + 1) * sizeof(ScanKeyData));
+
+		MemoryContextSwitchTo(oldContext);
+
+		/* The probes need the index tuples of the page they read */
+		if (so->currTuples == NULL)
+		{
+			so->currTuples = (char *) palloc(BLCKSZ * 2);
+			so->markTuples = so->currTuples + BLCKSZ;
+		}
+
+		so->skipKey = skip;
+	}
+	skip = so->skipKey;
+
+	/* Forget the values of the previous scan */
+	if (!skip->attbyval && skip->markMode != BTSKIP_START &&
+		!skip->markIsNull && skip->markValue != skip->value)
+		pfree(DatumGetPointer(skip->markValue));
+	skip->markMode = BTSKIP_START;
+	skip->markValue = (Datum) 0;
+	skip->markIsNull = true;
+	_bt_start_skip_key(scan);
+	skip->numPrefixes = 0;
+	skip->numDense = 0;
+
+	/* Copy the scan keys, after the slot for the implicit key */
+	memcpy(skip->keyData + 1, scan->keyData,
+		   scan->numberOfKeys * sizeof(ScanKeyData));
+	skip->numKeys = 0;
+}
+
+/*
+ * _bt_start_skip_key() -- Reset a skip scan to before its first value
+ *
+ * The first value itself is found by _bt_advance_skip_key(), once the scan
+ * direction is known.
+ */
+void
+_bt_start_skip_key(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTSkipKeyInfo *skip = so->skipKey;
+
+	_bt_skip_set_value(skip, (Datum) 0, true);
+	skip->mode = BTSKIP_START;
+}
+
+/*
+ * _bt_advance_skip_key() -- Advance to the next value of the first column
+ *
+ * Returns true if there is another value to scan for, false if not.  On
+ * true result, the implicit key is set up for the next primitive scan.
+ *
+ * NULLs are treated as one more value, that sorts before or after all the
+ * others according to the index's NULLS FIRST/LAST option.
+ *
+ * Each value costs two descents of the tree: one to find it, and one to find
+ * the first tuple matching the other keys.  That's only worthwhile if a
+ * value spans several leaf pages.  The probe that finds a value reads the
+ * leaf page it's on, so it can see whether the next value is on the same
+ * page; if that's the case for most values found, we stop skipping and scan
+ * the rest of the index normally, from the value just found.
+ */
+bool
+_bt_advance_skip_key(IndexScanDesc scan, ScanDirection dir)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTSkipKeyInfo *skip = so->skipKey;
+	int16	   *indoption = scan->indexRelation->rd_indoption;
+	bool		nullsahead;
+	bool		dense;
+
+	/* Do NULLs come after all the other values in this scan direction? */
+	nullsahead = ((indoption[0] & INDOPTION_NULLS_FIRST) != 0) ==
+		ScanDirectionIsBackward(dir);
+
+	switch (skip->mode)
+	{
+		case BTSKIP_START:
+			/* probe for the very first tuple */
+			skip->numKeys = 0;
+			break;
+		case BTSKIP_PREFIX:
+			if (skip->isnull && nullsahead)
+				return false;	/* NULLs were last, we're done */
+			_bt_skip_build_probe(scan, dir);
+			break;
+		case BTSKIP_REST:
+			/* The rest of the non-NULL values have been scanned */
+			if (dir == skip->restDir)
+				goto nulls;
+			_bt_skip_build_probe(scan, dir);
+			break;
+	}
+
+	if (!_bt_skip_probe(scan, dir, &dense))
+		goto nulls;
+
+	skip->numPrefixes++;
+	if (dense)
+		skip->numDense++;
+
+	if (!skip->isnull &&
+		skip->numDense >= BTREE_SKIP_MIN_DENSE &&
+		skip->numDense * 2 > skip->numPrefixes)
+	{
+		skip->mode = BTSKIP_REST;
+		skip->restDir = dir;
+	}
+	else
+		skip->mode = BTSKIP_PREFIX;
+	_bt_skip_build_key(scan);
+	return true;
+
+nulls:
+	/* Done with the non-NULL values; scan for the NULLs if they come last */
+	if (!nullsahead || skip->mode == BTSKIP_START ||
+		(skip->mode == BTSKIP_PREFIX && skip->isnull))
+		return false;
+	_bt_skip_set_value(skip, (Datum) 0, true);
+	skip->mode = BTSKIP_PREFIX;
+	_bt_skip_build_key(scan);
+	return true;
+}
+
+/*
+ * _bt_mark_skip_key() -- Handle a skip scan during btmarkpos
+ *
+ * Save the current value of the first column as the "mark" position.
+ */
+void
+_bt_mark_skip_key(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTSkipKeyInfo *skip = so->skipKey;
+
+	/* Release the old marked value, unless it's also the current one */
+	if (!skip->attbyval && skip->markMode != BTSKIP_START &&
+		!skip->markIsNull && skip->markValue != skip->value)
+		pfree(DatumGetPointer(skip->markValue));
+
+	skip->markMode = skip->mode;
+	skip->markValue = skip->value;
+	skip->markIsNull = skip->isnull;
+	skip->markRestDir = skip->restDir;
+}
+
+/*
+ * _bt_restore_skip_key() -- Handle a skip scan during btrestrpos
+ *
+ * Restore the first column value to what it was when the mark was set.
+ */
+void
+_bt_restore_skip_key(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTSkipKeyInfo *skip = so->skipKey;
+
+	if (skip->mode == skip->markMode &&
+		skip->value == skip->markValue &&
+		skip->isnull == skip->markIsNull &&
+		skip->restDir == skip->markRestDir)
+		return;
+
+	/* The marked value is shared with the current value from here on */
+	_bt_skip_set_value(skip, skip->markValue, skip->markIsNull);
+	skip->mode = skip->markMode;
+	skip->restDir = skip->markRestDir;
+
+	/* As with array keys, redo _bt_preprocess_keys for the restored key */
+	if (skip->mode != BTSKIP_START)
+	{
+		_bt_skip_build_key(scan);
+		_bt_preprocess_keys(scan);
+		Assert(so->qual_ok);
+	}
+}
+
+/*
+ * Replace the current value of a skip scan, freeing the old one unless it's
+ * still referenced by the mark.
+ */
+static void
+_bt_skip_set_value(BTSkipKeyInfo *skip, Datum value, bool isnull)
+{
+	if (!skip->attbyval && skip->mode != BTSKIP_START && !skip->isnull &&
+		skip->value != value &&
+		(skip->markMode == BTSKIP_START || skip->markIsNull ||
+		 skip->value != skip->markValue))
+		pfree(DatumGetPointer(skip->value));
+
+	skip->value = value;
+	skip->isnull = isnull;
+}
+
+/*
+ * Set up the implicit key for the current value of a skip scan, followed by
+ * the scan's own keys.
+ */
+static void
+_bt_skip_build_key(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTSkipKeyInfo *skip = so->skipKey;
+	ScanKey		skey = &skip->keyData[0];
+
+	Assert(skip->mode != BTSKIP_START);
+
+	if (skip->isnull)
+	{
+		Assert(skip->mode == BTSKIP_PREFIX);
+		ScanKeyEntryInitialize(skey,
+							   SK_ISNULL | SK_SEARCHNULL,
+							   1,
+							   InvalidStrategy,
+							   InvalidOid,
+							   InvalidOid,
+							   InvalidOid,
+							   (Datum) 0);
+	}
+	else
+	{
+		StrategyNumber strat;
+
+		if (skip->mode == BTSKIP_PREFIX)
+			strat = BTEqualStrategyNumber;
+		else if (ScanDirectionIsForward(skip->restDir) ==
+				 ((scan->indexRelation->rd_indoption[0] & INDOPTION_DESC) == 0))
+			strat = BTGreaterEqualStrategyNumber;
+		else
+			strat = BTLessEqualStrategyNumber;
+
+		memcpy(skey, &skip->opKeys[strat - 1], sizeof(ScanKeyData));
+		skey->sk_argument = skip->value;
+	}
+
+	skip->numKeys = scan->numberOfKeys + 1;
+}
+
+/*
+ * Set up the probe for the value following the current one in direction dir.
+ * That's the first non-NULL value if the current value is NULL.
+ */
+static void
+_bt_skip_build_probe(IndexScanDesc scan, ScanDirection dir)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTSkipKeyInfo *skip = so->skipKey;
+	ScanKey		skey = &skip->keyData[0];
+
+	if (skip->isnull)
+		ScanKeyEntryInitialize(skey,
+							   SK_ISNULL | SK_SEARCHNOTNULL,
+							   1,
+							   InvalidStrategy,
+							   InvalidOid,
+							   InvalidOid,
+							   InvalidOid,
+							   (Datum) 0);
+	else
+	{
+		StrategyNumber strat;
+
+		if (ScanDirectionIsForward(dir) ==
+			((scan->indexRelation->rd_indoption[0] & INDOPTION_DESC) == 0))
+			strat = BTGreaterStrategyNumber;
+		else
+			strat = BTLessStrategyNumber;
+
+		memcpy(skey, &skip->opKeys[strat - 1], sizeof(ScanKeyData));
+		skey->sk_argument = skip->value;
+	}
+
+	skip->numKeys = 1;
+}
+
+/*
+ * Run the probe set up in the skip scan's keys, and make the first column of
+ * the first tuple found the current value.  *dense is set if the leaf page
+ * the tuple is on also holds a following value.  Returns false if no tuple
+ * was found.
+ */
+static bool
+_bt_skip_probe(IndexScanDesc scan, ScanDirection dir, bool *dense)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTSkipKeyInfo *skip = so->skipKey;
+	ScanKey		eqkey = &skip->opKeys[BTEqualStrategyNumber - 1];
+	TupleDesc	itupdesc = RelationGetDescr(scan->indexRelation);
+	IndexTuple	itup;
+	int			lastIndex;
+	Datum		value;
+	bool		isnull;
+	Datum		lastvalue;
+	bool		lastisnull;
+	MemoryContext oldContext;
+
+	if (!_bt_first(scan, dir))
+		return false;
+
+	itup = (IndexTuple) (so->currTuples +
+						 so->currPos.items[so->currPos.itemIndex].tupleOffset);
+	value = index_getattr(itup, 1, itupdesc, &isnull);
+
+	/* Compare with the last tuple read from the page */
+	lastIndex = ScanDirectionIsForward(dir) ?
+		so->currPos.lastItem : so->currPos.firstItem;
+	itup = (IndexTuple) (so->currTuples +
+						 so->currPos.items[lastIndex].tupleOffset);
+	lastvalue = index_getattr(itup, 1, itupdesc, &lastisnull);
+	if (isnull || lastisnull)
+		*dense = (isnull != lastisnull);
+	else
+		*dense = !DatumGetBool(FunctionCall2Coll(&eqkey->sk_func,
+												 eqkey->sk_collation,
+												 value, lastvalue));
+
+	/* Keep a copy of the value, the tuple goes away with the position */
+	oldContext = MemoryContextSwitchTo(so->skipContext);
+	if (!isnull)
+		value = datumCopy(value, skip->attbyval, skip->attlen);
+	MemoryContextSwitchTo(oldContext);
+	_bt_skip_set_value(skip, value, isnull);
+
+	/* Release the position, the next primitive scan starts from scratch */
+	BTScanPosUnpinIfPinned(so->currPos);
+	BTScanPosInvalidate(so->currPos);
+
+	return true;
+}
+
 
 /*
  *	_bt_preprocess_keys() -- Preprocess scan keys
  *
- * The given search-type keys (in scan->keyData[] or so->arrayKeyData[])
- * are copied to so->keyData[] with possible transformation.
+ * The given search-type keys (in scan->keyData[], so->arrayKeyData[] or
+ * so->skipKey->keyData[]) are copied to so->keyData[] with possible transformation.
  * scan->numberOfKeys is the number of input keys, so->numberOfKeys gets
  * the number of output keys (possibly less, never greater).
  *
@@ -761,17 +1170,24 @@ _bt_preprocess_keys(IndexScanDesc scan)
 	so->qual_ok = true;
 	so->numberOfKeys = 0;
 
-	if (numberOfKeys < 1)
-		return;					/* done if qual-less scan */
-
 	/*
-	 * Read so->arrayKeyData if array keys are present, else scan->keyData
+	 * Read so->arrayKeyData if array keys are present, or the skip scan's
+	 * keys (which include the implicit key on the first column, if any) if
+	 * skipping, else scan->keyData
 	 */
 	if (so->arrayKeyData != NULL)
 		inkeys = so->arrayKeyData;
+	else if (so->skipKey != NULL)
+	{
+		inkeys = so->skipKey->keyData;
+		numberOfKeys = so->skipKey->numKeys;
+	}
 	else
 		inkeys = scan->keyData;
 
+	if (numberOfKeys < 1)
+		return;					/* done if qual-less scan */
+
 	outkeys = so->keyData;
 	cur = &inkeys[0];
 	/* we check that input keys are correctly ordered */
@@ -928,6 +928,9 @@ static void CopyXLogRecordToWAL(int write_len, bool isLogSwitch,
 								XLogRecPtr StartPos, XLogRecPtr EndPos);
 static void ReserveXLogInsertLocation(int size, XLogRecPtr *StartPos,
 									  XLogRecPtr *EndPos, XLogRecPtr *PrevPtr);
+static void ReserveXLogInsertLocationBatch(uint64 size, uint64 lastsize,
+										   uint64 *StartBytePos,
+										   uint64 *PrevBytePos);
 static bool ReserveXLogSwitch(XLogRecPtr *StartPos, XLogRecPtr *EndPos,
 							  XLogRecPtr *PrevPtr);
 static XLogRecPtr WaitXLogInsertionsToFinish(XLogRecPtr upto);
@@ -1229,6 +1232,147 @@ XLogInsertRecord(XLogRecData *rdata,
 	return EndPos;
 }
 
+/*
+ * Insert a batch of XLOG records with a single WAL insertion.
+ *
+ * This is like calling XLogInsertRecord() for each of the records in turn,
+ * except that the insertion lock is acquired only once and the WAL space for
+ * all of the records is reserved in one go, so the records end up
+ * consecutively in the WAL.  xloginsert.c uses this to implement
+ * XLogInsertBatch().
+ *
+ * Each rdatas[i] must be a single chunk holding the whole i'th record,
+ * header included, with the data MAXALIGNed.  XLOG_SWITCH records cannot be
+ * batched.  'fpw_lsn' is the oldest fpw_lsn of any of the records, and
+ * 'flags' should include XLOG_MARK_UNIMPORTANT only if all the records are
+ * unimportant.
+ *
+ * On success, the end position of each record is stored in EndPos[i], and
+ * the end of the last one is returned.  Like XLogInsertRecord(), returns
+ * InvalidXLogRecPtr without inserting anything if the records need to be
+ * reassembled with full-page images.
+ */
+XLogRecPtr
+XLogInsertRecordBatch(XLogRecData *rdatas, int nrecords,
+					  XLogRecPtr fpw_lsn, uint8 flags, XLogRecPtr *EndPos)
+{
+	XLogCtlInsert *Insert = &XLogCtl->Insert;
+	XLogRecPtr	StartPos = InvalidXLogRecPtr;
+	XLogRecPtr	PrevPtr;
+	uint64		size = 0;
+	uint64		lastsize = 0;
+	uint64		startbytepos;
+	uint64		prevbytepos;
+	uint64		bytepos;
+	bool		prevDoPageWrites = doPageWrites;
+	int			i;
+
+	Assert(nrecords > 0);
+
+	/* cross-check on whether we should be here or not */
+	if (!XLogInsertAllowed())
+		elog(ERROR, "cannot make new WAL entries during recovery");
+
+	for (i = 0; i < nrecords; i++)
+	{
+		XLogRecord *rechdr = (XLogRecord *) rdatas[i].data;
+
+		Assert(rdatas[i].next == NULL);
+		Assert(rdatas[i].len == rechdr->xl_tot_len);
+		Assert(!(rechdr->xl_rmid == RM_XLOG_ID &&
+				 (rechdr->xl_info & ~XLR_INFO_MASK) == XLOG_SWITCH));
+
+		lastsize = MAXALIGN(rechdr->xl_tot_len);
+		size += lastsize;
+	}
+
+	/* See XLogInsertRecord() for discussion of the steps below. */
+	START_CRIT_SECTION();
+	WALInsertLockAcquire();
+
+	if (RedoRecPtr != Insert->RedoRecPtr)
+	{
+		Assert(RedoRecPtr < Insert->RedoRecPtr);
+		RedoRecPtr = Insert->RedoRecPtr;
+	}
+	doPageWrites = (Insert->fullPageWrites || Insert->forcePageWrites);
+
+	if (doPageWrites &&
+		(!prevDoPageWrites ||
+		 (fpw_lsn != InvalidXLogRecPtr && fpw_lsn <= RedoRecPtr)))
+	{
+		WALInsertLockRelease();
+		END_CRIT_SECTION();
+		return InvalidXLogRecPtr;
+	}
+
+	ReserveXLogInsertLocationBatch(size, lastsize, &startbytepos, &prevbytepos);
+
+	/*
+	 * Now fill in the prev-links and CRCs, and copy each record into its
+	 * share of the reserved space.
+	 */
+	PrevPtr = XLogBytePosToRecPtr(prevbytepos);
+	bytepos = startbytepos;
+	for (i = 0; i < nrecords; i++)
+	{
+		XLogRecord *rechdr = (XLogRecord *) rdatas[i].data;
+		pg_crc32c	rdata_crc;
+
+		StartPos = XLogBytePosToRecPtr(bytepos);
+		bytepos += MAXALIGN(rechdr->xl_tot_len);
+		EndPos[i] = XLogBytePosToEndRecPtr(bytepos);
+
+		rechdr->xl_prev = PrevPtr;
+		PrevPtr = StartPos;
+
+		rdata_crc = rechdr->xl_crc;
+		COMP_CRC32C(rdata_crc, rechdr, offsetof(XLogRecord, xl_crc));
+		FIN_CRC32C(rdata_crc);
+		rechdr->xl_crc = rdata_crc;
+
+		CopyXLogRecordToWAL(rechdr->xl_tot_len, false, &rdatas[i],
+							StartPos, EndPos[i]);
+	}
+	Assert(bytepos == startbytepos + size);
+
+	if ((flags & XLOG_MARK_UNIMPORTANT) == 0)
+	{
+		int			lockno = holdingAllLocks ? 0 : MyLockNo;
+
+		WALInsertLocks[lockno].l.lastImportantAt = StartPos;
+	}
+
+	WALInsertLockRelease();
+
+	MarkCurrentTransactionIdLoggedIfAny();
+
+	END_CRIT_SECTION();
+
+	/*
+	 * Update shared LogwrtRqst.Write, if we crossed page boundary.
+	 */
+	if (XLogBytePosToRecPtr(startbytepos) / XLOG_BLCKSZ !=
+		EndPos[nrecords - 1] / XLOG_BLCKSZ)
+	{
+		SpinLockAcquire(&XLogCtl->info_lck);
+		/* advance global request to include new block(s) */
+		if (XLogCtl->LogwrtRqst.Write < EndPos[nrecords - 1])
+			XLogCtl->LogwrtRqst.Write = EndPos[nrecords - 1];
+		/* update local result copy while I have the chance */
+		LogwrtResult = XLogCtl->LogwrtResult;
+		SpinLockRelease(&XLogCtl->info_lck);
+	}
+
+	/*
+	 * Update our global variables
+	 */
+	ProcLastRecPtr = StartPos;
+	XactLastRecEnd = EndPos[nrecords - 1];
+
+	return EndPos[nrecords - 1];
+}
+
 /*
  * Reserves the right amount of space for a record of given size from the WAL.
  * *StartPos is set to the beginning of the reserved section, *EndPos to
@@ -1290,6 +1434,36 @@ ReserveXLogInsertLocation(int size, XLogRecPtr *StartPos, XLogRecPtr *EndPos,
 	Assert(XLogRecPtrToBytePos(*PrevPtr) == prevbytepos);
 }
 
+/*
+ * Like ReserveXLogInsertLocation(), but reserves 'size' usable bytes for a
+ * batch of consecutive records at once.  'lastsize' is the MAXALIGNed size of
+ * the last record in the batch, which becomes the new previous record.
+ *
+ * Returns the usable byte positions of the start of the reserved space, and
+ * of the record preceding the batch; the caller converts them to
+ * XLogRecPtrs, outside the spinlock.
+ */
+static void
+ReserveXLogInsertLocationBatch(uint64 size, uint64 lastsize,
+							   uint64 *StartBytePos, uint64 *PrevBytePos)
+{
+	XLogCtlInsert *Insert = &XLogCtl->Insert;
+	uint64		startbytepos;
+
+	Assert(size >= lastsize && lastsize > SizeOfXLogRecord);
+
+	SpinLockAcquire(&Insert->insertpos_lck);
+
+	startbytepos = Insert->CurrBytePos;
+	*PrevBytePos = Insert->PrevBytePos;
+	Insert->CurrBytePos = startbytepos + size;
+	Insert->PrevBytePos = startbytepos + size - lastsize;
+
+	SpinLockRelease(&Insert->insertpos_lck);
+
+	*StartBytePos = startbytepos;
+}
+
 /*
  * Like ReserveXLogInsertLocation(), but for an xlog-switch record.
  *
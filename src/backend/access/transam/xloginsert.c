@@ -9,6 +9,9 @@
  * of XLogRecData structs by a call to XLogRecordAssemble(). See
  * access/transam/README for details.
  *
+ * Several records can also be collected into a batch with XLogBatchAdd(),
+ * and inserted into the WAL together by XLogInsertBatch().
+ *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
  *
@@ -106,6 +109,61 @@ static bool begininsert_called = false;
 /* Memory context to hold the registered buffer and data references. */
 static MemoryContext xloginsert_cxt;
 
+/*
+ * State of a WAL record batch, see XLogBeginBatch().  For each record added
+ * to the batch, we save a copy of what was registered for it: the block
+ * references and a copy of their data, and a copy of the main data.  The
+ * records are assembled only when the batch is inserted, because whether
+ * full-page images are needed can only be determined then.
+ */
+typedef struct
+{
+	uint8		block_id;
+	uint8		flags;			/* REGBUF_* flags */
+	RelFileNode rnode;			/* identifies the relation and block */
+	ForkNumber	forkno;
+	BlockNumber block;
+	Page		page;			/* page content */
+	Size		data_off;		/* registered data, in batch_data */
+	uint32		data_len;
+} batched_block;
+
+typedef struct
+{
+	RmgrId		rmid;
+	uint8		info;
+	uint8		flags;			/* XLogSetRecordFlags() flags */
+	bool		phony;			/* not really logged, see XLogInsert() */
+	int			first_block;	/* first entry in batch_blocks */
+	int			nblocks;
+	Size		data_off;		/* main data, in batch_data */
+	uint32		data_len;
+	XLogRecPtr	EndPos;			/* end of record, once inserted */
+} batched_record;
+
+static bool batch_active = false;
+static batched_record *batch_records;
+static int	batch_nrecords;
+static int	batch_max_records;
+static batched_block *batch_blocks;
+static int	batch_nblocks;
+static int	batch_max_blocks;
+static char *batch_data;
+static Size batch_data_used;
+static Size batch_max_data;
+
+/* Working space for XLogInsertBatch(): assembled records, and their ends */
+static char *batch_assembled;
+static Size batch_max_assembled;
+static XLogRecData *batch_rdatas;
+static XLogRecPtr *batch_endpos;
+
+/* Worst-case size of one assembled record, excluding block data and images */
+#define BATCH_RECORD_OVERHEAD \
+	MAXALIGN(SizeOfXLogRecord + SizeOfXLogRecordDataHeaderLong + \
+			 SizeOfXlogOrigin)
+
+static void XLogResetRecord(void);
 static XLogRecData *XLogRecordAssemble(RmgrId rmid, uint8 info,
 									   XLogRecPtr RedoRecPtr, bool doPageWrites,
 									   XLogRecPtr *fpw_lsn);
@@ -187,10 +245,22 @@ XLogEnsureRecordSpace(int max_block_id, int ndatas)
 }
 
 /*
- * Reset WAL record construction buffers.
+ * Reset WAL record construction buffers, and abandon any WAL batch being
+ * collected.  This is also called during transaction abort, so that an
+ * error raised while a batch was open doesn't block later WAL insertions.
  */
 void
 XLogResetInsertion(void)
+{
+	XLogResetRecord();
+	batch_active = false;
+}
+
+/*
+ * Reset the WAL record construction buffers only, keeping the current batch.
+ */
+static void
+XLogResetRecord(void)
 {
 	int			i;
 
@@ -420,6 +490,10 @@ XLogInsert(RmgrId rmid, uint8 info)
 	if (!begininsert_called)
 		elog(ERROR, "XLogBeginInsert was not called");
 
+	/* Records would be inserted ahead of the batched ones */
+	if (batch_active)
+		elog(ERROR, "cannot insert WAL record while a WAL batch is in progress");
+
 	/*
 	 * The caller can set rmgr bits, XLR_SPECIAL_REL_UPDATE and
 	 * XLR_CHECK_CONSISTENCY; the rest are reserved for use by me.
@@ -467,6 +541,395 @@ XLogInsert(RmgrId rmid, uint8 info)
 	return EndPos;
 }
 
+/*
+ * Begin a batch of WAL records.
+ *
+ * Bulk operations that emit many small records can queue them with
+ * XLogBatchAdd() instead of inserting each one with XLogInsert(), and then
+ * insert them all with XLogInsertBatch().  That pays for the WAL insertion
+ * lock and the reservation of WAL space once per batch rather than once per
+ * record.
+ *
+ * The caller declares the maximum number of records, of block references
+ * across all records, and of bytes of registered data (main data plus block
+ * data) across all records.  All working memory is allocated here, so that
+ * XLogBatchAdd() and XLogInsertBatch() can be used in a critical section.
+ *
+ * Until XLogInsertBatch() returns, the caller must keep every registered
+ * buffer pinned and exclusively locked, and every page registered with
+ * XLogRegisterBlock() must stay in place, since the full-page images are
+ * only taken at insertion.  For the same reason, a page may only be
+ * registered in one record of a batch: an image taken for an earlier record
+ * would already include the changes of the later ones.
+ */
+void
+XLogBeginBatch(int max_records, int max_blocks, Size max_data)
+{
+	Size		max_assembled;
+
+	Assert(CritSectionCount == 0);
+	Assert(max_records > 0);
+
+	if (batch_active)
+		elog(ERROR, "WAL batch is already in progress");
+
+	if (max_records > batch_max_records)
+	{
+		if (batch_records == NULL)
+		{
+			batch_records = (batched_record *)
+				MemoryContextAlloc(xloginsert_cxt,
+								   sizeof(batched_record) * max_records);
+			batch_rdatas = (XLogRecData *)
+				MemoryContextAlloc(xloginsert_cxt,
+								   sizeof(XLogRecData) * max_records);
+			batch_endpos = (XLogRecPtr *)
+				MemoryContextAlloc(xloginsert_cxt,
+								   sizeof(XLogRecPtr) * max_records);
+		}
+		else
+		{
+			batch_records = (batched_record *)
+				repalloc(batch_records, sizeof(batched_record) * max_records);
+			batch_rdatas = (XLogRecData *)
+				repalloc(batch_rdatas, sizeof(XLogRecData) * max_records);
+			batch_endpos = (XLogRecPtr *)
+				repalloc(batch_endpos, sizeof(XLogRecPtr) * max_records);
+		}
+		batch_max_records = max_records;
+	}
+
+	if (max_blocks > batch_max_blocks)
+	{
+		if (batch_blocks == NULL)
+			batch_blocks = (batched_block *)
+				MemoryContextAlloc(xloginsert_cxt,
+								   sizeof(batched_block) * max_blocks);
+		else
+			batch_blocks = (batched_block *)
+				repalloc(batch_blocks, sizeof(batched_block) * max_blocks);
+		batch_max_blocks = max_blocks;
+	}
+
+	if (max_data > batch_max_data)
+	{
+		if (batch_data == NULL)
+			batch_data = MemoryContextAlloc(xloginsert_cxt, max_data);
+		else
+			batch_data = repalloc(batch_data, max_data);
+		batch_max_data = max_data;
+	}
+
+	/*
+	 * Room for the assembled records: headers, a possible full-page image of
+	 * every block, and all the registered data, each record MAXALIGNed.
+	 */
+	max_assembled = add_size(mul_size(max_records,
+									  BATCH_RECORD_OVERHEAD + MAXIMUM_ALIGNOF),
+							 mul_size(max_blocks,
+									  MaxSizeOfXLogRecordBlockHeader + BLCKSZ));
+	max_assembled = add_size(max_assembled, max_data);
+	if (max_assembled > batch_max_assembled)
+	{
+		if (batch_assembled == NULL)
+			batch_assembled = MemoryContextAllocHuge(xloginsert_cxt,
+													 max_assembled);
+		else
+			batch_assembled = repalloc_huge(batch_assembled, max_assembled);
+		batch_max_assembled = max_assembled;
+	}
+
+	/* Restoring a record needs one rdata per block, plus the main data */
+	if (max_rdatas < max_registered_buffers + 1)
+	{
+		rdatas = (XLogRecData *) repalloc(rdatas, sizeof(XLogRecData) *
+										  (max_registered_buffers + 1));
+		max_rdatas = max_registered_buffers + 1;
+	}
+
+	batch_nrecords = 0;
+	batch_nblocks = 0;
+	batch_data_used = 0;
+	batch_active = true;
+}
+
+/*
+ * Copy 'len' bytes of a registered data chain into the batch's data area.
+ */
+static Size
+XLogBatchCopyData(XLogRecData *rdata, uint32 len)
+{
+	Size		off = batch_data_used;
+
+	if (len > batch_max_data - batch_data_used)
+		elog(ERROR, "too much data in WAL batch");
+
+	for (; len > 0; rdata = rdata->next)
+	{
+		memcpy(batch_data + batch_data_used, rdata->data, rdata->len);
+		batch_data_used += rdata->len;
+		len -= rdata->len;
+	}
+
+	return off;
+}
+
+/*
+ * Add the record constructed with XLogBeginInsert() and XLogRegister* calls
+ * to the current batch, instead of inserting it with XLogInsert().
+ *
+ * The registered data is copied, so the caller may reuse it for the next
+ * record right away.  Returns the number of the record within the batch,
+ * which can be passed to XLogBatchRecordEnd() once the batch is inserted.
+ */
+int
+XLogBatchAdd(RmgrId rmid, uint8 info)
+{
+	batched_record *rec;
+	int			block_id;
+
+	if (!begininsert_called)
+		elog(ERROR, "XLogBeginInsert was not called");
+	if (!batch_active)
+		elog(ERROR, "XLogBeginBatch was not called");
+
+	/* See XLogInsert() */
+	if ((info & ~(XLR_RMGR_INFO_MASK |
+				  XLR_SPECIAL_REL_UPDATE |
+				  XLR_CHECK_CONSISTENCY)) != 0)
+		elog(PANIC, "invalid xlog info mask %02X", info);
+	Assert(!(rmid == RM_XLOG_ID && info == XLOG_SWITCH));
+
+	if (batch_nrecords >= batch_max_records)
+		elog(ERROR, "too many records in WAL batch");
+
+	TRACE_POSTGRESQL_WAL_INSERT(rmid, info);
+
+	rec = &batch_records[batch_nrecords];
+	rec->rmid = rmid;
+	rec->info = info;
+	rec->flags = curinsert_flags;
+	rec->phony = false;
+	rec->first_block = batch_nblocks;
+	rec->nblocks = 0;
+	rec->data_off = 0;
+	rec->data_len = 0;
+	rec->EndPos = InvalidXLogRecPtr;
+
+	/* In bootstrap mode, only XLOG resources are really logged */
+	if (IsBootstrapProcessingMode() && rmid != RM_XLOG_ID)
+	{
+		rec->phony = true;
+		rec->EndPos = SizeOfXLogLongPHD;	/* start of 1st chkpt record */
+		XLogResetRecord();
+		return batch_nrecords++;
+	}
+
+	for (block_id = 0; block_id < max_registered_block_id; block_id++)
+	{
+		registered_buffer *regbuf = &registered_buffers[block_id];
+		batched_block *bblock;
+		int			i;
+
+		if (!regbuf->in_use)
+			continue;
+
+		if (batch_nblocks >= batch_max_blocks)
+			elog(ERROR, "too many block references in WAL batch");
+
+		for (i = 0; i < batch_nblocks; i++)
+		{
+			if (RelFileNodeEquals(batch_blocks[i].rnode, regbuf->rnode) &&
+				batch_blocks[i].forkno == regbuf->forkno &&
+				batch_blocks[i].block == regbuf->block)
+				elog(ERROR, "block %u registered more than once in WAL batch",
+					 regbuf->block);
+		}
+
+		bblock = &batch_blocks[batch_nblocks++];
+		bblock->block_id = block_id;
+		bblock->flags = regbuf->flags;
+		bblock->rnode = regbuf->rnode;
+		bblock->forkno = regbuf->forkno;
+		bblock->block = regbuf->block;
+		bblock->page = regbuf->page;
+		bblock->data_len = regbuf->rdata_len;
+		bblock->data_off = XLogBatchCopyData(regbuf->rdata_head,
+											 regbuf->rdata_len);
+		rec->nblocks++;
+	}
+
+	rec->data_len = mainrdata_len;
+	rec->data_off = XLogBatchCopyData(mainrdata_head, mainrdata_len);
+
+	XLogResetRecord();
+
+	return batch_nrecords++;
+}
+
+/*
+ * Re-register the saved contents of a batched record, so that it can be
+ * assembled by XLogRecordAssemble().
+ */
+static void
+XLogBatchRestoreRecord(batched_record *rec)
+{
+	int			i;
+
+	Assert(!begininsert_called);
+
+	for (i = 0; i < rec->nblocks; i++)
+	{
+		batched_block *bblock = &batch_blocks[rec->first_block + i];
+		registered_buffer *regbuf = &registered_buffers[bblock->block_id];
+
+		regbuf->rnode = bblock->rnode;
+		regbuf->forkno = bblock->forkno;
+		regbuf->block = bblock->block;
+		regbuf->page = bblock->page;
+		regbuf->flags = bblock->flags;
+		regbuf->rdata_tail = (XLogRecData *) &regbuf->rdata_head;
+		regbuf->rdata_len = 0;
+		if (bblock->data_len > 0)
+		{
+			XLogRecData *rdata = &rdatas[num_rdatas++];
+
+			rdata->data = batch_data + bblock->data_off;
+			rdata->len = bblock->data_len;
+			regbuf->rdata_tail->next = rdata;
+			regbuf->rdata_tail = rdata;
+			regbuf->rdata_len = bblock->data_len;
+		}
+		regbuf->in_use = true;
+
+		if (bblock->block_id >= max_registered_block_id)
+			max_registered_block_id = bblock->block_id + 1;
+	}
+
+	if (rec->data_len > 0)
+	{
+		XLogRecData *rdata = &rdatas[num_rdatas++];
+
+		rdata->data = batch_data + rec->data_off;
+		rdata->len = rec->data_len;
+		mainrdata_last->next = rdata;
+		mainrdata_last = rdata;
+		mainrdata_len = rec->data_len;
+	}
+
+	curinsert_flags = rec->flags;
+	begininsert_called = true;
+}
+
+/*
+ * Insert all the records of the current batch into the WAL, consecutively,
+ * and end the batch.
+ *
+ * Returns XLOG pointer to end of the last record.  Use XLogBatchRecordEnd()
+ * to get the LSN to set on the pages affected by each individual record.
+ */
+XLogRecPtr
+XLogInsertBatch(void)
+{
+	XLogRecPtr	EndPos = InvalidXLogRecPtr;
+	int			nassembled;
+	int			i;
+
+	if (!batch_active)
+		elog(ERROR, "XLogBeginBatch was not called");
+	if (begininsert_called)
+		elog(ERROR, "WAL record construction is still in progress");
+
+	do
+	{
+		XLogRecPtr	RedoRecPtr;
+		bool		doPageWrites;
+		XLogRecPtr	fpw_lsn = InvalidXLogRecPtr;
+		uint8		flags = XLOG_MARK_UNIMPORTANT;
+		Size		used = 0;
+
+		GetFullPageWriteInfo(&RedoRecPtr, &doPageWrites);
+
+		/*
+		 * Assemble each record, and flatten it into the batch's working
+		 * space right away, since the chain returned by XLogRecordAssemble()
+		 * points into working areas shared by all records.
+		 */
+		nassembled = 0;
+		for (i = 0; i < batch_nrecords; i++)
+		{
+			batched_record *rec = &batch_records[i];
+			XLogRecData *rdt;
+			XLogRecPtr	rec_fpw_lsn;
+			char	   *dest;
+
+			if (rec->phony)
+				continue;
+
+			XLogBatchRestoreRecord(rec);
+			rdt = XLogRecordAssemble(rec->rmid, rec->info, RedoRecPtr,
+									 doPageWrites, &rec_fpw_lsn);
+
+			if (rec_fpw_lsn != InvalidXLogRecPtr &&
+				(fpw_lsn == InvalidXLogRecPtr || rec_fpw_lsn < fpw_lsn))
+				fpw_lsn = rec_fpw_lsn;
+			if ((rec->flags & XLOG_MARK_UNIMPORTANT) == 0)
+				flags = 0;
+
+			dest = batch_assembled + used;
+			batch_rdatas[nassembled].data = dest;
+			batch_rdatas[nassembled].len = ((XLogRecord *) rdt->data)->xl_tot_len;
+			batch_rdatas[nassembled].next = NULL;
+			for (; rdt != NULL; rdt = rdt->next)
+			{
+				if (rdt->len > batch_max_assembled - (dest - batch_assembled))
+					elog(ERROR, "WAL batch is too large");
+				memcpy(dest, rdt->data, rdt->len);
+				dest += rdt->len;
+			}
+			used = MAXALIGN(dest - batch_assembled);
+
+			XLogResetRecord();
+			nassembled++;
+		}
+
+		if (nassembled == 0)
+			break;
+
+		EndPos = XLogInsertRecordBatch(batch_rdatas, nassembled, fpw_lsn,
+									   flags, batch_endpos);
+	} while (EndPos == InvalidXLogRecPtr);
+
+	/* Remember where each record ended */
+	nassembled = 0;
+	for (i = 0; i < batch_nrecords; i++)
+	{
+		batched_record *rec = &batch_records[i];
+
+		if (rec->phony)
+			EndPos = Max(EndPos, rec->EndPos);
+		else
+			rec->EndPos = batch_endpos[nassembled++];
+	}
+
+	batch_active = false;
+
+	return EndPos;
+}
+
+/*
+ * Return the end of the given record of the last inserted batch, for use as
+ * the LSN of the pages it affects.
+ */
+XLogRecPtr
+XLogBatchRecordEnd(int recno)
+{
+	Assert(!batch_active);
+	Assert(recno >= 0 && recno < batch_nrecords);
+
+	return batch_records[recno].EndPos;
+}
+
 /*
  * Assemble a WAL record from the registered data and buffers into an
  * XLogRecData chain, ready for insertion with XLogInsertRecord().
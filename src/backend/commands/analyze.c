@@ -62,6 +62,7 @@
 #include "utils/pg_rusage.h"
 #include "utils/sampling.h"
 #include "utils/sortsupport.h"
+#include "utils/spccache.h"
 #include "utils/syscache.h"
 #include "utils/timestamp.h"
 
@@ -999,6 +1000,12 @@ examine_attribute(Relation onerel, int attnum, Node *index_expr)
  * unbiased estimates of the average numbers of live and dead rows per
  * block.  The previous sampling method put too much credence in the row
  * density near the start of the table.
+ *
+ * The sampled blocks are scattered over the whole table, so on large tables
+ * reading them one at a time is dominated by I/O latency.  When prefetching
+ * is possible, a second BlockSampler seeded identically to the first runs
+ * ahead of it, and we ask the kernel for the blocks it returns, as bitmap
+ * heap scans do.
  */
 static int
 acquire_sample_rows(Relation onerel, int elevel,
@@ -1016,6 +1023,11 @@ acquire_sample_rows(Relation onerel, int elevel,
 	ReservoirStateData rstate;
 	TupleTableSlot *slot;
 	TableScanDesc scan;
+	long		randseed;
+#ifdef USE_PREFETCH
+	int			prefetch_maximum = 0;	/* blocks to prefetch ahead, if any */
+	BlockSamplerData prefetch_bs;
+#endif
 
 	Assert(targrows > 0);
 
@@ -1025,10 +1037,41 @@ acquire_sample_rows(Relation onerel, int elevel,
 	OldestXmin = GetOldestXmin(onerel, PROCARRAY_FLAGS_VACUUM);
 
 	/* Prepare for sampling block numbers */
-	BlockSampler_Init(&bs, totalblocks, targrows, random());
+	randseed = random();
+	BlockSampler_Init(&bs, totalblocks, targrows, randseed);
 	/* Prepare for sampling rows */
 	reservoir_init_selection_state(&rstate, targrows);
 
+#ifdef USE_PREFETCH
+	{
+		int			io_concurrency;
+		double		maximum;
+
+		io_concurrency =
+			get_tablespace_io_concurrency(onerel->rd_rel->reltablespace);
+		if (ComputeIoConcurrency(io_concurrency, &maximum))
+			prefetch_maximum = rint(maximum);
+	}
+
+	/*
+	 * The prefetching sampler yields the same block numbers as the main one,
+	 * so start it out prefetch_maximum blocks ahead and keep it there.
+	 */
+	if (prefetch_maximum > 0)
+	{
+		int			i;
+
+		BlockSampler_Init(&prefetch_bs, totalblocks, targrows, randseed);
+		for (i = 0; i < prefetch_maximum; i++)
+		{
+			if (!BlockSampler_HasMore(&prefetch_bs))
+				break;
+			PrefetchBuffer(onerel, MAIN_FORKNUM,
+						   BlockSampler_Next(&prefetch_bs));
+		}
+	}
+#endif							/* USE_PREFETCH */
+
 	scan = table_beginscan_analyze(onerel);
 	slot = table_slot_create(onerel, NULL);
 
@@ -1037,6 +1080,17 @@ acquire_sample_rows(Relation onerel, int elevel,
 	{
 		BlockNumber targblock = BlockSampler_Next(&bs);
 
+#ifdef USE_PREFETCH
+		/*
+		 * Prefetch the block the main sampler will reach prefetch_maximum
+		 * blocks from now.  Do this even if the block we're about to read
+		 * turns out to be skipped, so the distance stays the same.
+		 */
+		if (prefetch_maximum > 0 && BlockSampler_HasMore(&prefetch_bs))
+			PrefetchBuffer(onerel, MAIN_FORKNUM,
+						   BlockSampler_Next(&prefetch_bs));
+#endif
+
 		vacuum_delay_point();
 
 		if (!table_scan_analyze_next_block(scan, targblock, vac_strategy))
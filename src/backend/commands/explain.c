@@ -18,6 +18,7 @@
 #include "commands/createas.h"
 #include "commands/defrem.h"
 #include "commands/prepare.h"
+#include "executor/execBatch.h"
 #include "executor/nodeHash.h"
 #include "foreign/fdwapi.h"
 #include "jit/jit.h"
@@ -101,7 +102,15 @@ static void show_sortorder_options(StringInfo buf, Node *sortexpr,
 static void show_tablesample(TableSampleClause *tsc, PlanState *planstate,
 							 List *ancestors, ExplainState *es);
 static void show_sort_info(SortState *sortstate, ExplainState *es);
+static void show_incremental_sort_keys(IncrementalSortState *incrsortstate,
+									   List *ancestors, ExplainState *es);
+static void show_incremental_sort_info(IncrementalSortState *incrsortstate,
+									   ExplainState *es);
 static void show_hash_info(HashState *hashstate, ExplainState *es);
+static void show_nestloop_info(NestLoopState *nlstate, ExplainState *es);
+static void show_memoize_info(MemoizeState *mstate, List *ancestors,
+							  ExplainState *es);
+static void show_hashagg_info(AggState *aggstate, ExplainState *es);
 static void show_tidbitmap_info(BitmapHeapScanState *planstate,
 								ExplainState *es);
 static void show_instrumentation_count(const char *qlabel, int which,
@@ -826,13 +835,16 @@ ExplainPrintJIT(ExplainState *es, int jit_flags,
 		es->indent += 1;
 
 		ExplainPropertyInteger("Functions", NULL, ji->created_functions, es);
+		if (ji->cache_hits > 0)
+			ExplainPropertyInteger("Cache Hits", NULL, ji->cache_hits, es);
 
 		appendStringInfoSpaces(es->str, es->indent * 2);
-		appendStringInfo(es->str, "Options: %s %s, %s %s, %s %s, %s %s\n",
+		appendStringInfo(es->str, "Options: %s %s, %s %s, %s %s, %s %s, %s %s\n",
 						 "Inlining", jit_flags & PGJIT_INLINE ? "true" : "false",
 						 "Optimization", jit_flags & PGJIT_OPT3 ? "true" : "false",
 						 "Expressions", jit_flags & PGJIT_EXPR ? "true" : "false",
-						 "Deforming", jit_flags & PGJIT_DEFORM ? "true" : "false");
+						 "Deforming", jit_flags & PGJIT_DEFORM ? "true" : "false",
+						 "Scans", jit_flags & PGJIT_SCAN ? "true" : "false");
 
 		if (es->analyze && es->timing)
 		{
@@ -852,12 +864,14 @@ ExplainPrintJIT(ExplainState *es, int jit_flags,
 	{
 		ExplainPropertyInteger("Worker Number", NULL, worker_num, es);
 		ExplainPropertyInteger("Functions", NULL, ji->created_functions, es);
+		ExplainPropertyInteger("Cache Hits", NULL, ji->cache_hits, es);
 
 		ExplainOpenGroup("Options", "Options", true, es);
 		ExplainPropertyBool("Inlining", jit_flags & PGJIT_INLINE, es);
 		ExplainPropertyBool("Optimization", jit_flags & PGJIT_OPT3, es);
 		ExplainPropertyBool("Expressions", jit_flags & PGJIT_EXPR, es);
 		ExplainPropertyBool("Deforming", jit_flags & PGJIT_DEFORM, es);
+		ExplainPropertyBool("Scans", jit_flags & PGJIT_SCAN, es);
 		ExplainCloseGroup("Options", "Options", true, es);
 
 		if (es->analyze && es->timing)
@@ -1212,9 +1226,15 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		case T_Material:
 			pname = sname = "Materialize";
 			break;
+		case T_Memoize:
+			pname = sname = "Memoize";
+			break;
 		case T_Sort:
 			pname = sname = "Sort";
 			break;
+		case T_IncrementalSort:
+			pname = sname = "Incremental Sort";
+			break;
 		case T_Group:
 			pname = sname = "Group";
 			break;
@@ -1642,6 +1662,17 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			if (plan->qual)
 				show_instrumentation_count("Rows Removed by Filter", 1,
 										   planstate, es);
+			if (IsA(planstate, SeqScanState) &&
+				((SeqScanState *) planstate)->rtfilter != NULL)
+				show_instrumentation_count("Rows Removed by Runtime Filter", 2,
+										   planstate, es);
+			if (IsA(planstate, SeqScanState) &&
+				((SeqScanState *) planstate)->batch != NULL)
+			{
+				TupleBatch *batch = ((SeqScanState *) planstate)->batch;
+
+				ExplainPropertyInteger("Batch Size", NULL, batch->capacity, es);
+			}
 			break;
 		case T_Gather:
 			{
@@ -1796,6 +1827,8 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			if (plan->qual)
 				show_instrumentation_count("Rows Removed by Filter", 2,
 										   planstate, es);
+			if (es->analyze)
+				show_nestloop_info(castNode(NestLoopState, planstate), es);
 			break;
 		case T_MergeJoin:
 			show_upper_qual(((MergeJoin *) plan)->mergeclauses,
@@ -1829,6 +1862,8 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			if (plan->qual)
 				show_instrumentation_count("Rows Removed by Filter", 1,
 										   planstate, es);
+			if (es->analyze)
+				show_hashagg_info(castNode(AggState, planstate), es);
 			break;
 		case T_Group:
 			show_group_keys(castNode(GroupState, planstate), ancestors, es);
@@ -1841,6 +1876,12 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			show_sort_keys(castNode(SortState, planstate), ancestors, es);
 			show_sort_info(castNode(SortState, planstate), es);
 			break;
+		case T_IncrementalSort:
+			show_incremental_sort_keys(castNode(IncrementalSortState, planstate),
+									   ancestors, es);
+			show_incremental_sort_info(castNode(IncrementalSortState, planstate),
+									   es);
+			break;
 		case T_MergeAppend:
 			show_merge_append_keys(castNode(MergeAppendState, planstate),
 								   ancestors, es);
@@ -1860,6 +1901,10 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		case T_Hash:
 			show_hash_info(castNode(HashState, planstate), es);
 			break;
+		case T_Memoize:
+			show_memoize_info(castNode(MemoizeState, planstate), ancestors,
+							  es);
+			break;
 		default:
 			break;
 	}
@@ -2181,6 +2226,28 @@ show_sort_keys(SortState *sortstate, List *ancestors, ExplainState *es)
 						 ancestors, es);
 }
 
+/*
+ * Show the sort keys for an IncrementalSort node, and the leading subset of
+ * them the input is already sorted by.
+ */
+static void
+show_incremental_sort_keys(IncrementalSortState *incrsortstate,
+						   List *ancestors, ExplainState *es)
+{
+	IncrementalSort *plan = (IncrementalSort *) incrsortstate->ss.ps.plan;
+
+	show_sort_group_keys((PlanState *) incrsortstate, "Sort Key",
+						 plan->sort.numCols, plan->sort.sortColIdx,
+						 plan->sort.sortOperators, plan->sort.collations,
+						 plan->sort.nullsFirst,
+						 ancestors, es);
+	show_sort_group_keys((PlanState *) incrsortstate, "Presorted Key",
+						 plan->nPresortedCols, plan->sort.sortColIdx,
+						 plan->sort.sortOperators, plan->sort.collations,
+						 plan->sort.nullsFirst,
+						 ancestors, es);
+}
+
 /*
  * Likewise, for a MergeAppend node.
  */
@@ -2612,6 +2679,64 @@ show_sort_info(SortState *sortstate, ExplainState *es)
 	}
 }
 
+/*
+ * If it's EXPLAIN ANALYZE, show tuplesort stats for an incremental sort node
+ */
+static void
+show_incremental_sort_info(IncrementalSortState *incrsortstate,
+						   ExplainState *es)
+{
+	IncrementalSortInfo *info = &incrsortstate->incsort_info;
+	StringInfoData methods;
+	int			m;
+
+	if (!es->analyze || info->groupCount == 0)
+		return;
+
+	initStringInfo(&methods);
+	for (m = SORT_TYPE_TOP_N_HEAPSORT; m <= SORT_TYPE_EXTERNAL_MERGE; m++)
+	{
+		if (info->sortMethods & (1 << m))
+		{
+			if (methods.len > 0)
+				appendStringInfoString(&methods, ", ");
+			appendStringInfoString(&methods,
+								   tuplesort_method_name((TuplesortMethod) m));
+		}
+	}
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfo(es->str,
+						 "Sort Methods: %s  Batches: " INT64_FORMAT "  Average Memory: %ldkB  Peak Memory: %ldkB",
+						 methods.data, info->groupCount,
+						 info->totalMemorySpaceUsed / info->groupCount,
+						 info->maxMemorySpaceUsed);
+		if (info->maxDiskSpaceUsed > 0)
+			appendStringInfo(es->str,
+							 "  Average Disk: %ldkB  Peak Disk: %ldkB",
+							 info->totalDiskSpaceUsed / info->groupCount,
+							 info->maxDiskSpaceUsed);
+		appendStringInfoChar(es->str, '\n');
+	}
+	else
+	{
+		ExplainPropertyText("Sort Methods", methods.data, es);
+		ExplainPropertyInteger("Sort Batches", NULL, info->groupCount, es);
+		ExplainPropertyInteger("Average Sort Space Used", "kB",
+							   (info->totalMemorySpaceUsed +
+								info->totalDiskSpaceUsed) / info->groupCount,
+							   es);
+		ExplainPropertyInteger("Peak Memory Space Used", "kB",
+							   info->maxMemorySpaceUsed, es);
+		ExplainPropertyInteger("Peak Disk Space Used", "kB",
+							   info->maxDiskSpaceUsed, es);
+	}
+
+	pfree(methods.data);
+}
+
 /*
  * Show information on hash buckets/batches.
  */
@@ -2715,6 +2840,160 @@ show_hash_info(HashState *hashstate, ExplainState *es)
 	}
 }
 
+/*
+ * Show whether a nested loop switched to hashing its inner side.
+ */
+static void
+show_nestloop_info(NestLoopState *nlstate, ExplainState *es)
+{
+	double		outer_rows = outerPlanState(nlstate)->plan->plan_rows;
+
+	if (nlstate->nl_HashSwitches == 0 && !nlstate->nl_HashAbandoned)
+		return;
+
+	if (es->format != EXPLAIN_FORMAT_TEXT)
+	{
+		ExplainPropertyInteger("Adaptive Hash Switches", NULL,
+							   nlstate->nl_HashSwitches, es);
+		if (nlstate->nl_HashSwitches > 0)
+			ExplainPropertyInteger("Adaptive Hash Switch Row", NULL,
+								   nlstate->nl_HashSwitchRow, es);
+		ExplainPropertyFloat("Adaptive Hash Estimated Rows", NULL,
+							 outer_rows, 0, es);
+		ExplainPropertyBool("Adaptive Hash Abandoned",
+							nlstate->nl_HashAbandoned, es);
+	}
+	else
+	{
+		if (nlstate->nl_HashSwitches > 0)
+		{
+			appendStringInfoSpaces(es->str, es->indent * 2);
+			appendStringInfo(es->str,
+							 "Adaptive Join: hashed inner side after " UINT64_FORMAT " outer rows (estimated %.0f)\n",
+							 nlstate->nl_HashSwitchRow, outer_rows);
+		}
+		if (nlstate->nl_HashAbandoned)
+		{
+			appendStringInfoSpaces(es->str, es->indent * 2);
+			appendStringInfoString(es->str,
+								   "Adaptive Join: hashing inner side abandoned, exceeded work_mem\n");
+		}
+	}
+}
+
+/*
+ * Show information on memoize hits/misses/evictions and memory usage.
+ */
+static void
+show_memoize_info(MemoizeState *mstate, List *ancestors, ExplainState *es)
+{
+	Plan	   *plan = ((PlanState *) mstate)->plan;
+	ListCell   *lc;
+	List	   *context;
+	StringInfoData keystr;
+	const char *separator = "";
+	bool		useprefix;
+	uint64		memPeak;
+	long		memPeakKb;
+
+	initStringInfo(&keystr);
+
+	/*
+	 * It's hard to imagine having a memoize node with fewer than 2 RTEs, but
+	 * let's just keep the same useprefix logic as elsewhere in this file.
+	 */
+	useprefix = list_length(es->rtable) > 1 || es->verbose;
+
+	/* Set up deparsing context */
+	context = set_deparse_context_planstate(es->deparse_cxt,
+											(Node *) mstate,
+											ancestors);
+
+	foreach(lc, ((Memoize *) plan)->param_exprs)
+	{
+		Node	   *expr = (Node *) lfirst(lc);
+
+		appendStringInfoString(&keystr, separator);
+
+		appendStringInfoString(&keystr, deparse_expression(expr, context,
+														   useprefix, false));
+		separator = ", ";
+	}
+
+	ExplainPropertyText("Cache Key", keystr.data, es);
+	ExplainPropertyText("Cache Mode", mstate->binary_mode ? "binary" : "logical", es);
+
+	pfree(keystr.data);
+
+	if (!es->analyze || mstate->stats.cache_misses == 0)
+		return;
+
+	/* The cache may still be growing, so mem_peak can lag behind */
+	memPeak = Max(mstate->stats.mem_peak, mstate->mem_used);
+	memPeakKb = (memPeak + 1023) / 1024;
+
+	if (es->format != EXPLAIN_FORMAT_TEXT)
+	{
+		ExplainPropertyInteger("Cache Hits", NULL,
+							   mstate->stats.cache_hits, es);
+		ExplainPropertyInteger("Cache Misses", NULL,
+							   mstate->stats.cache_misses, es);
+		ExplainPropertyInteger("Cache Evictions", NULL,
+							   mstate->stats.cache_evictions, es);
+		ExplainPropertyInteger("Cache Overflows", NULL,
+							   mstate->stats.cache_overflows, es);
+		ExplainPropertyInteger("Peak Memory Usage", "kB",
+							   memPeakKb, es);
+	}
+	else
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfo(es->str,
+						 "Hits: " UINT64_FORMAT "  Misses: " UINT64_FORMAT "  Evictions: " UINT64_FORMAT "  Overflows: " UINT64_FORMAT "  Memory Usage: %ldkB\n",
+						 mstate->stats.cache_hits,
+						 mstate->stats.cache_misses,
+						 mstate->stats.cache_evictions,
+						 mstate->stats.cache_overflows,
+						 memPeakKb);
+	}
+}
+
+/*
+ * Show information on hash aggregate memory usage and batches.
+ */
+static void
+show_hashagg_info(AggState *aggstate, ExplainState *es)
+{
+	long		memPeakKb = (aggstate->hash_mem_peak + 1023) / 1024;
+
+	if (aggstate->aggstrategy != AGG_HASHED &&
+		aggstate->aggstrategy != AGG_MIXED)
+		return;
+
+	/* nothing to show if the hash table was never filled */
+	if (aggstate->hash_batches_used == 0)
+		return;
+
+	if (es->format != EXPLAIN_FORMAT_TEXT)
+	{
+		ExplainPropertyInteger("HashAgg Batches", NULL,
+							   aggstate->hash_batches_used, es);
+		ExplainPropertyInteger("Peak Memory Usage", "kB", memPeakKb, es);
+		ExplainPropertyInteger("Disk Usage", "kB",
+							   aggstate->hash_disk_used, es);
+	}
+	else
+	{
+		appendStringInfoSpaces(es->str, es->indent * 2);
+		appendStringInfo(es->str, "Batches: %d  Memory Usage: %ldkB",
+						 aggstate->hash_batches_used, memPeakKb);
+		if (aggstate->hash_batches_used > 1)
+			appendStringInfo(es->str, "  Disk Usage: " UINT64_FORMAT "kB",
+							 aggstate->hash_disk_used);
+		appendStringInfoChar(es->str, '\n');
+	}
+}
+
 /*
  * If it's EXPLAIN ANALYZE, show exact/lossy pages for a BitmapHeapScan node
  */
@@ -0,0 +1,550 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatch.c
+ *	  Support for batch-at-a-time qual evaluation in scan nodes.
+ *
+ * Normally a scan node fetches one tuple at a time and evaluates its quals
+ * on it with ExecQual(), which costs an expression-interpreter dispatch per
+ * operator per row.  In batch mode, the scan instead fetches a batch of
+ * tuples into an array of slots, and evaluates the simple comparisons
+ * between a column and a constant with tight loops over one column of the
+ * batch at a time.  The tuples that pass are recorded in a selection
+ * vector, and returned one by one to the parent node; any quals that can't
+ * be evaluated this way are checked on them as usual.
+ *
+ * Only comparisons that can never raise an error are evaluated in batches,
+ * so the observable behavior is the same as in row-at-a-time mode, even
+ * though the batch quals are evaluated on tuples ahead of the ones being
+ * returned.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/execBatch.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/tableam.h"
+#include "executor/execBatch.h"
+#include "executor/tuptable.h"
+#include "nodes/nodeFuncs.h"
+#include "utils/float.h"
+#include "utils/fmgroids.h"
+
+
+/* GUC parameter */
+int			executor_batch_size = 0;
+
+/* Data types of the values a batch comparison works on */
+typedef enum BatchValueKind
+{
+	BATCH_INT2,
+	BATCH_INT4,
+	BATCH_INT8,
+	BATCH_FLOAT4,
+	BATCH_FLOAT8
+} BatchValueKind;
+
+#define BATCH_KIND_IS_FLOAT(kind) \
+	((kind) == BATCH_FLOAT4 || (kind) == BATCH_FLOAT8)
+
+typedef enum BatchCmp
+{
+	BATCH_LT,
+	BATCH_LE,
+	BATCH_EQ,
+	BATCH_NE,
+	BATCH_GE,
+	BATCH_GT
+} BatchCmp;
+
+/* An operator implementation we know how to evaluate in batches */
+typedef struct BatchOperator
+{
+	Oid			funcid;
+	BatchValueKind left;
+	BatchValueKind right;
+	BatchCmp	cmp;
+} BatchOperator;
+
+#define BATCH_OPERATOR_SET(prefix, left, right) \
+	{F_##prefix##LT, left, right, BATCH_LT}, \
+	{F_##prefix##LE, left, right, BATCH_LE}, \
+	{F_##prefix##EQ, left, right, BATCH_EQ}, \
+	{F_##prefix##NE, left, right, BATCH_NE}, \
+	{F_##prefix##GE, left, right, BATCH_GE}, \
+	{F_##prefix##GT, left, right, BATCH_GT}
+
+/*
+ * Integer comparisons are all done on int64, and floating-point comparisons
+ * on float8.  Widening the inputs doesn't change the result of any of these
+ * operators, and a date is just an int32.
+ */
+static const BatchOperator batch_operators[] = {
+	BATCH_OPERATOR_SET(INT2, BATCH_INT2, BATCH_INT2),
+	BATCH_OPERATOR_SET(INT4, BATCH_INT4, BATCH_INT4),
+	BATCH_OPERATOR_SET(INT8, BATCH_INT8, BATCH_INT8),
+	BATCH_OPERATOR_SET(INT24, BATCH_INT2, BATCH_INT4),
+	BATCH_OPERATOR_SET(INT42, BATCH_INT4, BATCH_INT2),
+	BATCH_OPERATOR_SET(INT28, BATCH_INT2, BATCH_INT8),
+	BATCH_OPERATOR_SET(INT82, BATCH_INT8, BATCH_INT2),
+	BATCH_OPERATOR_SET(INT48, BATCH_INT4, BATCH_INT8),
+	BATCH_OPERATOR_SET(INT84, BATCH_INT8, BATCH_INT4),
+	BATCH_OPERATOR_SET(FLOAT4, BATCH_FLOAT4, BATCH_FLOAT4),
+	BATCH_OPERATOR_SET(FLOAT8, BATCH_FLOAT8, BATCH_FLOAT8),
+	BATCH_OPERATOR_SET(FLOAT48, BATCH_FLOAT4, BATCH_FLOAT8),
+	BATCH_OPERATOR_SET(FLOAT84, BATCH_FLOAT8, BATCH_FLOAT4),
+	BATCH_OPERATOR_SET(DATE_, BATCH_INT4, BATCH_INT4)
+};
+
+/* One "column op constant" clause of a BatchQual */
+typedef struct BatchQualClause
+{
+	AttrNumber	attno;			/* column of the scan tuple */
+	BatchValueKind kind;		/* its data type */
+	BatchCmp	cmp;			/* comparison, with the column on the left */
+	int64		intconst;		/* constant, if integer comparison */
+	float8		floatconst;		/* constant, if float comparison */
+} BatchQualClause;
+
+struct BatchQual
+{
+	int			nclauses;
+	AttrNumber	maxattno;		/* highest column referenced */
+	BatchQualClause clauses[FLEXIBLE_ARRAY_MEMBER];
+};
+
+static const BatchOperator *lookup_batch_operator(Oid funcid);
+static bool batch_clause_from_expr(Expr *clause, BatchQualClause *bclause);
+static int	batch_filter_int(TupleBatch *batch, BatchQualClause *bclause);
+static int	batch_filter_float(TupleBatch *batch, BatchQualClause *bclause);
+
+
+/*
+ * Find the batch implementation of an operator function, if any.
+ */
+static const BatchOperator *
+lookup_batch_operator(Oid funcid)
+{
+	int			i;
+
+	for (i = 0; i < lengthof(batch_operators); i++)
+	{
+		if (batch_operators[i].funcid == funcid)
+			return &batch_operators[i];
+	}
+	return NULL;
+}
+
+/*
+ * Check whether a qual clause is a comparison between a column of the scan
+ * tuple and a non-null constant that we can evaluate in batches, and if so
+ * fill *bclause with its description.
+ */
+static bool
+batch_clause_from_expr(Expr *clause, BatchQualClause *bclause)
+{
+	OpExpr	   *op;
+	const BatchOperator *bop;
+	Node	   *leftop;
+	Node	   *rightop;
+	Var		   *var;
+	Const	   *con;
+	BatchValueKind constkind;
+
+	if (!IsA(clause, OpExpr))
+		return false;
+	op = (OpExpr *) clause;
+	if (list_length(op->args) != 2)
+		return false;
+
+	set_opfuncid(op);
+	bop = lookup_batch_operator(op->opfuncid);
+	if (bop == NULL)
+		return false;
+
+	leftop = (Node *) linitial(op->args);
+	rightop = (Node *) lsecond(op->args);
+
+	if (IsA(leftop, Var) && IsA(rightop, Const))
+	{
+		var = (Var *) leftop;
+		con = (Const *) rightop;
+		bclause->kind = bop->left;
+		bclause->cmp = bop->cmp;
+		constkind = bop->right;
+	}
+	else if (IsA(leftop, Const) && IsA(rightop, Var))
+	{
+		var = (Var *) rightop;
+		con = (Const *) leftop;
+		bclause->kind = bop->right;
+		constkind = bop->left;
+
+		/* commute the comparison so that the column is on the left */
+		switch (bop->cmp)
+		{
+			case BATCH_LT:
+				bclause->cmp = BATCH_GT;
+				break;
+			case BATCH_LE:
+				bclause->cmp = BATCH_GE;
+				break;
+			case BATCH_GE:
+				bclause->cmp = BATCH_LE;
+				break;
+			case BATCH_GT:
+				bclause->cmp = BATCH_LT;
+				break;
+			default:
+				bclause->cmp = bop->cmp;
+				break;
+		}
+	}
+	else
+		return false;
+
+	if (var->varattno <= 0 || var->varlevelsup != 0 || con->constisnull)
+		return false;
+
+	bclause->attno = var->varattno;
+	bclause->intconst = 0;
+	bclause->floatconst = 0;
+
+	switch (constkind)
+	{
+		case BATCH_INT2:
+			bclause->intconst = DatumGetInt16(con->constvalue);
+			break;
+		case BATCH_INT4:
+			bclause->intconst = DatumGetInt32(con->constvalue);
+			break;
+		case BATCH_INT8:
+			bclause->intconst = DatumGetInt64(con->constvalue);
+			break;
+		case BATCH_FLOAT4:
+			bclause->floatconst = DatumGetFloat4(con->constvalue);
+			break;
+		case BATCH_FLOAT8:
+			bclause->floatconst = DatumGetFloat8(con->constvalue);
+			break;
+	}
+
+	return true;
+}
+
+/*
+ * ExecInitBatchQual
+ *		Extract the clauses of a scan qual that can be evaluated in batches.
+ *
+ * 'qual' is an implicitly-ANDed list of qual clauses of a scan node.  The
+ * clauses that can't be evaluated in batches are returned in *residual,
+ * and must be checked on each tuple that passes the batch quals.  Returns
+ * NULL if none of the clauses can be evaluated in batches.
+ */
+BatchQual *
+ExecInitBatchQual(List *qual, List **residual)
+{
+	BatchQual  *bqual;
+	ListCell   *lc;
+
+	*residual = NIL;
+
+	bqual = palloc(offsetof(BatchQual, clauses) +
+				   Max(list_length(qual), 1) * sizeof(BatchQualClause));
+	bqual->nclauses = 0;
+	bqual->maxattno = 0;
+
+	foreach(lc, qual)
+	{
+		Expr	   *clause = (Expr *) lfirst(lc);
+		BatchQualClause *bclause = &bqual->clauses[bqual->nclauses];
+
+		if (batch_clause_from_expr(clause, bclause))
+		{
+			bqual->nclauses++;
+			bqual->maxattno = Max(bqual->maxattno, bclause->attno);
+		}
+		else
+			*residual = lappend(*residual, clause);
+	}
+
+	if (bqual->nclauses == 0)
+	{
+		pfree(bqual);
+		*residual = qual;
+		return NULL;
+	}
+
+	return bqual;
+}
+
+/*
+ * ExecInitTupleBatch
+ *		Create a batch of up to 'capacity' tuples of the given relation.
+ */
+TupleBatch *
+ExecInitTupleBatch(Relation rel, int capacity)
+{
+	TupleBatch *batch = palloc(sizeof(TupleBatch));
+	int			i;
+
+	Assert(capacity > 0);
+
+	batch->capacity = capacity;
+	batch->ntuples = 0;
+	batch->held = false;
+	batch->nselected = 0;
+	batch->next = 0;
+	batch->slots = palloc(capacity * sizeof(TupleTableSlot *));
+	for (i = 0; i < capacity; i++)
+		batch->slots[i] = table_slot_create(rel, NULL);
+	batch->fetchslot = table_slot_create(rel, NULL);
+	batch->selection = palloc(capacity * sizeof(int));
+	batch->intvalues = palloc(capacity * sizeof(int64));
+	batch->floatvalues = palloc(capacity * sizeof(float8));
+
+	return batch;
+}
+
+/*
+ * ExecResetTupleBatch
+ *		Forget the tuples of a batch, including any held-over tuple,
+ *		releasing the buffer pins they hold.
+ */
+void
+ExecResetTupleBatch(TupleBatch *batch)
+{
+	int			i;
+
+	for (i = 0; i < batch->ntuples; i++)
+		ExecClearTuple(batch->slots[i]);
+	if (batch->held)
+		ExecClearTuple(batch->slots[batch->ntuples]);
+	ExecClearTuple(batch->fetchslot);
+	batch->ntuples = 0;
+	batch->held = false;
+	batch->nselected = 0;
+	batch->next = 0;
+}
+
+/*
+ * ExecAdvanceTupleBatch
+ *		Forget the tuples of a batch, and make the held-over tuple, if any,
+ *		the first tuple of the next batch.
+ */
+void
+ExecAdvanceTupleBatch(TupleBatch *batch)
+{
+	int			i;
+
+	for (i = 0; i < batch->ntuples; i++)
+		ExecClearTuple(batch->slots[i]);
+	if (batch->held)
+	{
+		TupleTableSlot *slot = batch->slots[batch->ntuples];
+
+		batch->slots[batch->ntuples] = batch->slots[0];
+		batch->slots[0] = slot;
+		batch->ntuples = 1;
+		batch->held = false;
+	}
+	else
+		batch->ntuples = 0;
+	batch->nselected = 0;
+	batch->next = 0;
+}
+
+/*
+ * ExecDropTupleBatch
+ *		Release all resources of a batch.
+ */
+void
+ExecDropTupleBatch(TupleBatch *batch)
+{
+	int			i;
+
+	for (i = 0; i < batch->capacity; i++)
+		ExecDropSingleTupleTableSlot(batch->slots[i]);
+	ExecDropSingleTupleTableSlot(batch->fetchslot);
+	pfree(batch->slots);
+	pfree(batch->selection);
+	pfree(batch->intvalues);
+	pfree(batch->floatvalues);
+	pfree(batch);
+}
+
+/*
+ * Gather one column of the selected tuples into 'values', dropping the
+ * tuples where it's NULL from the selection (all our operators are strict).
+ * We mustn't look at the datum of a NULL, as it might be an invalid pointer
+ * for by-reference types.
+ */
+#define BATCH_GATHER(batch, attidx, values, getter) \
+	do { \
+		for (i = 0; i < (batch)->nselected; i++) \
+		{ \
+			int			tupidx = (batch)->selection[i]; \
+			TupleTableSlot *slot = (batch)->slots[tupidx]; \
+			\
+			if (!slot->tts_isnull[attidx]) \
+			{ \
+				(batch)->selection[n] = tupidx; \
+				(values)[n++] = getter(slot->tts_values[attidx]); \
+			} \
+		} \
+	} while (0)
+
+/*
+ * Keep only the selected tuples for which 'test' holds on values[i].  This
+ * is written without branches, so that the compiler can make it fast.
+ */
+#define BATCH_FILTER(batch, test) \
+	do { \
+		for (i = 0; i < n; i++) \
+		{ \
+			(batch)->selection[m] = (batch)->selection[i]; \
+			m += (test); \
+		} \
+	} while (0)
+
+/*
+ * Apply an integer comparison to the selected tuples of a batch, and return
+ * the number of tuples that pass.
+ */
+static int
+batch_filter_int(TupleBatch *batch, BatchQualClause *bclause)
+{
+	int64	   *values = batch->intvalues;
+	int64		c = bclause->intconst;
+	int			attidx = bclause->attno - 1;
+	int			i;
+	int			n = 0;
+	int			m = 0;
+
+	switch (bclause->kind)
+	{
+		case BATCH_INT2:
+			BATCH_GATHER(batch, attidx, values, DatumGetInt16);
+			break;
+		case BATCH_INT4:
+			BATCH_GATHER(batch, attidx, values, DatumGetInt32);
+			break;
+		case BATCH_INT8:
+			BATCH_GATHER(batch, attidx, values, DatumGetInt64);
+			break;
+		default:
+			elog(ERROR, "unexpected batch value kind: %d",
+				 (int) bclause->kind);
+	}
+
+	switch (bclause->cmp)
+	{
+		case BATCH_LT:
+			BATCH_FILTER(batch, values[i] < c);
+			break;
+		case BATCH_LE:
+			BATCH_FILTER(batch, values[i] <= c);
+			break;
+		case BATCH_EQ:
+			BATCH_FILTER(batch, values[i] == c);
+			break;
+		case BATCH_NE:
+			BATCH_FILTER(batch, values[i] != c);
+			break;
+		case BATCH_GE:
+			BATCH_FILTER(batch, values[i] >= c);
+			break;
+		case BATCH_GT:
+			BATCH_FILTER(batch, values[i] > c);
+			break;
+	}
+
+	return m;
+}
+
+/*
+ * Likewise for a floating-point comparison.  We use the comparison
+ * functions of float.h, which treat NaNs the same way the SQL operators do.
+ */
+static int
+batch_filter_float(TupleBatch *batch, BatchQualClause *bclause)
+{
+	float8	   *values = batch->floatvalues;
+	float8		c = bclause->floatconst;
+	int			attidx = bclause->attno - 1;
+	int			i;
+	int			n = 0;
+	int			m = 0;
+
+	switch (bclause->kind)
+	{
+		case BATCH_FLOAT4:
+			BATCH_GATHER(batch, attidx, values, DatumGetFloat4);
+			break;
+		case BATCH_FLOAT8:
+			BATCH_GATHER(batch, attidx, values, DatumGetFloat8);
+			break;
+		default:
+			elog(ERROR, "unexpected batch value kind: %d",
+				 (int) bclause->kind);
+	}
+
+	switch (bclause->cmp)
+	{
+		case BATCH_LT:
+			BATCH_FILTER(batch, float8_lt(values[i], c));
+			break;
+		case BATCH_LE:
+			BATCH_FILTER(batch, float8_le(values[i], c));
+			break;
+		case BATCH_EQ:
+			BATCH_FILTER(batch, float8_eq(values[i], c));
+			break;
+		case BATCH_NE:
+			BATCH_FILTER(batch, float8_ne(values[i], c));
+			break;
+		case BATCH_GE:
+			BATCH_FILTER(batch, float8_ge(values[i], c));
+			break;
+		case BATCH_GT:
+			BATCH_FILTER(batch, float8_gt(values[i], c));
+			break;
+	}
+
+	return m;
+}
+
+/*
+ * ExecBatchQual
+ *		Evaluate the batch quals on all the tuples of a batch, and set up its
+ *		selection vector to hold the ones that pass.
+ */
+void
+ExecBatchQual(BatchQual *bqual, TupleBatch *batch)
+{
+	int			i;
+
+	/* Deform the columns we need, and start with all tuples selected */
+	for (i = 0; i < batch->ntuples; i++)
+	{
+		slot_getsomeattrs(batch->slots[i], bqual->maxattno);
+		batch->selection[i] = i;
+	}
+	batch->nselected = batch->ntuples;
+	batch->next = 0;
+
+	for (i = 0; i < bqual->nclauses && batch->nselected > 0; i++)
+	{
+		BatchQualClause *bclause = &bqual->clauses[i];
+
+		if (BATCH_KIND_IS_FLOAT(bclause->kind))
+			batch->nselected = batch_filter_float(batch, bclause);
+		else
+			batch->nselected = batch_filter_int(batch, bclause);
+	}
+}
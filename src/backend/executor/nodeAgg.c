@@ -194,6 +194,31 @@
  *	  transition values.  hashcontext is the single context created to support
  *	  all hash tables.
  *
+ *	  Spilling To Disk
+ *
+ *	  When performing hash aggregation, if the hash tables' memory exceeds
+ *	  work_mem, we enter "spill mode".  In spill mode, we advance the
+ *	  transition states only for groups already in the hash table; input
+ *	  tuples that would need a new group are instead written to a temporary
+ *	  file, one of several partitions chosen by the tuple's hash value.  The
+ *	  memory used is measured with MemoryContextMemAllocated() over the
+ *	  contexts holding the hash tables' buckets, entries and transition
+ *	  values.
+ *
+ *	  Once the input is exhausted and the in-memory groups have been emitted,
+ *	  each partition becomes a batch: the hash tables are reset, the batch's
+ *	  tuples are read back and aggregated into the table of the grouping set
+ *	  they were spilled for, and the resulting groups are emitted.  A batch
+ *	  that still doesn't fit is partitioned again using further bits of the
+ *	  hash value, so the process recurses until every group has been
+ *	  emitted.  Each pass creates at least one group before spilling, so each
+ *	  pass makes progress even when the hash bits run out.
+ *
+ *	  While processing a batch, only the transition values of the batch's
+ *	  grouping set are advanced; the per-group pointers of the other hashed
+ *	  sets are NULL, which makes the transition expression skip them (see
+ *	  EEOP_AGG_PLAIN_PERGROUP_NULLCHECK).
+ *
  *    Transition / Combine function invocation:
  *
  *    For performance reasons transition functions, including combine
@@ -229,8 +254,10 @@
 #include "optimizer/optimizer.h"
 #include "parser/parse_agg.h"
 #include "parser/parse_coerce.h"
+#include "storage/buffile.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/dynahash.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/syscache.h"
@@ -238,6 +265,40 @@
 #include "utils/datum.h"
 
 
+/*
+ * Spill partitions are chosen so that each batch is expected to fit in
+ * memory, with some slack for misestimation.  The number of partitions is
+ * always a power of two, so that they can be selected by hash bits.
+ */
+#define HASHAGG_PARTITION_FACTOR 1.50
+#define HASHAGG_MIN_PARTITIONS 4
+#define HASHAGG_MAX_PARTITIONS 256
+
+/*
+ * Spill files for the tuples of one grouping set that didn't fit in memory.
+ * A partition's file is created when the first tuple is written to it.
+ */
+typedef struct HashAggSpill
+{
+	int			npartitions;	/* number of partitions */
+	BufFile   **partitions;		/* spill file of each partition, or NULL */
+	int64	   *ntuples;		/* number of tuples in each partition */
+	uint32		mask;			/* mask to find partition from hash value */
+	int			shift;			/* after masking, shift by this amount */
+	int			used_bits;		/* hash bits used, including partitioning */
+} HashAggSpill;
+
+/*
+ * A spilled partition waiting to be aggregated, see agg_refill_hash_table().
+ */
+typedef struct HashAggBatch
+{
+	int			setno;			/* grouping set the tuples belong to */
+	int			used_bits;		/* hash bits already used for partitioning */
+	BufFile    *input_file;		/* spilled tuples, with their hash values */
+	int64		input_tuples;	/* number of tuples in input_file */
+} HashAggBatch;
+
 static void select_current_set(AggState *aggstate, int setno, bool is_hash);
 static void initialize_phase(AggState *aggstate, int newphase);
 static TupleTableSlot *fetch_input_tuple(AggState *aggstate);
@@ -271,11 +332,30 @@ static void finalize_aggregates(AggState *aggstate,
 static TupleTableSlot *project_aggregates(AggState *aggstate);
 static Bitmapset *find_unaggregated_cols(AggState *aggstate);
 static bool find_unaggregated_cols_walker(Node *node, Bitmapset **colnos);
-static void build_hash_table(AggState *aggstate);
-static TupleHashEntryData *lookup_hash_entry(AggState *aggstate);
+static void build_hash_tables(AggState *aggstate);
+static void build_hash_table(AggState *aggstate, int setno, long nbuckets);
+static long hash_choose_num_buckets(AggState *aggstate, double ngroups);
+static void prepare_hash_slot(AggState *aggstate);
+static TupleHashEntryData *lookup_hash_entry(AggState *aggstate, uint32 hash);
 static void lookup_hash_entries(AggState *aggstate);
+static Size hash_agg_memory_used(AggState *aggstate);
+static void hash_agg_update_metrics(AggState *aggstate);
+static void hash_agg_check_limits(AggState *aggstate);
+static void hash_agg_enter_spill_mode(AggState *aggstate);
+static int	hash_choose_num_partitions(AggState *aggstate, double input_groups,
+									   int used_bits, int *log2_npartitions);
+static void hashagg_spill_init(AggState *aggstate, HashAggSpill *spill,
+							   int used_bits, double input_groups);
+static void hashagg_spill_tuple(AggState *aggstate, HashAggSpill *spill,
+								TupleTableSlot *slot, uint32 hash);
+static void hashagg_spill_finish(AggState *aggstate, HashAggSpill *spill,
+								 int setno);
+static void hashagg_finish_initial_spills(AggState *aggstate);
+static void hashagg_reset_spill_state(AggState *aggstate);
+static MinimalTuple hashagg_batch_read(HashAggBatch *batch, uint32 *hashp);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static void agg_fill_hash_table(AggState *aggstate);
+static bool agg_refill_hash_table(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
 static Datum GetAggInitVal(Datum textInitVal, Oid transtype);
 static void build_pertrans_for_aggref(AggStatePerTrans pertrans,
@@ -1258,44 +1338,82 @@ find_unaggregated_cols_walker(Node *node, Bitmapset **colnos)
  *
  * The contents of the hash tables always live in the hashcontext's per-tuple
  * memory context (there is only one of these for all tables together, since
- * they are all reset at the same time).
+ * they are all reset at the same time).  The tables themselves, including
+ * their bucket arrays, live in hash_metacxt, so that all of the memory they
+ * use can be measured.
  */
 static void
-build_hash_table(AggState *aggstate)
+build_hash_tables(AggState *aggstate)
 {
-	MemoryContext tmpmem = aggstate->tmpcontext->ecxt_per_tuple_memory;
-	Size		additionalsize;
-	int			i;
+	int			setno;
 
 	Assert(aggstate->aggstrategy == AGG_HASHED || aggstate->aggstrategy == AGG_MIXED);
 
-	additionalsize = aggstate->numtrans * sizeof(AggStatePerGroupData);
-
-	for (i = 0; i < aggstate->num_hashes; ++i)
+	for (setno = 0; setno < aggstate->num_hashes; ++setno)
 	{
-		AggStatePerHash perhash = &aggstate->perhash[i];
+		AggStatePerHash perhash = &aggstate->perhash[setno];
 
 		Assert(perhash->aggnode->numGroups > 0);
 
 		if (perhash->hashtable)
 			ResetTupleHashTable(perhash->hashtable);
 		else
-			perhash->hashtable = BuildTupleHashTableExt(&aggstate->ss.ps,
-														perhash->hashslot->tts_tupleDescriptor,
-														perhash->numCols,
-														perhash->hashGrpColIdxHash,
-														perhash->eqfuncoids,
-														perhash->hashfunctions,
-														perhash->aggnode->grpCollations,
-														perhash->aggnode->numGroups,
-														additionalsize,
-														aggstate->ss.ps.state->es_query_cxt,
-														aggstate->hashcontext->ecxt_per_tuple_memory,
-														tmpmem,
-														DO_AGGSPLIT_SKIPFINAL(aggstate->aggsplit));
+			build_hash_table(aggstate, setno,
+							 hash_choose_num_buckets(aggstate,
+													 perhash->aggnode->numGroups));
 	}
 }
 
+/*
+ * Build the hash table for one grouping set.
+ */
+static void
+build_hash_table(AggState *aggstate, int setno, long nbuckets)
+{
+	AggStatePerHash perhash = &aggstate->perhash[setno];
+	MemoryContext tmpmem = aggstate->tmpcontext->ecxt_per_tuple_memory;
+	Size		additionalsize;
+
+	additionalsize = aggstate->numtrans * sizeof(AggStatePerGroupData);
+
+	perhash->hashtable = BuildTupleHashTableExt(&aggstate->ss.ps,
+												perhash->hashslot->tts_tupleDescriptor,
+												perhash->numCols,
+												perhash->hashGrpColIdxHash,
+												perhash->eqfuncoids,
+												perhash->hashfunctions,
+												perhash->aggnode->grpCollations,
+												nbuckets,
+												additionalsize,
+												aggstate->hash_metacxt,
+												aggstate->hashcontext->ecxt_per_tuple_memory,
+												tmpmem,
+												DO_AGGSPLIT_SKIPFINAL(aggstate->aggsplit));
+}
+
+/*
+ * Choose the initial number of buckets for a hash table expected to hold
+ * ngroups groups.  The bucket array counts against the memory limit, so it's
+ * not allowed to take more than a small fraction of it up front; the table
+ * grows if more groups show up.
+ */
+static long
+hash_choose_num_buckets(AggState *aggstate, double ngroups)
+{
+	long		max_nbuckets;
+	long		nbuckets;
+
+	max_nbuckets = aggstate->hash_mem_limit / (8 * sizeof(TupleHashEntryData));
+	max_nbuckets = Max(max_nbuckets, 1);
+
+	if (ngroups > max_nbuckets)
+		nbuckets = max_nbuckets;
+	else
+		nbuckets = Max((long) ngroups, 1);
+
+	return nbuckets;
+}
+
 /*
  * Compute columns that actually need to be stored in hashtable entries.  The
  * incoming tuples from the child plan node will contain grouping columns,
@@ -1455,21 +1573,16 @@ hash_agg_entry_size(int numAggs)
 }
 
 /*
- * Find or create a hashtable entry for the tuple group containing the current
- * tuple (already set in tmpcontext's outertuple slot), in the current grouping
- * set (which the caller must have selected - note that initialize_aggregate
- * depends on this).
- *
- * When called, CurrentMemoryContext should be the per-query context.
+ * Transfer the grouping columns of the current tuple (already set in
+ * tmpcontext's outertuple slot) into the hashslot of the current grouping
+ * set.
  */
-static TupleHashEntryData *
-lookup_hash_entry(AggState *aggstate)
+static void
+prepare_hash_slot(AggState *aggstate)
 {
 	TupleTableSlot *inputslot = aggstate->tmpcontext->ecxt_outertuple;
 	AggStatePerHash perhash = &aggstate->perhash[aggstate->current_set];
 	TupleTableSlot *hashslot = perhash->hashslot;
-	TupleHashEntryData *entry;
-	bool		isnew;
 	int			i;
 
 	/* transfer just the needed columns into hashslot */
@@ -1484,9 +1597,31 @@ lookup_hash_entry(AggState *aggstate)
 		hashslot->tts_isnull[i] = inputslot->tts_isnull[varNumber];
 	}
 	ExecStoreVirtualTuple(hashslot);
+}
+
+/*
+ * Find or create a hashtable entry for the tuple group containing the current
+ * tuple, in the current grouping set (which the caller must have selected -
+ * note that initialize_aggregate depends on this).  prepare_hash_slot() must
+ * have been called, and hash must be the hash value of the hashslot.
+ *
+ * In spill mode, no new entries are created; NULL is returned if the group
+ * isn't already in the hash table, and the caller must spill the tuple.
+ *
+ * When called, CurrentMemoryContext should be the per-query context.
+ */
+static TupleHashEntryData *
+lookup_hash_entry(AggState *aggstate, uint32 hash)
+{
+	AggStatePerHash perhash = &aggstate->perhash[aggstate->current_set];
+	TupleTableSlot *hashslot = perhash->hashslot;
+	TupleHashEntryData *entry;
+	bool		isnew = false;
 
 	/* find or create the hashtable entry using the filtered tuple */
-	entry = LookupTupleHashEntry(perhash->hashtable, hashslot, &isnew);
+	entry = LookupTupleHashEntryHash(perhash->hashtable, hashslot,
+									 aggstate->hash_spill_mode ? NULL : &isnew,
+									 hash);
 
 	if (isnew)
 	{
@@ -1509,6 +1644,9 @@ lookup_hash_entry(AggState *aggstate)
 
 			initialize_aggregate(aggstate, pertrans, pergroupstate);
 		}
+
+		aggstate->hash_ngroups_current++;
+		hash_agg_check_limits(aggstate);
 	}
 
 	return entry;
@@ -1517,6 +1655,8 @@ lookup_hash_entry(AggState *aggstate)
 /*
  * Look up hash entries for the current tuple in all hashed grouping sets,
  * returning an array of pergroup pointers suitable for advance_aggregates.
+ * If a grouping set has no entry for the tuple because we're in spill mode,
+ * the tuple is spilled for that set and its pergroup pointer is set to NULL.
  *
  * Be aware that lookup_hash_entry can reset the tmpcontext.
  */
@@ -1529,9 +1669,370 @@ lookup_hash_entries(AggState *aggstate)
 
 	for (setno = 0; setno < numHashes; setno++)
 	{
+		AggStatePerHash perhash = &aggstate->perhash[setno];
+		TupleHashEntryData *entry;
+		uint32		hash;
+
 		select_current_set(aggstate, setno, true);
-		pergroup[setno] = lookup_hash_entry(aggstate)->additional;
+		prepare_hash_slot(aggstate);
+		hash = TupleHashTableHash(perhash->hashtable, perhash->hashslot);
+		entry = lookup_hash_entry(aggstate, hash);
+
+		if (entry != NULL)
+			pergroup[setno] = entry->additional;
+		else
+		{
+			HashAggSpill *spill = &aggstate->hash_spills[setno];
+
+			if (spill->partitions == NULL)
+				hashagg_spill_init(aggstate, spill, 0,
+								   perhash->aggnode->numGroups);
+
+			hashagg_spill_tuple(aggstate, spill,
+								aggstate->tmpcontext->ecxt_outertuple, hash);
+			pergroup[setno] = NULL;
+		}
+	}
+}
+
+/*
+ * Memory currently used by the hash tables: their bucket arrays, the group
+ * entries and representative tuples, and the transition values.
+ */
+static Size
+hash_agg_memory_used(AggState *aggstate)
+{
+	return MemoryContextMemAllocated(aggstate->hash_metacxt, true) +
+		MemoryContextMemAllocated(aggstate->hashcontext->ecxt_per_tuple_memory,
+								  true);
+}
+
+/*
+ * Remember the peak memory use of the hash tables, for EXPLAIN ANALYZE.
+ */
+static void
+hash_agg_update_metrics(AggState *aggstate)
+{
+	Size		mem_used = hash_agg_memory_used(aggstate);
+
+	if (mem_used > aggstate->hash_mem_peak)
+		aggstate->hash_mem_peak = mem_used;
+}
+
+/*
+ * Called after a new group has been created.  If the hash tables have
+ * outgrown work_mem, switch to spill mode so that no further groups are
+ * created.
+ */
+static void
+hash_agg_check_limits(AggState *aggstate)
+{
+	Size		mem_used = hash_agg_memory_used(aggstate);
+
+	if (mem_used > aggstate->hash_mem_peak)
+		aggstate->hash_mem_peak = mem_used;
+
+	if (!aggstate->hash_spill_mode && mem_used > aggstate->hash_mem_limit)
+		hash_agg_enter_spill_mode(aggstate);
+}
+
+/*
+ * Enter spill mode.  During the initial pass over the input, set up spill
+ * partitions for every hashed grouping set; while processing a batch,
+ * agg_refill_hash_table() sets up its own.
+ */
+static void
+hash_agg_enter_spill_mode(AggState *aggstate)
+{
+	aggstate->hash_spill_mode = true;
+
+	if (!aggstate->hash_ever_spilled)
+	{
+		aggstate->hash_ever_spilled = true;
+		aggstate->hash_spills = (HashAggSpill *)
+			MemoryContextAllocZero(aggstate->ss.ps.state->es_query_cxt,
+								   sizeof(HashAggSpill) * aggstate->num_hashes);
+	}
+}
+
+/*
+ * Choose the number of partitions to spill input_groups groups into, so that
+ * each partition is expected to fit in memory.  The size of a group is
+ * estimated from the memory used by the groups created so far.
+ */
+static int
+hash_choose_num_partitions(AggState *aggstate, double input_groups,
+						   int used_bits, int *log2_npartitions)
+{
+	double		entrysize;
+	double		mem_wanted;
+	double		dpartitions;
+	long		partition_limit;
+	int			npartitions;
+	int			partition_bits;
+
+	entrysize = (double) hash_agg_memory_used(aggstate) /
+		Max(aggstate->hash_ngroups_current, 1);
+	mem_wanted = HASHAGG_PARTITION_FACTOR * input_groups * entrysize;
+
+	/*
+	 * Each open partition has a BLCKSZ write buffer; don't let those take
+	 * more than a quarter of the memory limit.
+	 */
+	partition_limit = aggstate->hash_mem_limit / 4 / BLCKSZ;
+
+	dpartitions = 1 + mem_wanted / aggstate->hash_mem_limit;
+	if (dpartitions > partition_limit)
+		dpartitions = partition_limit;
+	if (dpartitions < HASHAGG_MIN_PARTITIONS)
+		dpartitions = HASHAGG_MIN_PARTITIONS;
+	if (dpartitions > HASHAGG_MAX_PARTITIONS)
+		dpartitions = HASHAGG_MAX_PARTITIONS;
+	npartitions = (int) dpartitions;
+
+	/* round up to a power of two, within the hash bits left over */
+	partition_bits = my_log2(npartitions);
+	if (partition_bits + used_bits > 32)
+		partition_bits = 32 - used_bits;
+
+	*log2_npartitions = partition_bits;
+	return 1 << partition_bits;
+}
+
+/*
+ * Set up spill partitions for a grouping set.  used_bits is the number of
+ * hash bits that were already used to partition the input.
+ */
+static void
+hashagg_spill_init(AggState *aggstate, HashAggSpill *spill, int used_bits,
+				   double input_groups)
+{
+	MemoryContext cxt = aggstate->ss.ps.state->es_query_cxt;
+	int			npartitions;
+	int			partition_bits;
+
+	npartitions = hash_choose_num_partitions(aggstate, input_groups,
+											 used_bits, &partition_bits);
+
+	spill->npartitions = npartitions;
+	spill->partitions = (BufFile **)
+		MemoryContextAllocZero(cxt, sizeof(BufFile *) * npartitions);
+	spill->ntuples = (int64 *)
+		MemoryContextAllocZero(cxt, sizeof(int64) * npartitions);
+	spill->used_bits = used_bits + partition_bits;
+
+	if (partition_bits > 0)
+	{
+		spill->shift = 32 - used_bits - partition_bits;
+		spill->mask = ((uint32) npartitions - 1) << spill->shift;
+	}
+	else
+	{
+		spill->shift = 0;
+		spill->mask = 0;
+	}
+}
+
+/*
+ * Write a tuple to the spill partition selected by its hash value.  The
+ * hash value is saved along with the tuple, so that it needn't be
+ * recomputed when the tuple is read back.
+ */
+static void
+hashagg_spill_tuple(AggState *aggstate, HashAggSpill *spill,
+					TupleTableSlot *slot, uint32 hash)
+{
+	int			partition;
+	BufFile    *file;
+	MinimalTuple tuple;
+	bool		shouldFree;
+	size_t		written;
+
+	partition = (hash & spill->mask) >> spill->shift;
+	file = spill->partitions[partition];
+
+	if (file == NULL)
+	{
+		MemoryContext oldcxt;
+
+		/* First write to this partition, so open it. */
+		oldcxt = MemoryContextSwitchTo(aggstate->ss.ps.state->es_query_cxt);
+		file = BufFileCreateTemp(false);
+		MemoryContextSwitchTo(oldcxt);
+		spill->partitions[partition] = file;
+	}
+
+	tuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+
+	written = BufFileWrite(file, (void *) &hash, sizeof(uint32));
+	if (written != sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to hash-aggregate temporary file: %m")));
+
+	written = BufFileWrite(file, (void *) tuple, tuple->t_len);
+	if (written != tuple->t_len)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to hash-aggregate temporary file: %m")));
+
+	spill->ntuples[partition]++;
+
+	if (shouldFree)
+		pfree(tuple);
+}
+
+/*
+ * Turn the non-empty partitions of a spill into batches to be processed by
+ * agg_refill_hash_table().
+ */
+static void
+hashagg_spill_finish(AggState *aggstate, HashAggSpill *spill, int setno)
+{
+	int			i;
+
+	if (spill->partitions == NULL)
+		return;
+
+	for (i = 0; i < spill->npartitions; i++)
+	{
+		BufFile    *file = spill->partitions[i];
+		HashAggBatch *batch;
+
+		if (file == NULL)
+			continue;
+
+		aggstate->hash_disk_used += (BufFileSize(file) + 1023) / 1024;
+
+		if (BufFileSeek(file, 0, 0L, SEEK_SET))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not rewind hash-aggregate temporary file: %m")));
+
+		batch = (HashAggBatch *)
+			MemoryContextAlloc(aggstate->ss.ps.state->es_query_cxt,
+							   sizeof(HashAggBatch));
+		batch->setno = setno;
+		batch->used_bits = spill->used_bits;
+		batch->input_file = file;
+		batch->input_tuples = spill->ntuples[i];
+
+		/* process the most recently spilled batches first */
+		aggstate->hash_batches = lcons(batch, aggstate->hash_batches);
+	}
+
+	pfree(spill->partitions);
+	pfree(spill->ntuples);
+	spill->partitions = NULL;
+	spill->ntuples = NULL;
+}
+
+/*
+ * Called once the input of the initial pass is exhausted: turn whatever was
+ * spilled into batches, and leave spill mode.
+ */
+static void
+hashagg_finish_initial_spills(AggState *aggstate)
+{
+	int			setno;
+
+	if (aggstate->hash_spills != NULL)
+	{
+		for (setno = 0; setno < aggstate->num_hashes; setno++)
+			hashagg_spill_finish(aggstate, &aggstate->hash_spills[setno],
+								 setno);
+
+		pfree(aggstate->hash_spills);
+		aggstate->hash_spills = NULL;
 	}
+
+	hash_agg_update_metrics(aggstate);
+	aggstate->hash_spill_mode = false;
+	aggstate->hash_batches_used++;
+}
+
+/*
+ * Close any spill files and forget any batches not processed yet.
+ */
+static void
+hashagg_reset_spill_state(AggState *aggstate)
+{
+	ListCell   *lc;
+
+	if (aggstate->hash_spills != NULL)
+	{
+		int			setno;
+
+		for (setno = 0; setno < aggstate->num_hashes; setno++)
+		{
+			HashAggSpill *spill = &aggstate->hash_spills[setno];
+			int			i;
+
+			if (spill->partitions == NULL)
+				continue;
+
+			for (i = 0; i < spill->npartitions; i++)
+			{
+				if (spill->partitions[i] != NULL)
+					BufFileClose(spill->partitions[i]);
+			}
+			pfree(spill->partitions);
+			pfree(spill->ntuples);
+		}
+
+		pfree(aggstate->hash_spills);
+		aggstate->hash_spills = NULL;
+	}
+
+	foreach(lc, aggstate->hash_batches)
+	{
+		HashAggBatch *batch = (HashAggBatch *) lfirst(lc);
+
+		BufFileClose(batch->input_file);
+		pfree(batch);
+	}
+	list_free(aggstate->hash_batches);
+	aggstate->hash_batches = NIL;
+
+	aggstate->hash_ever_spilled = false;
+	aggstate->hash_spill_mode = false;
+	aggstate->hash_ngroups_current = 0;
+}
+
+/*
+ * Read the next tuple from a batch's file, returning NULL at the end.  The
+ * tuple is palloc'd in the current memory context.
+ */
+static MinimalTuple
+hashagg_batch_read(HashAggBatch *batch, uint32 *hashp)
+{
+	uint32		header[2];
+	size_t		nread;
+	MinimalTuple tuple;
+
+	/*
+	 * Since both the hash value and the MinimalTuple length word are uint32,
+	 * we can read them both in one BufFileRead() call.
+	 */
+	nread = BufFileRead(batch->input_file, (void *) header, sizeof(header));
+	if (nread == 0)				/* end of file */
+		return NULL;
+	if (nread != sizeof(header))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from hash-aggregate temporary file: %m")));
+	*hashp = header[0];
+	tuple = (MinimalTuple) palloc(header[1]);
+	tuple->t_len = header[1];
+	nread = BufFileRead(batch->input_file,
+						(void *) ((char *) tuple + sizeof(uint32)),
+						header[1] - sizeof(uint32));
+	if (nread != header[1] - sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from hash-aggregate temporary file: %m")));
+
+	return tuple;
 }
 
 /*
@@ -1683,6 +2184,7 @@ agg_retrieve_direct(AggState *aggstate)
 				 * Mixed mode; we've output all the grouped stuff and have
 				 * full hashtables, so switch to outputting those.
 				 */
+				hashagg_finish_initial_spills(aggstate);
 				initialize_phase(aggstate, 0);
 				aggstate->table_filled = true;
 				ResetTupleHashIterator(aggstate->perhash[0].hashtable,
@@ -1955,6 +2457,9 @@ agg_fill_hash_table(AggState *aggstate)
 		ResetExprContext(aggstate->tmpcontext);
 	}
 
+	/* finalize spills, if any */
+	hashagg_finish_initial_spills(aggstate);
+
 	aggstate->table_filled = true;
 	/* Initialize to walk the first hash table */
 	select_current_set(aggstate, 0, true);
@@ -1962,6 +2467,111 @@ agg_fill_hash_table(AggState *aggstate)
 						   &aggstate->perhash[0].hashiter);
 }
 
+/*
+ * After the groups in memory have been emitted, load the next spilled batch
+ * into the hash table of its grouping set.  Tuples whose groups don't fit are
+ * spilled again, partitioned by further bits of their hash values.
+ *
+ * Returns false if there are no more batches.
+ */
+static bool
+agg_refill_hash_table(AggState *aggstate)
+{
+	HashAggBatch *batch;
+	HashAggSpill spill;
+	bool		spill_initialized = false;
+	AggStatePerHash perhash;
+	TupleTableSlot *slot = aggstate->hash_spill_slot;
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	MinimalTuple tuple;
+	uint32		hash;
+	int			setno;
+
+	if (aggstate->hash_batches == NIL)
+		return false;
+
+	batch = (HashAggBatch *) linitial(aggstate->hash_batches);
+	aggstate->hash_batches = list_delete_first(aggstate->hash_batches);
+
+	/*
+	 * Free the groups already emitted, and start over with empty hash
+	 * tables.  The tables are rebuilt rather than reset, so that the bucket
+	 * array is sized for this batch rather than for the whole input.
+	 */
+	ReScanExprContext(aggstate->hashcontext);
+	MemoryContextReset(aggstate->hash_metacxt);
+	for (setno = 0; setno < aggstate->num_hashes; setno++)
+	{
+		long		nbuckets = 1;
+
+		if (setno == batch->setno)
+			nbuckets = hash_choose_num_buckets(aggstate, batch->input_tuples);
+		build_hash_table(aggstate, setno, nbuckets);
+
+		/* only the batch's grouping set is advanced */
+		aggstate->hash_pergroup[setno] = NULL;
+	}
+
+	aggstate->hash_ngroups_current = 0;
+	aggstate->hash_spill_mode = false;
+
+	select_current_set(aggstate, batch->setno, true);
+	perhash = &aggstate->perhash[batch->setno];
+
+	while ((tuple = hashagg_batch_read(batch, &hash)) != NULL)
+	{
+		TupleHashEntryData *entry;
+
+		CHECK_FOR_INTERRUPTS();
+
+		ExecStoreMinimalTuple(tuple, slot, true);
+		tmpcontext->ecxt_outertuple = slot;
+
+		prepare_hash_slot(aggstate);
+		entry = lookup_hash_entry(aggstate, hash);
+
+		if (entry != NULL)
+		{
+			/* Advance the aggregates (or combine functions) */
+			aggstate->hash_pergroup[batch->setno] = entry->additional;
+			advance_aggregates(aggstate);
+		}
+		else
+		{
+			if (!spill_initialized)
+			{
+				spill_initialized = true;
+				hashagg_spill_init(aggstate, &spill, batch->used_bits,
+								   batch->input_tuples);
+			}
+			hashagg_spill_tuple(aggstate, &spill, slot, hash);
+		}
+
+		/*
+		 * Reset per-input-tuple context after each tuple, but note that the
+		 * hash lookups do this too
+		 */
+		ResetExprContext(aggstate->tmpcontext);
+	}
+
+	ExecClearTuple(slot);
+	BufFileClose(batch->input_file);
+
+	if (spill_initialized)
+		hashagg_spill_finish(aggstate, &spill, batch->setno);
+
+	hash_agg_update_metrics(aggstate);
+	aggstate->hash_spill_mode = false;
+	aggstate->hash_batches_used++;
+
+	pfree(batch);
+
+	/* Initialize to walk the hash table of the batch's grouping set */
+	ResetTupleHashIterator(perhash->hashtable, &perhash->hashiter);
+
+	return true;
+}
+
 /*
  * ExecAgg for hashed case: retrieving groups from hash table
  */
@@ -2024,9 +2634,19 @@ agg_retrieve_hash_table(AggState *aggstate)
 
 				continue;
 			}
+			else if (agg_refill_hash_table(aggstate))
+			{
+				/*
+				 * Loaded a spilled batch into the hash table of its grouping
+				 * set; the other tables are empty.
+				 */
+				perhash = &aggstate->perhash[aggstate->current_set];
+
+				continue;
+			}
 			else
 			{
-				/* No more hashtables, so done */
+				/* No more hashtables or batches, so done */
 				aggstate->agg_done = true;
 				return NULL;
 			}
@@ -2213,6 +2833,11 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	{
 		ExecAssignExprContext(estate, &aggstate->ss.ps);
 		aggstate->hashcontext = aggstate->ss.ps.ps_ExprContext;
+
+		/* the hash tables' own memory, see build_hash_tables() */
+		aggstate->hash_metacxt = AllocSetContextCreate(CurrentMemoryContext,
+													   "HashAgg meta context",
+													   ALLOCSET_DEFAULT_SIZES);
 	}
 
 	ExecAssignExprContext(estate, &aggstate->ss.ps);
@@ -2238,6 +2863,18 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		aggstate->sort_slot = ExecInitExtraTupleSlot(estate, scanDesc,
 													 &TTSOpsMinimalTuple);
 
+	/*
+	 * With hashing, input tuples may be read back from spill files, through
+	 * a slot that's not of the outer plan's type.
+	 */
+	if (use_hashing)
+	{
+		aggstate->hash_spill_slot = ExecInitExtraTupleSlot(estate, scanDesc,
+														   &TTSOpsMinimalTuple);
+		aggstate->ss.ps.outeropsset = true;
+		aggstate->ss.ps.outeropsfixed = false;
+	}
+
 	/*
 	 * Initialize result type, slot and projection.
 	 */
@@ -2466,8 +3103,10 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		/* this is an array of pointers, not structures */
 		aggstate->hash_pergroup = pergroups;
 
+		aggstate->hash_mem_limit = work_mem * 1024L;
+
 		find_hash_columns(aggstate);
-		build_hash_table(aggstate);
+		build_hash_tables(aggstate);
 		aggstate->table_filled = false;
 	}
 
@@ -2853,11 +3492,12 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		else if (aggstate->aggstrategy == AGG_MIXED && phaseidx == 0)
 		{
 			/*
-			 * No need to compute a transition function for an AGG_MIXED phase
-			 * 0 - the contents of the hashtables will have been computed
-			 * during phase 1.
+			 * The hashtables of an AGG_MIXED agg are filled during phase 1,
+			 * but phase 0 needs a hash-only transition function to aggregate
+			 * any batches that were spilled to disk.
 			 */
-			continue;
+			dohash = true;
+			dosort = false;
 		}
 		else if (phase->aggstrategy == AGG_PLAIN ||
 				 phase->aggstrategy == AGG_SORTED)
@@ -3385,6 +4025,14 @@ ExecEndAgg(AggState *node)
 	if (node->hashcontext)
 		ReScanExprContext(node->hashcontext);
 
+	/* Release spill files and the hash tables */
+	hashagg_reset_spill_state(node);
+	if (node->hash_metacxt != NULL)
+	{
+		MemoryContextDelete(node->hash_metacxt);
+		node->hash_metacxt = NULL;
+	}
+
 	/*
 	 * We don't actually free any ExprContexts here (see comment in
 	 * ExecFreeExprContext), just unlinking the output one from the plan node
@@ -3423,12 +4071,13 @@ ExecReScanAgg(AggState *node)
 			return;
 
 		/*
-		 * If we do have the hash table, and the subplan does not have any
-		 * parameter changes, and none of our own parameter changes affect
-		 * input expressions of the aggregated functions, then we can just
-		 * rescan the existing hash table; no need to build it again.
+		 * If we do have the hash table, it never spilled to disk (so it
+		 * holds all the groups), and the subplan does not have any parameter
+		 * changes, and none of our own parameter changes affect input
+		 * expressions of the aggregated functions, then we can just rescan
+		 * the existing hash table; no need to build it again.
 		 */
-		if (outerPlan->chgParam == NULL &&
+		if (outerPlan->chgParam == NULL && !node->hash_ever_spilled &&
 			!bms_overlap(node->ss.ps.chgParam, aggnode->aggParams))
 		{
 			ResetTupleHashIterator(node->perhash[0].hashtable,
@@ -3486,8 +4135,21 @@ ExecReScanAgg(AggState *node)
 	if (node->aggstrategy == AGG_HASHED || node->aggstrategy == AGG_MIXED)
 	{
 		ReScanExprContext(node->hashcontext);
+
+		/*
+		 * After spilling, the tables were last sized for a single batch, so
+		 * build them afresh.
+		 */
+		if (node->hash_ever_spilled)
+		{
+			MemoryContextReset(node->hash_metacxt);
+			for (setno = 0; setno < node->num_hashes; setno++)
+				node->perhash[setno].hashtable = NULL;
+		}
+		hashagg_reset_spill_state(node);
+
 		/* Rebuild an empty hash table */
-		build_hash_table(node);
+		build_hash_tables(node);
 		node->table_filled = false;
 		/* iterator will be reset when the table is filled */
 	}
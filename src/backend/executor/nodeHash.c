@@ -140,6 +140,7 @@ MultiExecPrivateHash(HashState *node)
 	PlanState  *outerNode;
 	List	   *hashkeys;
 	HashJoinTable hashtable;
+	HashRuntimeFilter *rtfilter;
 	TupleTableSlot *slot;
 	ExprContext *econtext;
 	uint32		hashvalue;
@@ -149,6 +150,34 @@ MultiExecPrivateHash(HashState *node)
 	 */
 	outerNode = outerPlanState(node);
 	hashtable = node->hashtable;
+	rtfilter = node->rtfilter;
+
+	/*
+	 * If our parent pushed a runtime filter down into its outer side, start
+	 * building a fresh one.  It lives as long as the hash table does, and its
+	 * memory comes out of the hash table's allowance.  Give it two bytes per
+	 * expected inner tuple, as bloom_create() would, or 8kB if that's more,
+	 * as the estimate may be low; but no more than an eighth of the
+	 * allowance.
+	 */
+	if (rtfilter != NULL)
+	{
+		MemoryContext oldcxt;
+		double		ntuples = Max(outerNode->plan->plan_rows, 1.0);
+		Size		filter_bytes;
+
+		filter_bytes = (Size) Min(Max(ntuples * 2, 8192.0),
+								  (double) (hashtable->spaceAllowed / 8));
+		hashtable->spaceAllowed -= filter_bytes;
+
+		oldcxt = MemoryContextSwitchTo(hashtable->hashCxt);
+		rtfilter->hashtable = NULL;
+		rtfilter->bloom = bloom_create_bounded((int64) ntuples, filter_bytes, 0);
+		rtfilter->disabled = false;
+		rtfilter->nprobed = 0;
+		rtfilter->nrejected = 0;
+		MemoryContextSwitchTo(oldcxt);
+	}
 
 	/*
 	 * set expression context
@@ -172,6 +201,10 @@ MultiExecPrivateHash(HashState *node)
 		{
 			int			bucketNumber;
 
+			if (rtfilter != NULL)
+				bloom_add_element(rtfilter->bloom, (unsigned char *) &hashvalue,
+								  sizeof(hashvalue));
+
 			bucketNumber = ExecHashGetSkewBucket(hashtable, hashvalue);
 			if (bucketNumber != INVALID_SKEW_BUCKET_NO)
 			{
@@ -189,6 +222,10 @@ MultiExecPrivateHash(HashState *node)
 		}
 	}
 
+	/* The runtime filter is complete, let the outer side use it */
+	if (rtfilter != NULL)
+		rtfilter->hashtable = hashtable;
+
 	/* resize the hash table if needed (NTUP_PER_BUCKET exceeded) */
 	if (hashtable->nbuckets != hashtable->nbuckets_optimal)
 		ExecHashIncreaseNumBuckets(hashtable);
@@ -1863,6 +1900,53 @@ ExecHashGetHashValue(HashJoinTable hashtable,
 	return true;
 }
 
+/*
+ * ExecHashRuntimeFilterRejects
+ *		Check a tuple against a hash join's runtime filter
+ *
+ * Returns true if the tuple in 'slot', a tuple that a scan below the join's
+ * outer side is about to return, certainly has no join partner.  'keys' are
+ * the join's outer hash keys, expressed in terms of the scan tuple.
+ *
+ * A filter that isn't built yet, or that has disabled itself, rejects
+ * nothing.
+ */
+bool
+ExecHashRuntimeFilterRejects(HashRuntimeFilter *filter,
+							 ExprContext *econtext,
+							 List *keys,
+							 TupleTableSlot *slot)
+{
+	uint32		hashvalue;
+
+	if (filter->hashtable == NULL || filter->disabled)
+		return false;
+
+	/*
+	 * Once we've seen a reasonable sample, give up on the filter if it
+	 * doesn't reject enough tuples to pay for itself.
+	 */
+	if (filter->nprobed == HJ_RUNTIME_FILTER_SAMPLE &&
+		filter->nrejected < filter->nprobed * HJ_RUNTIME_FILTER_MIN_REJECTED)
+	{
+		filter->disabled = true;
+		return false;
+	}
+	filter->nprobed++;
+
+	econtext->ecxt_scantuple = slot;
+	if (!ExecHashGetHashValue(filter->hashtable, econtext, keys,
+							  true, false, &hashvalue) ||
+		bloom_lacks_element(filter->bloom, (unsigned char *) &hashvalue,
+							sizeof(hashvalue)))
+	{
+		filter->nrejected++;
+		return true;
+	}
+
+	return false;
+}
+
 /*
  * ExecHashGetBucketAndBatch
  *		Determine the bucket number and batch number for a hash value
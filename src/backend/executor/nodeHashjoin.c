@@ -118,6 +118,10 @@
 #include "utils/sharedtuplestore.h"
 
 
+/* GUC parameter */
+bool		hashjoin_runtime_filter = false;
+
+
 /*
  * States of the ExecHashJoin state machine
  */
@@ -146,6 +150,11 @@ static TupleTableSlot *ExecHashJoinGetSavedTuple(HashJoinState *hjstate,
 static bool ExecHashJoinNewBatch(HashJoinState *hjstate);
 static bool ExecParallelHashJoinNewBatch(HashJoinState *hjstate);
 static void ExecParallelHashJoinPartitionOuter(HashJoinState *node);
+static void ExecHashJoinInitRuntimeFilter(HashJoinState *hjstate,
+										  HashJoin *node);
+static bool ExecHashJoinPushRuntimeFilter(PlanState *planstate,
+										  List *attnos,
+										  HashRuntimeFilter *filter);
 
 
 /* ----------------------------------------------------------------
@@ -761,6 +770,9 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	/* child Hash node needs to evaluate inner hash keys, too */
 	((HashState *) innerPlanState(hjstate))->hashkeys = rhclauses;
 
+	if (hashjoin_runtime_filter)
+		ExecHashJoinInitRuntimeFilter(hjstate, node);
+
 	hjstate->hj_JoinState = HJ_BUILD_HASHTABLE;
 	hjstate->hj_MatchedOuter = false;
 	hjstate->hj_OuterNotEmpty = false;
@@ -785,6 +797,8 @@ ExecEndHashJoin(HashJoinState *node)
 		ExecHashTableDestroy(node->hj_HashTable);
 		node->hj_HashTable = NULL;
 	}
+	if (node->hj_RuntimeFilter)
+		node->hj_RuntimeFilter->hashtable = NULL;
 
 	/*
 	 * Free the exprcontext
@@ -805,6 +819,114 @@ ExecEndHashJoin(HashJoinState *node)
 	ExecEndNode(innerPlanState(node));
 }
 
+/*
+ * ExecHashJoinInitRuntimeFilter
+ *
+ *		Set up a runtime filter for the join, and push it down into the
+ *		scans that produce the outer relation, if possible.  See
+ *		HashRuntimeFilter in hashjoin.h.
+ */
+static void
+ExecHashJoinInitRuntimeFilter(HashJoinState *hjstate, HashJoin *node)
+{
+	HashState  *hashstate = (HashState *) innerPlanState(hjstate);
+	HashRuntimeFilter *filter;
+	List	   *attnos = NIL;
+	ListCell   *l;
+
+	/* Only joins that discard unmatched outer tuples can use the filter */
+	if (HJ_FILL_OUTER(hjstate))
+		return;
+
+	/* A shared hash table is built piecewise by all the participants */
+	if (hashstate->ps.plan->parallel_aware)
+		return;
+
+	/*
+	 * We only handle outer hash keys that are plain columns of the outer
+	 * relation, which is the common case for the star-schema joins that
+	 * benefit from the filter.
+	 */
+	foreach(l, node->hashclauses)
+	{
+		OpExpr	   *hclause = lfirst_node(OpExpr, l);
+		Var		   *var = (Var *) linitial(hclause->args);
+
+		if (!IsA(var, Var) || var->varno != OUTER_VAR)
+			return;
+		attnos = lappend_int(attnos, var->varattno);
+	}
+
+	filter = palloc0(sizeof(HashRuntimeFilter));
+	if (ExecHashJoinPushRuntimeFilter(outerPlanState(hjstate), attnos, filter))
+	{
+		hjstate->hj_RuntimeFilter = filter;
+		hashstate->rtfilter = filter;
+	}
+	else
+		pfree(filter);
+	list_free(attnos);
+}
+
+/*
+ * ExecHashJoinPushRuntimeFilter
+ *
+ *		Attach a runtime filter to the sequential scans that produce the
+ *		output of 'planstate', looking through Append nodes.  'attnos' are
+ *		the positions of the join's outer hash keys in the output.
+ *
+ * Returns true if the filter was attached to at least one scan.
+ */
+static bool
+ExecHashJoinPushRuntimeFilter(PlanState *planstate, List *attnos,
+							  HashRuntimeFilter *filter)
+{
+	if (IsA(planstate, SeqScanState))
+	{
+		SeqScanState *scanstate = (SeqScanState *) planstate;
+		List	   *keys = NIL;
+		ListCell   *l;
+
+		if (scanstate->rtfilter != NULL)
+			return false;
+
+		/*
+		 * Re-express the hash keys in terms of the scan tuple, using the
+		 * scan's targetlist.
+		 */
+		foreach(l, attnos)
+		{
+			TargetEntry *tle = list_nth(planstate->plan->targetlist,
+										lfirst_int(l) - 1);
+
+			if (!IsA(tle->expr, Var))
+				return false;
+			keys = lappend(keys, ExecInitExpr(tle->expr, planstate));
+		}
+
+		scanstate->rtfilter = filter;
+		scanstate->rtfilter_keys = keys;
+		return true;
+	}
+	else if (IsA(planstate, AppendState))
+	{
+		/* Append's output columns are those of each of its subplans */
+		AppendState *appendstate = (AppendState *) planstate;
+		bool		pushed = false;
+		int			i;
+
+		for (i = 0; i < appendstate->as_nplans; i++)
+		{
+			if (ExecHashJoinPushRuntimeFilter(appendstate->appendplans[i],
+											  attnos, filter))
+				pushed = true;
+		}
+		return pushed;
+	}
+
+	return false;
+}
+
 /*
  * ExecHashJoinOuterGetTuple
  *
@@ -1353,6 +1475,10 @@ ExecReScanHashJoin(HashJoinState *node)
 			node->hj_HashTable = NULL;
 			node->hj_JoinState = HJ_BUILD_HASHTABLE;
 
+			/* the runtime filter went away with the hash table */
+			if (node->hj_RuntimeFilter)
+				node->hj_RuntimeFilter->hashtable = NULL;
+
 			/*
 			 * if chgParam of subnode is not null then plan will be re-scanned
 			 * by first ExecProcNode.
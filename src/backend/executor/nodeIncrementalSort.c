@@ -0,0 +1,484 @@
+/*-------------------------------------------------------------------------
+ *
+ * nodeIncrementalSort.c
+ *	  Routines to handle incremental sorting of relations.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/nodeIncrementalSort.c
+ *
+ * DESCRIPTION
+ *
+ *	Incremental sort is an optimized variant of multikey sort for cases
+ *	when the input is already sorted by a prefix of the sort keys.  For
+ *	example, when a sort by (key1, key2 ... keyN) is requested, and the
+ *	input is already sorted by (key1, key2 ... keyM), M < N, we can divide
+ *	the input into groups where keys (key1, ... keyM) are equal, and only
+ *	sort on the remaining columns.
+ *
+ *	Consider the following example.  We have input tuples consisting of
+ *	two integers (X, Y) already presorted by X, while it's required to
+ *	sort them by both X and Y.  Let input tuples be following.
+ *
+ *	(1, 5)
+ *	(1, 2)
+ *	(2, 9)
+ *	(2, 1)
+ *	(2, 5)
+ *	(3, 3)
+ *	(3, 7)
+ *
+ *	An incremental sort algorithm would split the input into the following
+ *	groups, which have equal X, and then sort them by Y individually:
+ *
+ *		(1, 5) (1, 2)
+ *		(2, 9) (2, 1) (2, 5)
+ *		(3, 3) (3, 7)
+ *
+ *	After sorting these groups and putting them altogether, we would get
+ *	the following result which is sorted by X and Y, as requested:
+ *
+ *	(1, 2)
+ *	(1, 5)
+ *	(2, 1)
+ *	(2, 5)
+ *	(2, 9)
+ *	(3, 3)
+ *	(3, 7)
+ *
+ *	Incremental sort may be more efficient than plain sort, particularly
+ *	on large datasets, as it reduces the amount of data to sort at once,
+ *	making it more likely it fits into work_mem (eliminating the need to
+ *	spill to disk).  But the main advantage of incremental sort is that
+ *	it can start producing rows early, before sorting the whole dataset,
+ *	which is a significant benefit especially for queries with LIMIT.
+ *
+ *	Sorting very small groups one at a time would waste a lot of effort
+ *	on setting up and tearing down the tuplesort, so we always collect at
+ *	least MIN_GROUP_SIZE tuples into a batch, and then keep adding tuples
+ *	until the presorted columns change.  Each batch is sorted on all the
+ *	sort keys, which is correct because a batch always ends on a boundary
+ *	between two groups.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "executor/execdebug.h"
+#include "executor/nodeIncrementalSort.h"
+#include "miscadmin.h"
+#include "utils/lsyscache.h"
+#include "utils/tuplesort.h"
+
+/*
+ * Minimum number of tuples collected into one batch before we start looking
+ * for a change in the presorted columns.
+ */
+#define MIN_GROUP_SIZE 32
+
+
+/* ----------------------------------------------------------------
+ *		preparePresortedCols
+ *
+ *		Build the expression used to check whether two tuples have the same
+ *		values in the presorted columns.
+ * ----------------------------------------------------------------
+ */
+static void
+preparePresortedCols(IncrementalSortState *node)
+{
+	IncrementalSort *plannode = (IncrementalSort *) node->ss.ps.plan;
+	int			nPresortedCols = plannode->nPresortedCols;
+	Oid		   *eqOperators;
+	int			i;
+
+	eqOperators = (Oid *) palloc(nPresortedCols * sizeof(Oid));
+
+	for (i = 0; i < nPresortedCols; i++)
+	{
+		Oid			sortop = plannode->sort.sortOperators[i];
+
+		eqOperators[i] = get_equality_op_for_ordering_op(sortop, NULL);
+		if (!OidIsValid(eqOperators[i]))
+			elog(ERROR, "missing equality operator for ordering operator %u",
+				 sortop);
+	}
+
+	node->presortedEq =
+		execTuplesMatchPrepare(ExecGetResultType(outerPlanState(node)),
+							   nPresortedCols,
+							   plannode->sort.sortColIdx,
+							   eqOperators,
+							   plannode->sort.collations,
+							   &node->ss.ps);
+}
+
+/* ----------------------------------------------------------------
+ *		isCurrentGroup
+ *
+ *		Check whether a given tuple belongs to the current batch, i.e.
+ *		whether its presorted columns match those of the pivot tuple.
+ * ----------------------------------------------------------------
+ */
+static bool
+isCurrentGroup(IncrementalSortState *node, TupleTableSlot *tupleSlot)
+{
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+
+	econtext->ecxt_innertuple = node->group_pivot;
+	econtext->ecxt_outertuple = tupleSlot;
+
+	return ExecQualAndReset(node->presortedEq, econtext);
+}
+
+/* ----------------------------------------------------------------
+ *		instrumentSortedBatch
+ *
+ *		Accumulate the statistics of a sorted batch.
+ * ----------------------------------------------------------------
+ */
+static void
+instrumentSortedBatch(IncrementalSortState *node, Tuplesortstate *sortstate)
+{
+	IncrementalSortInfo *info = &node->incsort_info;
+	TuplesortInstrumentation stats;
+
+	tuplesort_get_stats(sortstate, &stats);
+
+	info->groupCount++;
+	info->sortMethods |= (1 << stats.sortMethod);
+
+	if (stats.spaceType == SORT_SPACE_TYPE_DISK)
+	{
+		info->totalDiskSpaceUsed += stats.spaceUsed;
+		if (stats.spaceUsed > info->maxDiskSpaceUsed)
+			info->maxDiskSpaceUsed = stats.spaceUsed;
+	}
+	else
+	{
+		info->totalMemorySpaceUsed += stats.spaceUsed;
+		if (stats.spaceUsed > info->maxMemorySpaceUsed)
+			info->maxMemorySpaceUsed = stats.spaceUsed;
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		sortNextBatch
+ *
+ *		Read the next batch of tuples from the outer plan and sort it.
+ *		Returns false if the outer plan had no more tuples to give.
+ * ----------------------------------------------------------------
+ */
+static bool
+sortNextBatch(IncrementalSortState *node)
+{
+	IncrementalSort *plannode = (IncrementalSort *) node->ss.ps.plan;
+	PlanState  *outerNode = outerPlanState(node);
+	Tuplesortstate *tuplesortstate;
+	int64		minGroupSize = MIN_GROUP_SIZE;
+	int64		nTuples = 0;
+
+	Assert(node->tuplesortstate == NULL);
+
+	tuplesortstate = tuplesort_begin_heap(ExecGetResultType(outerNode),
+										  plannode->sort.numCols,
+										  plannode->sort.sortColIdx,
+										  plannode->sort.sortOperators,
+										  plannode->sort.collations,
+										  plannode->sort.nullsFirst,
+										  work_mem,
+										  NULL, false);
+
+	/*
+	 * If bounded, there's no point in collecting more tuples into a batch
+	 * than we'll ever return.  Groups still have to be read completely
+	 * though, so the bound only limits what the tuplesort keeps.
+	 */
+	if (node->bounded)
+	{
+		int64		remaining = node->bound - node->bound_Done;
+
+		Assert(remaining > 0);
+		tuplesort_set_bound(tuplesortstate, remaining);
+		minGroupSize = Min(minGroupSize, remaining);
+	}
+	node->tuplesortstate = (void *) tuplesortstate;
+
+	/* The first tuple of this batch may already have been read. */
+	if (!TupIsNull(node->transfer_tuple))
+	{
+		tuplesort_puttupleslot(tuplesortstate, node->transfer_tuple);
+		if (++nTuples == minGroupSize)
+			ExecCopySlot(node->group_pivot, node->transfer_tuple);
+		ExecClearTuple(node->transfer_tuple);
+	}
+
+	while (!node->outerNodeDone)
+	{
+		TupleTableSlot *slot = ExecProcNode(outerNode);
+
+		if (TupIsNull(slot))
+		{
+			node->outerNodeDone = true;
+			break;
+		}
+
+		if (nTuples < minGroupSize)
+		{
+			tuplesort_puttupleslot(tuplesortstate, slot);
+			if (++nTuples == minGroupSize)
+				ExecCopySlot(node->group_pivot, slot);
+		}
+		else if (isCurrentGroup(node, slot))
+		{
+			tuplesort_puttupleslot(tuplesortstate, slot);
+			nTuples++;
+		}
+		else
+		{
+			/* Start of the next batch; remember it for the next call. */
+			ExecCopySlot(node->transfer_tuple, slot);
+			break;
+		}
+	}
+
+	ExecClearTuple(node->group_pivot);
+
+	if (nTuples == 0)
+	{
+		tuplesort_end(tuplesortstate);
+		node->tuplesortstate = NULL;
+		return false;
+	}
+
+	SO1_printf("ExecIncrementalSort: sorting batch of " INT64_FORMAT " tuples\n",
+			   nTuples);
+
+	tuplesort_performsort(tuplesortstate);
+	instrumentSortedBatch(node, tuplesortstate);
+
+	return true;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecIncrementalSort
+ *
+ *		Reads the outer subtree one batch of tuples at a time, where each
+ *		batch consists of whole groups of tuples with equal presorted
+ *		columns, sorts the batch using tuplesort and returns its tuples
+ *		before moving on to the next batch.
+ *
+ *		Conditions:
+ *		  -- none.
+ *
+ *		Initial States:
+ *		  -- the outer child is prepared to return the first tuple.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecIncrementalSort(PlanState *pstate)
+{
+	IncrementalSortState *node = castNode(IncrementalSortState, pstate);
+	EState	   *estate = node->ss.ps.state;
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+	ScanDirection dir;
+
+	CHECK_FOR_INTERRUPTS();
+
+	for (;;)
+	{
+		bool		more;
+
+		if (node->tuplesortstate != NULL)
+		{
+			/*
+			 * Return the next tuple of the current batch, if any.  Note that
+			 * we only rely on slot tuple remaining valid until the next fetch
+			 * from the tuplesort.
+			 */
+			if (tuplesort_gettupleslot((Tuplesortstate *) node->tuplesortstate,
+									   true, false, slot, NULL))
+			{
+				node->bound_Done++;
+				return slot;
+			}
+
+			/* current batch is exhausted, get rid of it */
+			tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+			node->tuplesortstate = NULL;
+		}
+
+		if ((node->outerNodeDone && TupIsNull(node->transfer_tuple)) ||
+			(node->bounded && node->bound_Done >= node->bound))
+			return ExecClearTuple(slot);
+
+		/*
+		 * Want to scan subplan in the forward direction while creating the
+		 * sorted data.
+		 */
+		dir = estate->es_direction;
+		estate->es_direction = ForwardScanDirection;
+
+		more = sortNextBatch(node);
+
+		estate->es_direction = dir;
+
+		if (!more)
+			return ExecClearTuple(slot);
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		ExecInitIncrementalSort
+ *
+ *		Creates the run-time state information for the incremental sort
+ *		node produced by the planner and initializes its outer subtree.
+ * ----------------------------------------------------------------
+ */
+IncrementalSortState *
+ExecInitIncrementalSort(IncrementalSort *node, EState *estate, int eflags)
+{
+	IncrementalSortState *incrsortstate;
+
+	SO1_printf("ExecInitIncrementalSort: %s\n",
+			   "initializing sort node");
+
+	/*
+	 * Incremental sort can't be used with EXEC_FLAG_BACKWARD or
+	 * EXEC_FLAG_MARK, because the current batch is all we keep around.
+	 */
+	Assert((eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)) == 0);
+
+	/*
+	 * create state structure
+	 */
+	incrsortstate = makeNode(IncrementalSortState);
+	incrsortstate->ss.ps.plan = (Plan *) node;
+	incrsortstate->ss.ps.state = estate;
+	incrsortstate->ss.ps.ExecProcNode = ExecIncrementalSort;
+
+	incrsortstate->bounded = false;
+	incrsortstate->bound_Done = 0;
+	incrsortstate->outerNodeDone = false;
+	incrsortstate->tuplesortstate = NULL;
+
+	/*
+	 * Miscellaneous initialization
+	 *
+	 * We need an expression context to compare the presorted columns.
+	 */
+	ExecAssignExprContext(estate, &incrsortstate->ss.ps);
+
+	/*
+	 * initialize child nodes
+	 *
+	 * We shield the child node from the need to support REWIND, BACKWARD, or
+	 * MARK/RESTORE.
+	 */
+	eflags &= ~(EXEC_FLAG_REWIND | EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK);
+
+	outerPlanState(incrsortstate) = ExecInitNode(outerPlan(node), estate, eflags);
+
+	/*
+	 * Initialize scan slot and type.
+	 */
+	ExecCreateScanSlotFromOuterPlan(estate, &incrsortstate->ss, &TTSOpsVirtual);
+
+	/*
+	 * Initialize return slot and type. No need to initialize projection info
+	 * because this node doesn't do projections.
+	 */
+	ExecInitResultTupleSlotTL(&incrsortstate->ss.ps, &TTSOpsMinimalTuple);
+	incrsortstate->ss.ps.ps_ProjInfo = NULL;
+
+	/*
+	 * Initialize the slots holding the pivot tuple of the current batch and
+	 * the first tuple of the next one, and the comparator between them.
+	 */
+	incrsortstate->group_pivot =
+		MakeSingleTupleTableSlot(ExecGetResultType(outerPlanState(incrsortstate)),
+								 &TTSOpsMinimalTuple);
+	incrsortstate->transfer_tuple =
+		MakeSingleTupleTableSlot(ExecGetResultType(outerPlanState(incrsortstate)),
+								 &TTSOpsMinimalTuple);
+	preparePresortedCols(incrsortstate);
+
+	SO1_printf("ExecInitIncrementalSort: %s\n",
+			   "sort node initialized");
+
+	return incrsortstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecEndIncrementalSort(node)
+ * ----------------------------------------------------------------
+ */
+void
+ExecEndIncrementalSort(IncrementalSortState *node)
+{
+	SO1_printf("ExecEndIncrementalSort: %s\n",
+			   "shutting down sort node");
+
+	/*
+	 * clean out the tuple table
+	 */
+	ExecClearTuple(node->ss.ss_ScanTupleSlot);
+	/* must drop pointer to sort result tuple */
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	ExecDropSingleTupleTableSlot(node->group_pivot);
+	ExecDropSingleTupleTableSlot(node->transfer_tuple);
+
+	/*
+	 * Release tuplesort resources
+	 */
+	if (node->tuplesortstate != NULL)
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+	node->tuplesortstate = NULL;
+
+	/*
+	 * Free the exprcontext
+	 */
+	ExecFreeExprContext(&node->ss.ps);
+
+	/*
+	 * shut down the subplan
+	 */
+	ExecEndNode(outerPlanState(node));
+
+	SO1_printf("ExecEndIncrementalSort: %s\n",
+			   "sort node shutdown");
+}
+
+void
+ExecReScanIncrementalSort(IncrementalSortState *node)
+{
+	PlanState  *outerPlan = outerPlanState(node);
+
+	/*
+	 * We only ever keep the current batch around, so there's nothing to
+	 * rewind: forget everything and re-read the subplan.
+	 */
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	ExecClearTuple(node->group_pivot);
+	ExecClearTuple(node->transfer_tuple);
+
+	if (node->tuplesortstate != NULL)
+	{
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+		node->tuplesortstate = NULL;
+	}
+
+	node->outerNodeDone = false;
+	node->bound_Done = 0;
+
+	/*
+	 * if chgParam of subnode is not null then plan will be re-scanned by
+	 * first ExecProcNode.
+	 */
+	if (outerPlan->chgParam == NULL)
+		ExecReScan(outerPlan);
+}
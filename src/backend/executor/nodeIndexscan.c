@@ -29,6 +29,8 @@
  */
 #include "postgres.h"
 
+#include <math.h>
+
 #include "access/nbtree.h"
 #include "access/relscan.h"
 #include "access/tableam.h"
@@ -43,6 +45,7 @@
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/spccache.h"
 
 /*
  * When an ordering operator is used, tuples fetched from the index that
@@ -114,6 +117,7 @@ IndexNext(IndexScanState *node)
 								   estate->es_snapshot,
 								   node->iss_NumScanKeys,
 								   node->iss_NumOrderByKeys);
+		index_set_prefetch(scandesc, node->iss_PrefetchMaximum);
 
 		node->iss_ScanDesc = scandesc;
 
@@ -1075,6 +1079,30 @@ ExecInitIndexScan(IndexScan *node, EState *estate, int eflags)
 		indexstate->iss_RuntimeContext = NULL;
 	}
 
+	/*
+	 * Determine how far to read ahead in the index to prefetch heap blocks,
+	 * see index_set_prefetch().  That's not possible if the scan may have to
+	 * move backwards or to restore a marked position, nor when reordering by
+	 * distance.  Reading ahead only one entry isn't worth giving up on
+	 * killing dead index entries, so require an I/O concurrency of more
+	 * than one.
+	 */
+	indexstate->iss_PrefetchMaximum = 0;
+#ifdef USE_PREFETCH
+	if (!(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)) &&
+		indexstate->iss_NumOrderByKeys == 0)
+	{
+		int			io_concurrency;
+		double		maximum;
+
+		io_concurrency =
+			get_tablespace_io_concurrency(currentRelation->rd_rel->reltablespace);
+		if (io_concurrency > 1 &&
+			ComputeIoConcurrency(io_concurrency, &maximum))
+			indexstate->iss_PrefetchMaximum = rint(maximum);
+	}
+#endif							/* USE_PREFETCH */
+
 	/*
 	 * all done.
 	 */
@@ -1684,6 +1712,7 @@ ExecIndexScanInitializeDSM(IndexScanState *node,
 								 node->iss_NumScanKeys,
 								 node->iss_NumOrderByKeys,
 								 piscan);
+	index_set_prefetch(node->iss_ScanDesc, node->iss_PrefetchMaximum);
 
 	/*
 	 * If no run-time keys to calculate or they are ready, go ahead and pass
@@ -1727,6 +1756,7 @@ ExecIndexScanInitializeWorker(IndexScanState *node,
 								 node->iss_NumScanKeys,
 								 node->iss_NumOrderByKeys,
 								 piscan);
+	index_set_prefetch(node->iss_ScanDesc, node->iss_PrefetchMaximum);
 
 	/*
 	 * If no run-time keys to calculate or they are ready, go ahead and pass
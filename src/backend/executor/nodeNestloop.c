@@ -24,9 +24,20 @@
 #include "executor/execdebug.h"
 #include "executor/nodeNestloop.h"
 #include "miscadmin.h"
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
 #include "utils/memutils.h"
 
 
+/* GUC parameter */
+double		adaptive_join_threshold = 1000.0;
+
+static void ExecNestLoopStartHashing(NestLoopState *node);
+static void ExecNestLoopProbeHash(NestLoopState *node);
+static TupleTableSlot *ExecNestLoopNextHashed(NestLoopState *node);
+static bool slot_has_null_key(TupleTableSlot *slot);
+
+
 /* ----------------------------------------------------------------
  *		ExecNestLoop(node)
  *
@@ -121,6 +132,7 @@ ExecNestLoop(PlanState *pstate)
 			econtext->ecxt_outertuple = outerTupleSlot;
 			node->nl_NeedNewOuter = false;
 			node->nl_MatchedOuter = false;
+			node->nl_OuterRows++;
 
 			/*
 			 * fetch the values of any outer Vars that must be passed to the
@@ -146,10 +158,32 @@ ExecNestLoop(PlanState *pstate)
 			}
 
 			/*
-			 * now rescan the inner plan
+			 * If the outer side is returning far more rows than the planner
+			 * expected, rescanning the whole inner side for each of them may
+			 * be ruinous.  If the inner side is materialized anyway, switch
+			 * to hashing it on the equality join clauses.
+			 */
+			if (!node->nl_HashTried && !node->nl_HashAbandoned &&
+				nl->numHashKeys > 0 &&
+				adaptive_join_threshold > 0 &&
+				node->nl_OuterRows > adaptive_join_threshold *
+				Max(outerPlan->plan->plan_rows, 1.0))
+				ExecNestLoopStartHashing(node);
+
+			/*
+			 * now rescan the inner plan, or look up the current outer tuple's
+			 * candidate matches
 			 */
-			ENL1_printf("rescanning inner plan");
-			ExecReScan(innerPlan);
+			if (node->nl_Hashed)
+			{
+				ENL1_printf("probing inner hash table");
+				ExecNestLoopProbeHash(node);
+			}
+			else
+			{
+				ENL1_printf("rescanning inner plan");
+				ExecReScan(innerPlan);
+			}
 		}
 
 		/*
@@ -157,7 +191,10 @@ ExecNestLoop(PlanState *pstate)
 		 */
 		ENL1_printf("getting new inner tuple");
 
-		innerTupleSlot = ExecProcNode(innerPlan);
+		if (node->nl_Hashed)
+			innerTupleSlot = ExecNestLoopNextHashed(node);
+		else
+			innerTupleSlot = ExecProcNode(innerPlan);
 		econtext->ecxt_innertuple = innerTupleSlot;
 
 		if (TupIsNull(innerTupleSlot))
@@ -341,10 +378,21 @@ ExecInitNestLoop(NestLoop *node, EState *estate, int eflags)
 	}
 
 	/*
-	 * finally, wipe the current outer tuple clean.
+	 * finally, wipe the current outer tuple clean.  Everything needed for
+	 * hashing the inner side is set up only if we decide to do so.
 	 */
 	nlstate->nl_NeedNewOuter = true;
 	nlstate->nl_MatchedOuter = false;
+	nlstate->nl_OuterRows = 0;
+	nlstate->nl_HashTried = false;
+	nlstate->nl_Hashed = false;
+	nlstate->nl_HashSwitches = 0;
+	nlstate->nl_HashSwitchRow = 0;
+	nlstate->nl_HashAbandoned = false;
+	nlstate->nl_HashTable = NULL;
+	nlstate->nl_HashContext = NULL;
+	nlstate->nl_HashTupleContext = NULL;
+	nlstate->nl_HashNext = NULL;
 
 	NL1_printf("ExecInitNestLoop: %s\n",
 			   "node initialized");
@@ -373,6 +421,12 @@ ExecEndNestLoop(NestLoopState *node)
 	 * clean out the tuple table
 	 */
 	ExecClearTuple(node->js.ps.ps_ResultTupleSlot);
+	if (node->nl_HashInnerSlot)
+		ExecClearTuple(node->nl_HashInnerSlot);
+
+	/* free the inner hash table, if any */
+	if (node->nl_HashContext)
+		MemoryContextDelete(node->nl_HashContext);
 
 	/*
 	 * close down subplans
@@ -408,4 +462,224 @@ ExecReScanNestLoop(NestLoopState *node)
 
 	node->nl_NeedNewOuter = true;
 	node->nl_MatchedOuter = false;
+
+	/*
+	 * The inner side may produce different rows now, so forget any hash table
+	 * and start counting outer rows afresh.  If hashing was abandoned once,
+	 * though, we don't try again: the inner side is probably no smaller now.
+	 */
+	if (node->nl_HashTable)
+	{
+		ResetTupleHashTable(node->nl_HashTable);
+		MemoryContextReset(node->nl_HashTupleContext);
+	}
+	node->nl_OuterRows = 0;
+	node->nl_HashTried = false;
+	node->nl_Hashed = false;
+	node->nl_HashNext = NULL;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecNestLoopStartHashing
+ *
+ *		Read the whole (materialized) inner side into a hash table keyed
+ *		on the inner hash keys.  Each entry holds the list of inner tuples
+ *		with that key, in the order the inner side returned them, so that
+ *		the join still produces its rows in the same order.  Inner tuples
+ *		with a null key are left out, as they can't satisfy the strict
+ *		equality clauses.  If the table, counting its bucket array, outgrows
+ *		work_mem we give up and carry on with plain nested loop rescans, for
+ *		good.
+ * ----------------------------------------------------------------
+ */
+static void
+ExecNestLoopStartHashing(NestLoopState *node)
+{
+	NestLoop   *nl = (NestLoop *) node->js.ps.plan;
+	EState	   *estate = node->js.ps.state;
+	ExprContext *econtext = node->js.ps.ps_ExprContext;
+	PlanState  *innerPlan = innerPlanState(node);
+	long		limit = work_mem * 1024L;
+
+	node->nl_HashTried = true;
+
+	if (node->nl_HashTable == NULL)
+	{
+		MemoryContext oldcxt;
+		TupleDesc	keydesc;
+		TupleTableSlot *outerkeyslot;
+		TupleTableSlot *innerkeyslot;
+		List	   *outertlist = NIL;
+		List	   *innertlist = NIL;
+		AttrNumber *keyColIdx;
+		Oid		   *eqfuncoids;
+		FmgrInfo   *hashfunctions;
+		double		nbuckets;
+		ListCell   *lc;
+		ListCell   *lc2;
+		int			i;
+
+		oldcxt = MemoryContextSwitchTo(estate->es_query_cxt);
+
+		/*
+		 * The bucket array lives in nl_HashContext and the inner tuples in
+		 * a child context, so that the tuples can be thrown away on their
+		 * own while the memory used by both is checked against work_mem.
+		 */
+		node->nl_HashContext = AllocSetContextCreate(CurrentMemoryContext,
+													 "NestLoop hash table",
+													 ALLOCSET_DEFAULT_SIZES);
+		node->nl_HashTupleContext =
+			AllocSetContextCreate(node->nl_HashContext,
+								  "NestLoop hashed tuples",
+								  ALLOCSET_DEFAULT_SIZES);
+
+		/* Build a descriptor and projections for the hash keys */
+		keydesc = CreateTemplateTupleDesc(nl->numHashKeys);
+		keyColIdx = (AttrNumber *) palloc(nl->numHashKeys * sizeof(AttrNumber));
+		i = 0;
+		forboth(lc, nl->outerHashKeys, lc2, nl->innerHashKeys)
+		{
+			Expr	   *outerkey = (Expr *) lfirst(lc);
+			Expr	   *innerkey = (Expr *) lfirst(lc2);
+
+			TupleDescInitEntry(keydesc, i + 1, NULL,
+							   exprType((Node *) outerkey), -1, 0);
+			TupleDescInitEntryCollation(keydesc, i + 1,
+										nl->hashCollations[i]);
+			outertlist = lappend(outertlist,
+								 makeTargetEntry(outerkey, i + 1, NULL, false));
+			innertlist = lappend(innertlist,
+								 makeTargetEntry(innerkey, i + 1, NULL, false));
+			keyColIdx[i] = i + 1;
+			i++;
+		}
+
+		outerkeyslot = ExecInitExtraTupleSlot(estate, keydesc, &TTSOpsVirtual);
+		innerkeyslot = ExecInitExtraTupleSlot(estate, keydesc, &TTSOpsVirtual);
+		node->nl_OuterKeyProj = ExecBuildProjectionInfo(outertlist, econtext,
+														outerkeyslot,
+														&node->js.ps, NULL);
+		node->nl_InnerKeyProj = ExecBuildProjectionInfo(innertlist, econtext,
+														innerkeyslot,
+														&node->js.ps, NULL);
+		node->nl_HashInnerSlot =
+			ExecInitExtraTupleSlot(estate, ExecGetResultType(innerPlan),
+								   &TTSOpsMinimalTuple);
+
+		execTuplesHashPrepare(nl->numHashKeys, nl->hashOperators,
+							  &eqfuncoids, &hashfunctions);
+
+		nbuckets = Max(Min(innerPlan->plan->plan_rows, 65536.0), 16.0);
+		node->nl_HashTable = BuildTupleHashTableExt(&node->js.ps, keydesc,
+													nl->numHashKeys,
+													keyColIdx,
+													eqfuncoids,
+													hashfunctions,
+													nl->hashCollations,
+													(long) nbuckets, 0,
+													node->nl_HashContext,
+													node->nl_HashTupleContext,
+													econtext->ecxt_per_tuple_memory,
+													false);
+
+		MemoryContextSwitchTo(oldcxt);
+	}
+
+	/* Load the inner side into the hash table */
+	ExecReScan(innerPlan);
+	for (;;)
+	{
+		TupleTableSlot *innerTupleSlot;
+		TupleTableSlot *keyslot;
+		TupleHashEntry entry;
+		MemoryContext oldcxt;
+		bool		isnew;
+
+		CHECK_FOR_INTERRUPTS();
+
+		innerTupleSlot = ExecProcNode(innerPlan);
+		if (TupIsNull(innerTupleSlot))
+			break;
+
+		ResetExprContext(econtext);
+		econtext->ecxt_innertuple = innerTupleSlot;
+		keyslot = ExecProject(node->nl_InnerKeyProj);
+		if (slot_has_null_key(keyslot))
+			continue;
+
+		entry = LookupTupleHashEntry(node->nl_HashTable, keyslot, &isnew);
+		if (isnew)
+			entry->additional = NIL;
+
+		oldcxt = MemoryContextSwitchTo(node->nl_HashTupleContext);
+		entry->additional = lappend((List *) entry->additional,
+									ExecCopySlotMinimalTuple(innerTupleSlot));
+		MemoryContextSwitchTo(oldcxt);
+
+		if (MemoryContextMemAllocated(node->nl_HashContext, true) > limit)
+		{
+			ResetTupleHashTable(node->nl_HashTable);
+			MemoryContextReset(node->nl_HashTupleContext);
+			node->nl_HashAbandoned = true;
+			break;
+		}
+	}
+	ResetExprContext(econtext);
+
+	if (!node->nl_HashAbandoned)
+	{
+		node->nl_Hashed = true;
+		node->nl_HashSwitches++;
+		node->nl_HashSwitchRow = node->nl_OuterRows - 1;
+	}
+}
+
+/*
+ * Find the inner tuples whose hash key matches the current outer tuple.
+ */
+static void
+ExecNestLoopProbeHash(NestLoopState *node)
+{
+	TupleTableSlot *keyslot;
+	TupleHashEntry entry;
+
+	keyslot = ExecProject(node->nl_OuterKeyProj);
+	if (slot_has_null_key(keyslot))
+		entry = NULL;
+	else
+		entry = LookupTupleHashEntry(node->nl_HashTable, keyslot, NULL);
+
+	node->nl_HashNext = entry ? list_head((List *) entry->additional) : NULL;
+}
+
+/*
+ * Return the next candidate inner tuple for the current outer tuple, or
+ * NULL if there are no more.
+ */
+static TupleTableSlot *
+ExecNestLoopNextHashed(NestLoopState *node)
+{
+	ListCell   *lc = node->nl_HashNext;
+
+	if (lc == NULL)
+		return NULL;
+
+	node->nl_HashNext = lnext(lc);
+	return ExecStoreMinimalTuple((MinimalTuple) lfirst(lc),
+								 node->nl_HashInnerSlot, false);
+}
+
+static bool
+slot_has_null_key(TupleTableSlot *slot)
+{
+	int			i;
+
+	slot_getallattrs(slot);
+	for (i = 0; i < slot->tts_nvalid; i++)
+	{
+		if (slot->tts_isnull[i])
+			return true;
+	}
+	return false;
 }
@@ -15,6 +15,7 @@
 /*
  * INTERFACE ROUTINES
  *		ExecSeqScan				sequentially scans a relation.
+ *		ExecSeqScanBatch		same, fetching tuples in batches.
  *		ExecSeqNext				retrieve next tuple in sequential order.
  *		ExecInitSeqScan			creates and initializes a seqscan node.
  *		ExecEndSeqScan			releases any storage allocated.
@@ -29,11 +30,16 @@
 
 #include "access/relscan.h"
 #include "access/tableam.h"
+#include "executor/execBatch.h"
 #include "executor/execdebug.h"
+#include "executor/nodeHash.h"
 #include "executor/nodeSeqscan.h"
+#include "jit/jit.h"
+#include "miscadmin.h"
 #include "utils/rel.h"
 
 static TupleTableSlot *SeqNext(SeqScanState *node);
+static bool SeqNextBatch(SeqScanState *node);
 
 /* ----------------------------------------------------------------
  *						Scan Support
@@ -75,10 +81,20 @@ SeqNext(SeqScanState *node)
 	}
 
 	/*
-	 * get the next tuple from the table
+	 * get the next tuple from the table, skipping any that the runtime
+	 * filter proves to have no join partner
 	 */
-	if (table_scan_getnextslot(scandesc, direction, slot))
-		return slot;
+	while (table_scan_getnextslot(scandesc, direction, slot))
+	{
+		if (node->rtfilter == NULL ||
+			!ExecHashRuntimeFilterRejects(node->rtfilter,
+										  node->ss.ps.ps_ExprContext,
+										  node->rtfilter_keys, slot))
+			return slot;
+
+		InstrCountFiltered2(node, 1);
+		CHECK_FOR_INTERRUPTS();
+	}
 	return NULL;
 }
 
@@ -114,6 +130,152 @@ ExecSeqScan(PlanState *pstate)
 					(ExecScanRecheckMtd) SeqRecheck);
 }
 
+/* ----------------------------------------------------------------
+ *		SeqNextBatch
+ *
+ *		Fetch the next batch of tuples from the table, and evaluate
+ *		the batch quals on them.  Returns false at the end of the scan.
+ * ----------------------------------------------------------------
+ */
+static bool
+SeqNextBatch(SeqScanState *node)
+{
+	TableScanDesc scandesc = node->ss.ss_currentScanDesc;
+	TupleBatch *batch = node->batch;
+	BlockNumber block = InvalidBlockNumber;
+
+	if (node->batch_done)
+		return false;
+
+	if (scandesc == NULL)
+	{
+		/* see SeqNext */
+		scandesc = table_beginscan(node->ss.ss_currentRelation,
+								   node->ss.ps.state->es_snapshot,
+								   0, NULL);
+		node->ss.ss_currentScanDesc = scandesc;
+	}
+
+	ExecAdvanceTupleBatch(batch);
+	if (batch->ntuples > 0)
+		block = ItemPointerGetBlockNumber(&batch->slots[0]->tts_tid);
+	while (batch->ntuples < batch->capacity)
+	{
+		TupleTableSlot *slot = batch->slots[batch->ntuples];
+
+		if (!table_scan_getnextslot(scandesc, ForwardScanDirection,
+									batch->fetchslot))
+		{
+			node->batch_done = true;
+			break;
+		}
+
+		/*
+		 * The fetched tuple may point into the scan descriptor (heapam's
+		 * rs_ctup), which the next fetch overwrites.  Copying it gives the
+		 * batch slot a reference of its own; for heap tuples that doesn't copy
+		 * the tuple data.
+		 */
+		ExecCopySlot(slot, batch->fetchslot);
+
+		/*
+		 * Each tuple in the batch may keep its buffer pinned until we're
+		 * done with the batch, so don't let a batch span pages.  The tuple
+		 * from the next page starts the next batch.
+		 */
+		if (batch->ntuples > 0 &&
+			ItemPointerGetBlockNumber(&slot->tts_tid) != block)
+		{
+			batch->held = true;
+			break;
+		}
+		block = ItemPointerGetBlockNumber(&slot->tts_tid);
+		batch->ntuples++;
+	}
+
+	if (batch->ntuples == 0)
+		return false;
+
+	ExecBatchQual(node->bqual, batch);
+	InstrCountFiltered1(node, batch->ntuples - batch->nselected);
+
+	return true;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecSeqScanBatch(node)
+ *
+ *		Like ExecSeqScan, but fetches the tuples in batches and
+ *		evaluates the simple parts of the qual a whole batch at a
+ *		time.  The tuples that pass are then returned one at a time
+ *		through the scan tuple slot, after checking the rest of the
+ *		qual and projecting them, just as ExecScan would.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecSeqScanBatch(PlanState *pstate)
+{
+	SeqScanState *node = castNode(SeqScanState, pstate);
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	ProjectionInfo *projInfo = node->ss.ps.ps_ProjInfo;
+	TupleTableSlot *scanslot = node->ss.ss_ScanTupleSlot;
+
+	/* EvalPlanQual rechecks go through the regular path */
+	if (node->ss.ps.state->es_epqTupleSlot != NULL)
+		return ExecSeqScan(pstate);
+
+	/*
+	 * Reset per-tuple memory context to free any expression evaluation
+	 * storage allocated in the previous tuple cycle.
+	 */
+	ResetExprContext(econtext);
+
+	for (;;)
+	{
+		TupleTableSlot *slot;
+
+		CHECK_FOR_INTERRUPTS();
+
+		slot = ExecBatchNextSelected(node->batch);
+		if (slot == NULL)
+		{
+			if (SeqNextBatch(node))
+				continue;
+
+			/* end of scan, return an empty slot like ExecScan does */
+			if (projInfo)
+				return ExecClearTuple(projInfo->pi_state.resultslot);
+			return ExecClearTuple(scanslot);
+		}
+
+		/*
+		 * Make the tuple the current scan tuple, so that everything that
+		 * looks at the scan slot (WHERE CURRENT OF, for one) works as usual.
+		 */
+		ExecCopySlot(scanslot, slot);
+		econtext->ecxt_scantuple = scanslot;
+
+		if (node->rtfilter != NULL &&
+			ExecHashRuntimeFilterRejects(node->rtfilter, econtext,
+										 node->rtfilter_keys, scanslot))
+		{
+			InstrCountFiltered2(node, 1);
+			continue;
+		}
+
+		if (node->residual_qual == NULL ||
+			ExecQual(node->residual_qual, econtext))
+		{
+			if (projInfo)
+				return ExecProject(projInfo);
+			return scanslot;
+		}
+
+		InstrCountFiltered1(node, 1);
+		ResetExprContext(econtext);
+	}
+}
+
 
 /* ----------------------------------------------------------------
  *		ExecInitSeqScan
@@ -171,6 +333,34 @@ ExecInitSeqScan(SeqScan *node, EState *estate, int eflags)
 	scanstate->ss.ps.qual =
 		ExecInitQual(node->plan.qual, (PlanState *) scanstate);
 
+	/*
+	 * Use batch mode if it's enabled and some of the quals can be evaluated
+	 * in batches.  Batch mode only supports forward scans.
+	 */
+	if (executor_batch_size > 0 && (eflags & EXEC_FLAG_BACKWARD) == 0)
+	{
+		List	   *residual;
+
+		scanstate->bqual = ExecInitBatchQual(node->plan.qual, &residual);
+		if (scanstate->bqual != NULL)
+		{
+			scanstate->residual_qual =
+				ExecInitQual(residual, (PlanState *) scanstate);
+			scanstate->batch =
+				ExecInitTupleBatch(scanstate->ss.ss_currentRelation,
+								   executor_batch_size);
+			scanstate->ss.ps.ExecProcNode = ExecSeqScanBatch;
+		}
+	}
+
+	/*
+	 * Otherwise, try to JIT compile the scan loop.  If that works, it
+	 * replaces ExecSeqScan as the node's ExecProcNode.
+	 */
+	if (scanstate->batch == NULL)
+		(void) jit_compile_scan(&scanstate->ss,
+								(JitScanAccessMtd) SeqNext);
+
 	return scanstate;
 }
 
@@ -201,6 +391,8 @@ ExecEndSeqScan(SeqScanState *node)
 	if (node->ss.ps.ps_ResultTupleSlot)
 		ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
 	ExecClearTuple(node->ss.ss_ScanTupleSlot);
+	if (node->batch != NULL)
+		ExecDropTupleBatch(node->batch);
 
 	/*
 	 * close heap scan
@@ -231,6 +423,12 @@ ExecReScanSeqScan(SeqScanState *node)
 		table_rescan(scan,		/* scan desc */
 					 NULL);		/* new scan keys */
 
+	if (node->batch != NULL)
+	{
+		ExecResetTupleBatch(node->batch);
+		node->batch_done = false;
+	}
+
 	ExecScanReScan((ScanState *) node);
 }
 
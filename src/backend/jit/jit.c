@@ -25,6 +25,7 @@
 
 #include "fmgr.h"
 #include "executor/execExpr.h"
+#include "nodes/execnodes.h"
 #include "jit/jit.h"
 #include "miscadmin.h"
 #include "utils/resowner_private.h"
@@ -39,6 +40,8 @@ bool		jit_dump_bitcode = false;
 bool		jit_expressions = true;
 bool		jit_profiling_support = false;
 bool		jit_tuple_deforming = true;
+bool		jit_scans = true;
+int			jit_cache_entries = 0;
 double		jit_above_cost = 100000;
 double		jit_inline_above_cost = 500000;
 double		jit_optimize_above_cost = 500000;
@@ -182,6 +185,36 @@ jit_compile_expr(struct ExprState *state)
 	return false;
 }
 
+/*
+ * Ask provider to JIT compile the loop of a scan node, fusing the calls to
+ * accessMtd with the evaluation of the node's qual and projection.  On
+ * success, the node's ExecProcNode is replaced.
+ *
+ * Returns true if successful, false if not.
+ */
+bool
+jit_compile_scan(struct ScanState *node, JitScanAccessMtd accessMtd)
+{
+	EState	   *estate = node->ps.state;
+
+	/* if no jitting should be performed at all */
+	if (!(estate->es_jit_flags & PGJIT_PERFORM))
+		return false;
+
+	/* or if scan loops aren't JITed */
+	if (!(estate->es_jit_flags & PGJIT_SCAN))
+		return false;
+
+	/*
+	 * This also takes !jit_enabled into account.  Providers written before
+	 * the callback existed leave it NULL; the scan is then interpreted.
+	 */
+	if (provider_init() && provider.compile_scan != NULL)
+		return provider.compile_scan(node, accessMtd);
+
+	return false;
+}
+
 /* Aggregate JIT instrumentation information */
 void
 InstrJitAgg(JitInstrumentation *dst, JitInstrumentation *add)
@@ -191,6 +224,7 @@ InstrJitAgg(JitInstrumentation *dst, JitInstrumentation *add)
 	INSTR_TIME_ADD(dst->inlining_counter, add->inlining_counter);
 	INSTR_TIME_ADD(dst->optimization_counter, add->optimization_counter);
 	INSTR_TIME_ADD(dst->emission_counter, add->emission_counter);
+	dst->cache_hits += add->cache_hits;
 }
 
 static bool
@@ -18,6 +18,8 @@
 
 #include "miscadmin.h"
 
+#include "lib/ilist.h"
+#include "utils/hashutils.h"
 #include "utils/memutils.h"
 #include "utils/resowner_private.h"
 #include "portability/instr_time.h"
@@ -47,6 +49,25 @@ typedef struct LLVMJitHandle
 	LLVMOrcModuleHandle orc_handle;
 } LLVMJitHandle;
 
+/* Module in the backend-local cache of emitted code */
+typedef struct LLVMJitCacheEntry
+{
+	dlist_node	node;			/* in llvm_code_cache, most recent first */
+	uint32		hash;			/* hash of key */
+	char	   *key;			/* flags and normalized IR of the module */
+	size_t		module_generation;	/* generation the code was emitted as */
+	LLVMJitHandle *handle;
+	int			refcount;		/* # of LLVMJitCacheRefs to entry */
+	bool		evicted;		/* no longer in llvm_code_cache */
+} LLVMJitCacheEntry;
+
+/* Use of a cached module by a context, in LLVMJitContext->cache_refs */
+typedef struct LLVMJitCacheRef
+{
+	size_t		module_generation;	/* generation of the module replaced */
+	LLVMJitCacheEntry *entry;
+} LLVMJitCacheRef;
+
 
 /* types & functions commonly needed for JITing */
 LLVMTypeRef TypeSizeT;
@@ -89,6 +110,8 @@ LLVMValueRef FuncExecEvalSubscriptingRef;
 LLVMValueRef FuncExecEvalSysVar;
 LLVMValueRef FuncExecAggTransReparent;
 LLVMValueRef FuncExecAggInitGroup;
+LLVMValueRef FuncMemoryContextReset;
+LLVMValueRef FuncProcessInterrupts;
 
 
 static bool llvm_session_initialized = false;
@@ -104,12 +127,25 @@ static LLVMTargetRef llvm_targetref;
 static LLVMOrcJITStackRef llvm_opt0_orc;
 static LLVMOrcJITStackRef llvm_opt3_orc;
 
+static dlist_head llvm_code_cache = DLIST_STATIC_INIT(llvm_code_cache);
+static int	llvm_code_cache_size = 0;
+
 
 static void llvm_release_context(JitContext *context);
 static void llvm_session_initialize(void);
 static void llvm_shutdown(int code, Datum arg);
 static void llvm_compile_module(LLVMJitContext *context);
 static void llvm_optimize_module(LLVMJitContext *context, LLVMModuleRef module);
+static char *llvm_cache_key(LLVMJitContext *context);
+static LLVMJitCacheEntry *llvm_cache_lookup(const char *key, uint32 hash);
+static void llvm_cache_insert(LLVMJitContext *context, char *key, uint32 hash,
+							  LLVMJitHandle *handle);
+static void llvm_cache_add_ref(LLVMJitContext *context,
+							   LLVMJitCacheEntry *entry);
+static void llvm_cache_release_entry(LLVMJitCacheEntry *entry);
+static void llvm_cache_evict(int max_entries);
+static char *llvm_replace_generation(const char *funcname, size_t generation,
+									 const char *replacement);
 
 static void llvm_create_types(void);
 static uint64_t llvm_resolve_symbol(const char *name, void *ctx);
@@ -127,6 +163,7 @@ _PG_jit_provider_init(JitProviderCallbacks *cb)
 	cb->reset_after_error = llvm_reset_after_error;
 	cb->release_context = llvm_release_context;
 	cb->compile_expr = llvm_compile_expr;
+	cb->compile_scan = llvm_compile_scan;
 }
 
 /*
@@ -191,6 +228,20 @@ llvm_release_context(JitContext *context)
 			LLVMOrcRemoveModule(jit_handle->stack, jit_handle->orc_handle);
 			pfree(jit_handle);
 		}
+
+		while (llvm_context->cache_refs != NIL)
+		{
+			LLVMJitCacheRef *ref;
+
+			ref = (LLVMJitCacheRef *) linitial(llvm_context->cache_refs);
+			llvm_context->cache_refs =
+				list_delete_first(llvm_context->cache_refs);
+
+			ref->entry->refcount--;
+			if (ref->entry->evicted && ref->entry->refcount == 0)
+				llvm_cache_release_entry(ref->entry);
+			pfree(ref);
+		}
 	}
 }
 
@@ -247,9 +298,7 @@ void *
 llvm_get_function(LLVMJitContext *context, const char *funcname)
 {
 	LLVMOrcTargetAddress addr = 0;
-#if defined(HAVE_DECL_LLVMORCGETSYMBOLADDRESSIN) && HAVE_DECL_LLVMORCGETSYMBOLADDRESSIN
 	ListCell   *lc;
-#endif
 
 	llvm_assert_in_fatal_section();
 
@@ -267,6 +316,35 @@ llvm_get_function(LLVMJitContext *context, const char *funcname)
 	 * to mangle here.
 	 */
 
+	/*
+	 * If the function is part of a module that was found in the code cache,
+	 * look it up under the name it was emitted with.
+	 */
+	foreach(lc, context->cache_refs)
+	{
+		LLVMJitCacheRef *ref = (LLVMJitCacheRef *) lfirst(lc);
+		char		generation[32];
+		char	   *cachedname;
+
+		snprintf(generation, sizeof(generation), "%zu",
+				 ref->entry->module_generation);
+		cachedname = llvm_replace_generation(funcname, ref->module_generation,
+											 generation);
+		if (cachedname == NULL)
+			continue;
+
+		funcname = cachedname;
+#if defined(HAVE_DECL_LLVMORCGETSYMBOLADDRESSIN) && HAVE_DECL_LLVMORCGETSYMBOLADDRESSIN
+		if (LLVMOrcGetSymbolAddressIn(ref->entry->handle->stack, &addr,
+									  ref->entry->handle->orc_handle,
+									  funcname))
+			elog(ERROR, "failed to look up symbol \"%s\"", funcname);
+		if (addr)
+			return (void *) (uintptr_t) addr;
+#endif
+		break;
+	}
+
 #if defined(HAVE_DECL_LLVMORCGETSYMBOLADDRESSIN) && HAVE_DECL_LLVMORCGETSYMBOLADDRESSIN
 	foreach(lc, context->handles)
 	{
@@ -495,12 +573,47 @@ llvm_compile_module(LLVMJitContext *context)
 	static LLVMOrcJITStackRef compile_orc;
 	instr_time	starttime;
 	instr_time	endtime;
+	char	   *cache_key = NULL;
+	uint32		cache_hash = 0;
 
 	if (context->base.flags & PGJIT_OPT3)
 		compile_orc = llvm_opt3_orc;
 	else
 		compile_orc = llvm_opt0_orc;
 
+	/* in case jit_cache_entries was lowered */
+	if (llvm_code_cache_size > jit_cache_entries)
+		llvm_cache_evict(jit_cache_entries);
+
+	/*
+	 * If identical code has been emitted before, use that instead of
+	 * optimizing and emitting the module again. The generated code doesn't
+	 * reference execution specific data directly when caching is enabled,
+	 * see l_data_ptr().
+	 */
+	if (jit_cache_entries > 0)
+	{
+		LLVMJitCacheEntry *entry;
+
+		cache_key = llvm_cache_key(context);
+		cache_hash = DatumGetUInt32(hash_any((unsigned char *) cache_key,
+											 strlen(cache_key)));
+
+		entry = llvm_cache_lookup(cache_key, cache_hash);
+		if (entry)
+		{
+			LLVMDisposeModule(context->module);
+			context->module = NULL;
+			context->compiled = true;
+
+			llvm_cache_add_ref(context, entry);
+			context->base.instr.cache_hits++;
+
+			pfree(cache_key);
+			return;
+		}
+	}
+
 	/* perform inlining */
 	if (context->base.flags & PGJIT_INLINE)
 	{
@@ -593,10 +706,17 @@ llvm_compile_module(LLVMJitContext *context)
 		handle->stack = compile_orc;
 		handle->orc_handle = orc_handle;
 
-		context->handles = lappend(context->handles, handle);
+		/* if cached, the code is owned by the cache entry */
+		if (cache_key)
+			llvm_cache_insert(context, cache_key, cache_hash, handle);
+		else
+			context->handles = lappend(context->handles, handle);
 	}
 	MemoryContextSwitchTo(oldcontext);
 
+	if (cache_key)
+		pfree(cache_key);
+
 	ereport(DEBUG1,
 			(errmsg("time to inline: %.3fs, opt: %.3fs, emit: %.3fs",
 					INSTR_TIME_GET_DOUBLE(context->base.instr.inlining_counter),
@@ -606,6 +726,200 @@ llvm_compile_module(LLVMJitContext *context)
 			 errhidecontext(true)));
 }
 
+/*
+ * Compute the code cache key for the currently pending module.
+ *
+ * Function names include the module's generation, which differs for each
+ * module. Normalize the names while printing the IR, so modules generated
+ * for different executions of the same query produce the same key.
+ */
+static char *
+llvm_cache_key(LLVMJitContext *context)
+{
+	LLVMValueRef func;
+	List	   *renamed = NIL;
+	List	   *orignames = NIL;
+	ListCell   *lc1;
+	ListCell   *lc2;
+	char	   *ir;
+	char	   *key;
+
+	for (func = LLVMGetFirstFunction(context->module);
+		 func != NULL;
+		 func = LLVMGetNextFunction(func))
+	{
+		const char *name;
+		char	   *newname;
+
+		if (LLVMIsDeclaration(func))
+			continue;
+
+		name = LLVMGetValueName(func);
+		newname = llvm_replace_generation(name, context->module_generation,
+										  "G");
+		if (newname == NULL)
+			continue;
+
+		renamed = lappend(renamed, func);
+		orignames = lappend(orignames, pstrdup(name));
+		LLVMSetValueName(func, newname);
+		pfree(newname);
+	}
+
+	ir = LLVMPrintModuleToString(context->module);
+	key = psprintf("%d\n%s", context->base.flags, ir);
+	LLVMDisposeMessage(ir);
+
+	forboth(lc1, renamed, lc2, orignames)
+	{
+		LLVMSetValueName((LLVMValueRef) lfirst(lc1), (char *) lfirst(lc2));
+		pfree(lfirst(lc2));
+	}
+	list_free(renamed);
+	list_free(orignames);
+
+	return key;
+}
+
+/*
+ * Look up the code cache entry with the given key, marking it as most
+ * recently used. Returns NULL if there is none.
+ */
+static LLVMJitCacheEntry *
+llvm_cache_lookup(const char *key, uint32 hash)
+{
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &llvm_code_cache)
+	{
+		LLVMJitCacheEntry *entry;
+
+		entry = dlist_container(LLVMJitCacheEntry, node, iter.cur);
+		if (entry->hash == hash && strcmp(entry->key, key) == 0)
+		{
+			dlist_move_head(&llvm_code_cache, &entry->node);
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Add the code just emitted for context's module to the code cache.
+ */
+static void
+llvm_cache_insert(LLVMJitContext *context, char *key, uint32 hash,
+				  LLVMJitHandle *handle)
+{
+	LLVMJitCacheEntry *entry;
+
+	entry = MemoryContextAlloc(TopMemoryContext, sizeof(LLVMJitCacheEntry));
+	entry->hash = hash;
+	entry->key = MemoryContextStrdup(TopMemoryContext, key);
+	entry->module_generation = context->module_generation;
+	entry->handle = handle;
+	entry->refcount = 0;
+	entry->evicted = false;
+
+	dlist_push_head(&llvm_code_cache, &entry->node);
+	llvm_code_cache_size++;
+
+	/* the emitting context uses the cached code, just like later ones */
+	llvm_cache_add_ref(context, entry);
+
+	llvm_cache_evict(jit_cache_entries);
+}
+
+/*
+ * Remember that context uses the code of a cache entry.
+ */
+static void
+llvm_cache_add_ref(LLVMJitContext *context, LLVMJitCacheEntry *entry)
+{
+	MemoryContext oldcontext;
+	LLVMJitCacheRef *ref;
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	ref = (LLVMJitCacheRef *) palloc(sizeof(LLVMJitCacheRef));
+	ref->module_generation = context->module_generation;
+	ref->entry = entry;
+	entry->refcount++;
+
+	context->cache_refs = lappend(context->cache_refs, ref);
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * Evict least recently used entries until at most max_entries are left.
+ * Entries still in use are released once the last context using them is.
+ */
+static void
+llvm_cache_evict(int max_entries)
+{
+	while (llvm_code_cache_size > max_entries)
+	{
+		LLVMJitCacheEntry *entry;
+
+		entry = dlist_container(LLVMJitCacheEntry, node,
+								dlist_tail_node(&llvm_code_cache));
+		dlist_delete(&entry->node);
+		llvm_code_cache_size--;
+
+		entry->evicted = true;
+		if (entry->refcount == 0)
+			llvm_cache_release_entry(entry);
+	}
+}
+
+/*
+ * Free an evicted code cache entry, and the code it contains.
+ */
+static void
+llvm_cache_release_entry(LLVMJitCacheEntry *entry)
+{
+	Assert(entry->evicted && entry->refcount == 0);
+
+	LLVMOrcRemoveModule(entry->handle->stack, entry->handle->orc_handle);
+	pfree(entry->handle);
+	pfree(entry->key);
+	pfree(entry);
+}
+
+/*
+ * If funcname, as returned by llvm_expand_funcname(), belongs to a module of
+ * the given generation, return a copy with the generation replaced by
+ * replacement. Otherwise return NULL.
+ */
+static char *
+llvm_replace_generation(const char *funcname, size_t generation,
+						const char *replacement)
+{
+	const char *counter;
+	const char *gen;
+	char		genbuf[32];
+
+	/* names are of the form basename_generation_counter */
+	counter = strrchr(funcname, '_');
+	if (counter == NULL)
+		return NULL;
+	for (gen = counter; gen > funcname && gen[-1] != '_'; gen--)
+		;
+	if (gen == funcname)
+		return NULL;
+
+	snprintf(genbuf, sizeof(genbuf), "%zu", generation);
+	if (counter - gen != strlen(genbuf) ||
+		strncmp(gen, genbuf, counter - gen) != 0)
+		return NULL;
+
+	return psprintf("%.*s%s%s",
+					(int) (gen - funcname), funcname,
+					replacement, counter);
+}
+
 /*
  * Per session initialization.
  */
@@ -833,6 +1147,8 @@ llvm_create_types(void)
 	FuncExecEvalSysVar = LLVMGetNamedFunction(mod, "ExecEvalSysVar");
 	FuncExecAggTransReparent = LLVMGetNamedFunction(mod, "ExecAggTransReparent");
 	FuncExecAggInitGroup = LLVMGetNamedFunction(mod, "ExecAggInitGroup");
+	FuncMemoryContextReset = LLVMGetNamedFunction(mod, "MemoryContextReset");
+	FuncProcessInterrupts = LLVMGetNamedFunction(mod, "ProcessInterrupts");
 
 	/*
 	 * Leave the module alive, otherwise references to function would be
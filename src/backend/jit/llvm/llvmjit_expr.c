@@ -49,6 +49,8 @@
 
 typedef struct CompiledExprState
 {
+	/* must be first, generated code loads it via evalfunc_private */
+	void	  **dataptrs;
 	LLVMJitContext *context;
 	const char *funcname;
 } CompiledExprState;
@@ -57,10 +59,11 @@ typedef struct CompiledExprState
 static Datum ExecRunCompiledExpr(ExprState *state, ExprContext *econtext, bool *isNull);
 
 static LLVMValueRef BuildV1Call(LLVMJitContext *context, LLVMBuilderRef b,
-								LLVMModuleRef mod, FunctionCallInfo fcinfo,
+								LLVMModuleRef mod, LLVMJitDataRefs *refs,
+								FunctionCallInfo fcinfo,
 								LLVMValueRef *v_fcinfo_isnull);
 static void build_EvalXFunc(LLVMBuilderRef b, LLVMModuleRef mod,
-							const char *funcname,
+							LLVMJitDataRefs *refs, const char *funcname,
 							LLVMValueRef v_state, LLVMValueRef v_econtext,
 							ExprEvalStep *op);
 static LLVMValueRef create_LifetimeEnd(LLVMModuleRef mod);
@@ -85,6 +88,10 @@ llvm_compile_expr(ExprState *state)
 	LLVMBasicBlockRef entry;
 	LLVMBasicBlockRef *opblocks;
 
+	/* pointers loaded at runtime, if the code may be cached */
+	LLVMJitDataRefs refsdata;
+	LLVMJitDataRefs *refs = NULL;
+
 	/* state itself */
 	LLVMValueRef v_state;
 	LLVMValueRef v_econtext;
@@ -178,6 +185,27 @@ llvm_compile_expr(ExprState *state)
 									  FIELDNO_EXPRSTATE_RESNULL,
 									  "v.state.resnull");
 
+	/*
+	 * If the emitted code may be cached and reused by later executions,
+	 * reference execution-time data through a table hanging off the
+	 * CompiledExprState, instead of embedding the addresses.
+	 */
+	if (jit_cache_entries > 0)
+	{
+		LLVMValueRef v_cstatep;
+
+		memset(&refsdata, 0, sizeof(refsdata));
+		refs = &refsdata;
+
+		v_cstatep = l_load_struct_gep(b, v_state,
+									  FIELDNO_EXPRSTATE_EVALFUNC_PRIVATE,
+									  "");
+		v_cstatep = LLVMBuildBitCast(b, v_cstatep,
+									 l_ptr(l_ptr(l_ptr(LLVMInt8Type()))),
+									 "");
+		refs->v_ptrs = LLVMBuildLoad(b, v_cstatep, "v_dataptrs");
+	}
+
 	/* build global slots */
 	v_scanslot = l_load_struct_gep(b, v_econtext,
 								   FIELDNO_EXPRCONTEXT_SCANTUPLE,
@@ -246,8 +274,8 @@ llvm_compile_expr(ExprState *state)
 		op = &state->steps[i];
 		opcode = ExecEvalStepOp(state, op);
 
-		v_resvaluep = l_ptr_const(op->resvalue, l_ptr(TypeSizeT));
-		v_resnullp = l_ptr_const(op->resnull, l_ptr(TypeStorageBool));
+		v_resvaluep = l_data_ptr(b, refs, op->resvalue, l_ptr(TypeSizeT));
+		v_resnullp = l_data_ptr(b, refs, op->resnull, l_ptr(TypeStorageBool));
 
 		switch (opcode)
 		{
@@ -403,7 +431,7 @@ llvm_compile_expr(ExprState *state)
 						v_slot = v_scanslot;
 
 					v_params[0] = v_state;
-					v_params[1] = l_ptr_const(op, l_ptr(StructExprEvalStep));
+					v_params[1] = l_data_ptr(b, refs, op, l_ptr(StructExprEvalStep));
 					v_params[2] = v_econtext;
 					v_params[3] = v_slot;
 
@@ -416,7 +444,7 @@ llvm_compile_expr(ExprState *state)
 				}
 
 			case EEOP_WHOLEROW:
-				build_EvalXFunc(b, mod, "ExecEvalWholeRowVar",
+				build_EvalXFunc(b, mod, refs, "ExecEvalWholeRowVar",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
@@ -553,8 +581,28 @@ llvm_compile_expr(ExprState *state)
 					LLVMValueRef v_constvalue,
 								v_constnull;
 
-					v_constvalue = l_sizet_const(op->d.constval.value);
-					v_constnull = l_sbool_const(op->d.constval.isnull);
+					/*
+					 * Constants may be parameter values substituted into a
+					 * custom plan, so load them when the code may be reused.
+					 */
+					if (refs)
+					{
+						v_constvalue =
+							LLVMBuildLoad(b,
+										  l_data_ptr(b, refs, &op->d.constval.value,
+													 l_ptr(TypeSizeT)),
+										  "");
+						v_constnull =
+							LLVMBuildLoad(b,
+										  l_data_ptr(b, refs, &op->d.constval.isnull,
+													 l_ptr(TypeStorageBool)),
+										  "");
+					}
+					else
+					{
+						v_constvalue = l_sizet_const(op->d.constval.value);
+						v_constnull = l_sbool_const(op->d.constval.isnull);
+					}
 
 					LLVMBuildStore(b, v_constvalue, v_resvaluep);
 					LLVMBuildStore(b, v_constnull, v_resnullp);
@@ -583,7 +631,7 @@ llvm_compile_expr(ExprState *state)
 						elog(ERROR, "argumentless strict functions are pointless");
 
 					v_fcinfo =
-						l_ptr_const(fcinfo, l_ptr(StructFunctionCallInfoData));
+						l_data_ptr(b, refs, fcinfo, l_ptr(StructFunctionCallInfoData));
 
 					/*
 					 * set resnull to true, if the function is actually
@@ -636,7 +684,7 @@ llvm_compile_expr(ExprState *state)
 					LLVMValueRef v_fcinfo_isnull;
 					LLVMValueRef v_retval;
 
-					v_retval = BuildV1Call(context, b, mod, fcinfo,
+					v_retval = BuildV1Call(context, b, mod, refs, fcinfo,
 										   &v_fcinfo_isnull);
 					LLVMBuildStore(b, v_retval, v_resvaluep);
 					LLVMBuildStore(b, v_fcinfo_isnull, v_resnullp);
@@ -646,14 +694,14 @@ llvm_compile_expr(ExprState *state)
 				}
 
 			case EEOP_FUNCEXPR_FUSAGE:
-				build_EvalXFunc(b, mod, "ExecEvalFuncExprFusage",
+				build_EvalXFunc(b, mod, refs, "ExecEvalFuncExprFusage",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 
 			case EEOP_FUNCEXPR_STRICT_FUSAGE:
-				build_EvalXFunc(b, mod, "ExecEvalFuncExprStrictFusage",
+				build_EvalXFunc(b, mod, refs, "ExecEvalFuncExprStrictFusage",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
@@ -662,8 +710,8 @@ llvm_compile_expr(ExprState *state)
 				{
 					LLVMValueRef v_boolanynullp;
 
-					v_boolanynullp = l_ptr_const(op->d.boolexpr.anynull,
-												 l_ptr(TypeStorageBool));
+					v_boolanynullp = l_data_ptr(b, refs, op->d.boolexpr.anynull,
+												l_ptr(TypeStorageBool));
 					LLVMBuildStore(b, l_sbool_const(0), v_boolanynullp);
 
 				}
@@ -698,8 +746,8 @@ llvm_compile_expr(ExprState *state)
 					b_boolcont = l_bb_before_v(opblocks[i + 1],
 											   "b.%d.boolcont", i);
 
-					v_boolanynullp = l_ptr_const(op->d.boolexpr.anynull,
-												 l_ptr(TypeStorageBool));
+					v_boolanynullp = l_data_ptr(b, refs, op->d.boolexpr.anynull,
+												l_ptr(TypeStorageBool));
 
 					v_boolnull = LLVMBuildLoad(b, v_resnullp, "");
 					v_boolvalue = LLVMBuildLoad(b, v_resvaluep, "");
@@ -764,8 +812,8 @@ llvm_compile_expr(ExprState *state)
 				{
 					LLVMValueRef v_boolanynullp;
 
-					v_boolanynullp = l_ptr_const(op->d.boolexpr.anynull,
-												 l_ptr(TypeStorageBool));
+					v_boolanynullp = l_data_ptr(b, refs, op->d.boolexpr.anynull,
+												l_ptr(TypeStorageBool));
 					LLVMBuildStore(b, l_sbool_const(0), v_boolanynullp);
 				}
 				/* FALLTHROUGH */
@@ -800,8 +848,8 @@ llvm_compile_expr(ExprState *state)
 					b_boolcont = l_bb_before_v(opblocks[i + 1],
 											   "b.%d.boolcont", i);
 
-					v_boolanynullp = l_ptr_const(op->d.boolexpr.anynull,
-												 l_ptr(TypeStorageBool));
+					v_boolanynullp = l_data_ptr(b, refs, op->d.boolexpr.anynull,
+												l_ptr(TypeStorageBool));
 
 					v_boolnull = LLVMBuildLoad(b, v_resnullp, "");
 					v_boolvalue = LLVMBuildLoad(b, v_resvaluep, "");
@@ -1027,13 +1075,13 @@ llvm_compile_expr(ExprState *state)
 				}
 
 			case EEOP_NULLTEST_ROWISNULL:
-				build_EvalXFunc(b, mod, "ExecEvalRowNull",
+				build_EvalXFunc(b, mod, refs, "ExecEvalRowNull",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_NULLTEST_ROWISNOTNULL:
-				build_EvalXFunc(b, mod, "ExecEvalRowNotNull",
+				build_EvalXFunc(b, mod, refs, "ExecEvalRowNotNull",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
@@ -1104,13 +1152,13 @@ llvm_compile_expr(ExprState *state)
 				}
 
 			case EEOP_PARAM_EXEC:
-				build_EvalXFunc(b, mod, "ExecEvalParamExec",
+				build_EvalXFunc(b, mod, refs, "ExecEvalParamExec",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_PARAM_EXTERN:
-				build_EvalXFunc(b, mod, "ExecEvalParamExtern",
+				build_EvalXFunc(b, mod, refs, "ExecEvalParamExtern",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
@@ -1134,7 +1182,7 @@ llvm_compile_expr(ExprState *state)
 										 l_ptr(v_functype));
 
 					v_params[0] = v_state;
-					v_params[1] = l_ptr_const(op, l_ptr(TypeSizeT));
+					v_params[1] = l_data_ptr(b, refs, op, l_ptr(TypeSizeT));
 					v_params[2] = v_econtext;
 					LLVMBuildCall(b,
 								  v_func,
@@ -1145,19 +1193,19 @@ llvm_compile_expr(ExprState *state)
 				}
 
 			case EEOP_SBSREF_OLD:
-				build_EvalXFunc(b, mod, "ExecEvalSubscriptingRefOld",
+				build_EvalXFunc(b, mod, refs, "ExecEvalSubscriptingRefOld",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_SBSREF_ASSIGN:
-				build_EvalXFunc(b, mod, "ExecEvalSubscriptingRefAssign",
+				build_EvalXFunc(b, mod, refs, "ExecEvalSubscriptingRefAssign",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_SBSREF_FETCH:
-				build_EvalXFunc(b, mod, "ExecEvalSubscriptingRefFetch",
+				build_EvalXFunc(b, mod, refs, "ExecEvalSubscriptingRefFetch",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
@@ -1177,10 +1225,10 @@ llvm_compile_expr(ExprState *state)
 					b_notavail = l_bb_before_v(opblocks[i + 1],
 											   "op.%d.notavail", i);
 
-					v_casevaluep = l_ptr_const(op->d.casetest.value,
-											   l_ptr(TypeSizeT));
-					v_casenullp = l_ptr_const(op->d.casetest.isnull,
-											  l_ptr(TypeStorageBool));
+					v_casevaluep = l_data_ptr(b, refs, op->d.casetest.value,
+											  l_ptr(TypeSizeT));
+					v_casenullp = l_data_ptr(b, refs, op->d.casetest.isnull,
+											 l_ptr(TypeStorageBool));
 
 					v_casevaluenull =
 						LLVMBuildICmp(b, LLVMIntEQ,
@@ -1225,8 +1273,8 @@ llvm_compile_expr(ExprState *state)
 					b_notnull = l_bb_before_v(opblocks[i + 1],
 											  "op.%d.readonly.notnull", i);
 
-					v_nullp = l_ptr_const(op->d.make_readonly.isnull,
-										  l_ptr(TypeStorageBool));
+					v_nullp = l_data_ptr(b, refs, op->d.make_readonly.isnull,
+										 l_ptr(TypeStorageBool));
 
 					v_null = LLVMBuildLoad(b, v_nullp, "");
 
@@ -1242,8 +1290,8 @@ llvm_compile_expr(ExprState *state)
 					/* if value is not null, convert to RO datum */
 					LLVMPositionBuilderAtEnd(b, b_notnull);
 
-					v_valuep = l_ptr_const(op->d.make_readonly.value,
-										   l_ptr(TypeSizeT));
+					v_valuep = l_data_ptr(b, refs, op->d.make_readonly.value,
+										  l_ptr(TypeSizeT));
 
 					v_value = LLVMBuildLoad(b, v_valuep, "");
 
@@ -1291,8 +1339,8 @@ llvm_compile_expr(ExprState *state)
 					b_inputcall = l_bb_before_v(opblocks[i + 1],
 												"op.%d.inputcall", i);
 
-					v_fcinfo_out = l_ptr_const(fcinfo_out, l_ptr(StructFunctionCallInfoData));
-					v_fcinfo_in = l_ptr_const(fcinfo_in, l_ptr(StructFunctionCallInfoData));
+					v_fcinfo_out = l_data_ptr(b, refs, fcinfo_out, l_ptr(StructFunctionCallInfoData));
+					v_fcinfo_in = l_data_ptr(b, refs, fcinfo_in, l_ptr(StructFunctionCallInfoData));
 					v_fn_addr_out = l_ptr_const(fcinfo_out->flinfo->fn_addr, TypePGFunction);
 					v_fn_addr_in = l_ptr_const(fcinfo_in->flinfo->fn_addr, TypePGFunction);
 
@@ -1416,7 +1464,7 @@ llvm_compile_expr(ExprState *state)
 					b_bothargnull = l_bb_before_v(opblocks[i + 1], "op.%d.bothargnull", i);
 					b_anyargnull = l_bb_before_v(opblocks[i + 1], "op.%d.anyargnull", i);
 
-					v_fcinfo = l_ptr_const(fcinfo, l_ptr(StructFunctionCallInfoData));
+					v_fcinfo = l_data_ptr(b, refs, fcinfo, l_ptr(StructFunctionCallInfoData));
 
 					/* load args[0|1].isnull for both arguments */
 					v_argnull0 = l_funcnull(b, v_fcinfo, 0);
@@ -1467,7 +1515,7 @@ llvm_compile_expr(ExprState *state)
 					/* neither argument is null: compare */
 					LLVMPositionBuilderAtEnd(b, b_noargnull);
 
-					v_result = BuildV1Call(context, b, mod, fcinfo,
+					v_result = BuildV1Call(context, b, mod, refs, fcinfo,
 										   &v_fcinfo_isnull);
 
 					if (opcode == EEOP_DISTINCT)
@@ -1511,7 +1559,7 @@ llvm_compile_expr(ExprState *state)
 					b_argsequal = l_bb_before_v(opblocks[i + 1],
 												"b.%d.argsequal", i);
 
-					v_fcinfo = l_ptr_const(fcinfo, l_ptr(StructFunctionCallInfoData));
+					v_fcinfo = l_data_ptr(b, refs, fcinfo, l_ptr(StructFunctionCallInfoData));
 
 					/* if either argument is NULL they can't be equal */
 					v_argnull0 = l_funcnull(b, v_fcinfo, 0);
@@ -1537,7 +1585,7 @@ llvm_compile_expr(ExprState *state)
 					/* build block to invoke function and check result */
 					LLVMPositionBuilderAtEnd(b, b_nonull);
 
-					v_retval = BuildV1Call(context, b, mod, fcinfo, &v_fcinfo_isnull);
+					v_retval = BuildV1Call(context, b, mod, refs, fcinfo, &v_fcinfo_isnull);
 
 					/*
 					 * If result not null, and arguments are equal return null
@@ -1567,37 +1615,37 @@ llvm_compile_expr(ExprState *state)
 				}
 
 			case EEOP_SQLVALUEFUNCTION:
-				build_EvalXFunc(b, mod, "ExecEvalSQLValueFunction",
+				build_EvalXFunc(b, mod, refs, "ExecEvalSQLValueFunction",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_CURRENTOFEXPR:
-				build_EvalXFunc(b, mod, "ExecEvalCurrentOfExpr",
+				build_EvalXFunc(b, mod, refs, "ExecEvalCurrentOfExpr",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_NEXTVALUEEXPR:
-				build_EvalXFunc(b, mod, "ExecEvalNextValueExpr",
+				build_EvalXFunc(b, mod, refs, "ExecEvalNextValueExpr",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_ARRAYEXPR:
-				build_EvalXFunc(b, mod, "ExecEvalArrayExpr",
+				build_EvalXFunc(b, mod, refs, "ExecEvalArrayExpr",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_ARRAYCOERCE:
-				build_EvalXFunc(b, mod, "ExecEvalArrayCoerce",
+				build_EvalXFunc(b, mod, refs, "ExecEvalArrayCoerce",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_ROW:
-				build_EvalXFunc(b, mod, "ExecEvalRow",
+				build_EvalXFunc(b, mod, refs, "ExecEvalRow",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
@@ -1632,8 +1680,8 @@ llvm_compile_expr(ExprState *state)
 						LLVMValueRef v_argnull1;
 						LLVMValueRef v_anyargisnull;
 
-						v_fcinfo = l_ptr_const(fcinfo,
-											   l_ptr(StructFunctionCallInfoData));
+						v_fcinfo = l_data_ptr(b, refs, fcinfo,
+											  l_ptr(StructFunctionCallInfoData));
 
 						v_argnull0 = l_funcnull(b, v_fcinfo, 0);
 						v_argnull1 = l_funcnull(b, v_fcinfo, 1);
@@ -1661,7 +1709,7 @@ llvm_compile_expr(ExprState *state)
 					LLVMPositionBuilderAtEnd(b, b_compare);
 
 					/* call function */
-					v_retval = BuildV1Call(context, b, mod, fcinfo,
+					v_retval = BuildV1Call(context, b, mod, refs, fcinfo,
 										   &v_fcinfo_isnull);
 					LLVMBuildStore(b, v_retval, v_resvaluep);
 
@@ -1752,25 +1800,25 @@ llvm_compile_expr(ExprState *state)
 				}
 
 			case EEOP_MINMAX:
-				build_EvalXFunc(b, mod, "ExecEvalMinMax",
+				build_EvalXFunc(b, mod, refs, "ExecEvalMinMax",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_FIELDSELECT:
-				build_EvalXFunc(b, mod, "ExecEvalFieldSelect",
+				build_EvalXFunc(b, mod, refs, "ExecEvalFieldSelect",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_FIELDSTORE_DEFORM:
-				build_EvalXFunc(b, mod, "ExecEvalFieldStoreDeForm",
+				build_EvalXFunc(b, mod, refs, "ExecEvalFieldStoreDeForm",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_FIELDSTORE_FORM:
-				build_EvalXFunc(b, mod, "ExecEvalFieldStoreForm",
+				build_EvalXFunc(b, mod, refs, "ExecEvalFieldStoreForm",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
@@ -1785,7 +1833,7 @@ llvm_compile_expr(ExprState *state)
 					v_fn = llvm_get_decl(mod, FuncExecEvalSubscriptingRef);
 
 					v_params[0] = v_state;
-					v_params[1] = l_ptr_const(op, l_ptr(StructExprEvalStep));
+					v_params[1] = l_data_ptr(b, refs, op, l_ptr(StructExprEvalStep));
 					v_ret = LLVMBuildCall(b, v_fn,
 										  v_params, lengthof(v_params), "");
 					v_ret = LLVMBuildZExt(b, v_ret, TypeStorageBool, "");
@@ -1813,10 +1861,10 @@ llvm_compile_expr(ExprState *state)
 					b_notavail = l_bb_before_v(opblocks[i + 1],
 											   "op.%d.notavail", i);
 
-					v_casevaluep = l_ptr_const(op->d.casetest.value,
-											   l_ptr(TypeSizeT));
-					v_casenullp = l_ptr_const(op->d.casetest.isnull,
-											  l_ptr(TypeStorageBool));
+					v_casevaluep = l_data_ptr(b, refs, op->d.casetest.value,
+											  l_ptr(TypeSizeT));
+					v_casenullp = l_data_ptr(b, refs, op->d.casetest.isnull,
+											 l_ptr(TypeStorageBool));
 
 					v_casevaluenull =
 						LLVMBuildICmp(b, LLVMIntEQ,
@@ -1853,31 +1901,31 @@ llvm_compile_expr(ExprState *state)
 				}
 
 			case EEOP_DOMAIN_NOTNULL:
-				build_EvalXFunc(b, mod, "ExecEvalConstraintNotNull",
+				build_EvalXFunc(b, mod, refs, "ExecEvalConstraintNotNull",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_DOMAIN_CHECK:
-				build_EvalXFunc(b, mod, "ExecEvalConstraintCheck",
+				build_EvalXFunc(b, mod, refs, "ExecEvalConstraintCheck",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_CONVERT_ROWTYPE:
-				build_EvalXFunc(b, mod, "ExecEvalConvertRowtype",
+				build_EvalXFunc(b, mod, refs, "ExecEvalConvertRowtype",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_SCALARARRAYOP:
-				build_EvalXFunc(b, mod, "ExecEvalScalarArrayOp",
+				build_EvalXFunc(b, mod, refs, "ExecEvalScalarArrayOp",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_XMLEXPR:
-				build_EvalXFunc(b, mod, "ExecEvalXmlExpr",
+				build_EvalXFunc(b, mod, refs, "ExecEvalXmlExpr",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
@@ -1895,8 +1943,8 @@ llvm_compile_expr(ExprState *state)
 					 * in ExecInitAgg() after initializing the expression). So
 					 * load it from memory each time round.
 					 */
-					v_aggnop = l_ptr_const(&aggref->aggno,
-										   l_ptr(LLVMInt32Type()));
+					v_aggnop = l_data_ptr(b, refs, &aggref->aggno,
+										  l_ptr(LLVMInt32Type()));
 					v_aggno = LLVMBuildLoad(b, v_aggnop, "v_aggno");
 
 					/* load agg value / null */
@@ -1912,7 +1960,7 @@ llvm_compile_expr(ExprState *state)
 				}
 
 			case EEOP_GROUPING_FUNC:
-				build_EvalXFunc(b, mod, "ExecEvalGroupingFunc",
+				build_EvalXFunc(b, mod, refs, "ExecEvalGroupingFunc",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
@@ -1930,8 +1978,8 @@ llvm_compile_expr(ExprState *state)
 					 * up in ExecInitWindowAgg() after initializing the
 					 * expression). So load it from memory each time round.
 					 */
-					v_wfuncnop = l_ptr_const(&wfunc->wfuncno,
-											 l_ptr(LLVMInt32Type()));
+					v_wfuncnop = l_data_ptr(b, refs, &wfunc->wfuncno,
+											l_ptr(LLVMInt32Type()));
 					v_wfuncno = LLVMBuildLoad(b, v_wfuncnop, "v_wfuncno");
 
 					/* load window func value / null */
@@ -1948,13 +1996,13 @@ llvm_compile_expr(ExprState *state)
 				}
 
 			case EEOP_SUBPLAN:
-				build_EvalXFunc(b, mod, "ExecEvalSubPlan",
+				build_EvalXFunc(b, mod, refs, "ExecEvalSubPlan",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_ALTERNATIVE_SUBPLAN:
-				build_EvalXFunc(b, mod, "ExecEvalAlternativeSubPlan",
+				build_EvalXFunc(b, mod, refs, "ExecEvalAlternativeSubPlan",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
@@ -1969,8 +2017,8 @@ llvm_compile_expr(ExprState *state)
 					b_deserialize = l_bb_before_v(opblocks[i + 1],
 												  "op.%d.deserialize", i);
 
-					v_fcinfo = l_ptr_const(fcinfo,
-										   l_ptr(StructFunctionCallInfoData));
+					v_fcinfo = l_data_ptr(b, refs, fcinfo,
+										  l_ptr(StructFunctionCallInfoData));
 					v_argnull0 = l_funcnull(b, v_fcinfo, 0);
 
 					LLVMBuildCondBr(b,
@@ -1999,10 +2047,10 @@ llvm_compile_expr(ExprState *state)
 					fcinfo = op->d.agg_deserialize.fcinfo_data;
 
 					v_tmpcontext =
-						l_ptr_const(aggstate->tmpcontext->ecxt_per_tuple_memory,
-									l_ptr(StructMemoryContextData));
+						l_data_ptr(b, refs, aggstate->tmpcontext->ecxt_per_tuple_memory,
+								   l_ptr(StructMemoryContextData));
 					v_oldcontext = l_mcxt_switch(mod, b, v_tmpcontext);
-					v_retval = BuildV1Call(context, b, mod, fcinfo,
+					v_retval = BuildV1Call(context, b, mod, refs, fcinfo,
 										   &v_fcinfo_isnull);
 					l_mcxt_switch(mod, b, v_oldcontext);
 
@@ -2029,8 +2077,8 @@ llvm_compile_expr(ExprState *state)
 					Assert(nargs > 0);
 
 					jumpnull = op->d.agg_strict_input_check.jumpnull;
-					v_argsp = l_ptr_const(args, l_ptr(StructNullableDatum));
-					v_nullsp = l_ptr_const(nulls, l_ptr(TypeStorageBool));
+					v_argsp = l_data_ptr(b, refs, args, l_ptr(StructNullableDatum));
+					v_nullsp = l_data_ptr(b, refs, nulls, l_ptr(TypeStorageBool));
 
 					/* create blocks for checking args */
 					b_checknulls = palloc(sizeof(LLVMBasicBlockRef *) * nargs);
@@ -2083,6 +2131,44 @@ llvm_compile_expr(ExprState *state)
 					break;
 				}
 
+			case EEOP_AGG_PLAIN_PERGROUP_NULLCHECK:
+				{
+					int			jumpnull;
+					LLVMValueRef v_aggstatep;
+					LLVMValueRef v_allpergroupsp;
+					LLVMValueRef v_pergroup_allaggs;
+					LLVMValueRef v_setoff;
+
+					jumpnull = op->d.agg_plain_pergroup_nullcheck.jumpnull;
+
+					/*
+					 * pergroup_allaggs = aggstate->all_pergroups
+					 * [op->d.agg_plain_pergroup_nullcheck.setoff];
+					 */
+					v_aggstatep = l_data_ptr(b, refs, op->d.agg_plain_pergroup_nullcheck.aggstate,
+											 l_ptr(StructAggState));
+
+					v_allpergroupsp =
+						l_load_struct_gep(b, v_aggstatep,
+										  FIELDNO_AGGSTATE_ALL_PERGROUPS,
+										  "aggstate.all_pergroups");
+
+					v_setoff =
+						l_int32_const(op->d.agg_plain_pergroup_nullcheck.setoff);
+
+					v_pergroup_allaggs = l_load_gep1(b, v_allpergroupsp,
+													 v_setoff, "");
+
+					LLVMBuildCondBr(b,
+									LLVMBuildICmp(b, LLVMIntEQ,
+												  LLVMBuildPtrToInt(b, v_pergroup_allaggs,
+																	TypeSizeT, ""),
+												  l_sizet_const(0), ""),
+									opblocks[jumpnull],
+									opblocks[i + 1]);
+					break;
+				}
+
 			case EEOP_AGG_INIT_TRANS:
 				{
 					AggState   *aggstate;
@@ -2105,10 +2191,10 @@ llvm_compile_expr(ExprState *state)
 					aggstate = op->d.agg_init_trans.aggstate;
 					pertrans = op->d.agg_init_trans.pertrans;
 
-					v_aggstatep = l_ptr_const(aggstate,
-											  l_ptr(StructAggState));
-					v_pertransp = l_ptr_const(pertrans,
-											  l_ptr(StructAggStatePerTransData));
+					v_aggstatep = l_data_ptr(b, refs, aggstate,
+											 l_ptr(StructAggState));
+					v_pertransp = l_data_ptr(b, refs, pertrans,
+											 l_ptr(StructAggStatePerTransData));
 
 					/*
 					 * pergroup = &aggstate->all_pergroups
@@ -2148,8 +2234,8 @@ llvm_compile_expr(ExprState *state)
 						LLVMValueRef v_current_set;
 						LLVMValueRef v_aggcontext;
 
-						v_aggcontext = l_ptr_const(op->d.agg_init_trans.aggcontext,
-												   l_ptr(StructExprContext));
+						v_aggcontext = l_data_ptr(b, refs, op->d.agg_init_trans.aggcontext,
+												  l_ptr(StructExprContext));
 
 						v_current_set =
 							LLVMBuildStructGEP(b,
@@ -2196,7 +2282,7 @@ llvm_compile_expr(ExprState *state)
 					int			jumpnull = op->d.agg_strict_trans_check.jumpnull;
 
 					aggstate = op->d.agg_strict_trans_check.aggstate;
-					v_aggstatep = l_ptr_const(aggstate, l_ptr(StructAggState));
+					v_aggstatep = l_data_ptr(b, refs, aggstate, l_ptr(StructAggState));
 
 					/*
 					 * pergroup = &aggstate->all_pergroups
@@ -2268,10 +2354,10 @@ llvm_compile_expr(ExprState *state)
 
 					fcinfo = pertrans->transfn_fcinfo;
 
-					v_aggstatep = l_ptr_const(aggstate,
-											  l_ptr(StructAggState));
-					v_pertransp = l_ptr_const(pertrans,
-											  l_ptr(StructAggStatePerTransData));
+					v_aggstatep = l_data_ptr(b, refs, aggstate,
+											 l_ptr(StructAggState));
+					v_pertransp = l_data_ptr(b, refs, pertrans,
+											 l_ptr(StructAggStatePerTransData));
 
 					/*
 					 * pergroup = &aggstate->all_pergroups
@@ -2289,10 +2375,10 @@ llvm_compile_expr(ExprState *state)
 									 l_load_gep1(b, v_allpergroupsp, v_setoff, ""),
 									 &v_transno, 1, "");
 
-					v_fcinfo = l_ptr_const(fcinfo,
-										   l_ptr(StructFunctionCallInfoData));
-					v_aggcontext = l_ptr_const(op->d.agg_trans.aggcontext,
-											   l_ptr(StructExprContext));
+					v_fcinfo = l_data_ptr(b, refs, fcinfo,
+										  l_ptr(StructFunctionCallInfoData));
+					v_aggcontext = l_data_ptr(b, refs, op->d.agg_trans.aggcontext,
+											  l_ptr(StructExprContext));
 
 					v_current_setp =
 						LLVMBuildStructGEP(b,
@@ -2318,8 +2404,8 @@ llvm_compile_expr(ExprState *state)
 
 					/* invoke transition function in per-tuple context */
 					v_tmpcontext =
-						l_ptr_const(aggstate->tmpcontext->ecxt_per_tuple_memory,
-									l_ptr(StructMemoryContextData));
+						l_data_ptr(b, refs, aggstate->tmpcontext->ecxt_per_tuple_memory,
+								   l_ptr(StructMemoryContextData));
 					v_oldcontext = l_mcxt_switch(mod, b, v_tmpcontext);
 
 					/* store transvalue in fcinfo->args[0] */
@@ -2340,7 +2426,7 @@ llvm_compile_expr(ExprState *state)
 								   l_funcnullp(b, v_fcinfo, 0));
 
 					/* and invoke transition function */
-					v_retval = BuildV1Call(context, b, mod, fcinfo,
+					v_retval = BuildV1Call(context, b, mod, refs, fcinfo,
 										   &v_fcinfo_isnull);
 
 					/*
@@ -2420,13 +2506,13 @@ llvm_compile_expr(ExprState *state)
 				}
 
 			case EEOP_AGG_ORDERED_TRANS_DATUM:
-				build_EvalXFunc(b, mod, "ExecEvalAggOrderedTransDatum",
+				build_EvalXFunc(b, mod, refs, "ExecEvalAggOrderedTransDatum",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
 
 			case EEOP_AGG_ORDERED_TRANS_TUPLE:
-				build_EvalXFunc(b, mod, "ExecEvalAggOrderedTransTuple",
+				build_EvalXFunc(b, mod, refs, "ExecEvalAggOrderedTransTuple",
 								v_state, v_econtext, op);
 				LLVMBuildBr(b, opblocks[i + 1]);
 				break;
@@ -2449,6 +2535,7 @@ llvm_compile_expr(ExprState *state)
 
 		CompiledExprState *cstate = palloc0(sizeof(CompiledExprState));
 
+		cstate->dataptrs = refs ? refs->ptrs : NULL;
 		cstate->context = context;
 		cstate->funcname = funcname;
 
@@ -2493,10 +2580,31 @@ ExecRunCompiledExpr(ExprState *state, ExprContext *econtext, bool *isNull)
 	return func(state, econtext, isNull);
 }
 
+/*
+ * Return the name of the function generated for a JIT compiled expression,
+ * if it has not been emitted yet and so can still be called directly from
+ * other code generated in context's current module.  Otherwise NULL.
+ */
+const char *
+llvm_compiled_expr_funcname(LLVMJitContext *context, ExprState *state)
+{
+	CompiledExprState *cstate;
+
+	if (state->evalfunc != ExecRunCompiledExpr)
+		return NULL;
+
+	cstate = (CompiledExprState *) state->evalfunc_private;
+	if (cstate->context != context || context->module == NULL ||
+		LLVMGetNamedFunction(context->module, cstate->funcname) == NULL)
+		return NULL;
+
+	return cstate->funcname;
+}
+
 static LLVMValueRef
 BuildV1Call(LLVMJitContext *context, LLVMBuilderRef b,
-			LLVMModuleRef mod, FunctionCallInfo fcinfo,
-			LLVMValueRef *v_fcinfo_isnull)
+			LLVMModuleRef mod, LLVMJitDataRefs *refs,
+			FunctionCallInfo fcinfo, LLVMValueRef *v_fcinfo_isnull)
 {
 	LLVMValueRef v_fn;
 	LLVMValueRef v_fcinfo_isnullp;
@@ -2505,7 +2613,7 @@ BuildV1Call(LLVMJitContext *context, LLVMBuilderRef b,
 
 	v_fn = llvm_function_reference(context, b, mod, fcinfo);
 
-	v_fcinfo = l_ptr_const(fcinfo, l_ptr(StructFunctionCallInfoData));
+	v_fcinfo = l_data_ptr(b, refs, fcinfo, l_ptr(StructFunctionCallInfoData));
 	v_fcinfo_isnullp = LLVMBuildStructGEP(b, v_fcinfo,
 										  FIELDNO_FUNCTIONCALLINFODATA_ISNULL,
 										  "v_fcinfo_isnull");
@@ -2525,11 +2633,11 @@ BuildV1Call(LLVMJitContext *context, LLVMBuilderRef b,
 		LLVMValueRef params[2];
 
 		params[0] = l_int64_const(sizeof(NullableDatum) * fcinfo->nargs);
-		params[1] = l_ptr_const(fcinfo->args, l_ptr(LLVMInt8Type()));
+		params[1] = l_data_ptr(b, refs, fcinfo->args, l_ptr(LLVMInt8Type()));
 		LLVMBuildCall(b, v_lifetime, params, lengthof(params), "");
 
 		params[0] = l_int64_const(sizeof(fcinfo->isnull));
-		params[1] = l_ptr_const(&fcinfo->isnull, l_ptr(LLVMInt8Type()));
+		params[1] = l_data_ptr(b, refs, &fcinfo->isnull, l_ptr(LLVMInt8Type()));
 		LLVMBuildCall(b, v_lifetime, params, lengthof(params), "");
 	}
 
@@ -2540,7 +2648,8 @@ BuildV1Call(LLVMJitContext *context, LLVMBuilderRef b,
  * Implement an expression step by calling the function funcname.
  */
 static void
-build_EvalXFunc(LLVMBuilderRef b, LLVMModuleRef mod, const char *funcname,
+build_EvalXFunc(LLVMBuilderRef b, LLVMModuleRef mod,
+				LLVMJitDataRefs *refs, const char *funcname,
 				LLVMValueRef v_state, LLVMValueRef v_econtext,
 				ExprEvalStep *op)
 {
@@ -2563,7 +2672,7 @@ build_EvalXFunc(LLVMBuilderRef b, LLVMModuleRef mod, const char *funcname,
 	}
 
 	params[0] = v_state;
-	params[1] = l_ptr_const(op, l_ptr(StructExprEvalStep));
+	params[1] = l_data_ptr(b, refs, op, l_ptr(StructExprEvalStep));
 	params[2] = v_econtext;
 
 	LLVMBuildCall(b,
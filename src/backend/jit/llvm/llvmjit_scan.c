@@ -0,0 +1,477 @@
+/*-------------------------------------------------------------------------
+ *
+ * llvmjit_scan.c
+ *	  Generate code for the tuple loop of scan nodes.
+ *
+ * ExecScan() fetches each tuple through the node's access method, and then
+ * evaluates the qual and the projection through their ExprStates' evalfunc
+ * pointers.  The generated function performs the same loop for one specific
+ * node, but calls the JIT compiled qual and projection of the node directly.
+ * As those are emitted into the same module, that allows LLVM to inline them
+ * into the loop, so that a scan, its filter and its projection end up as a
+ * single piece of code.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/jit/llvm/llvmjit_scan.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <signal.h>
+
+#include <llvm-c/Core.h>
+
+#include "executor/execExpr.h"
+#include "executor/executor.h"
+#include "jit/llvmjit.h"
+#include "jit/llvmjit_emit.h"
+#include "miscadmin.h"
+#include "utils/memutils.h"
+
+
+typedef struct CompiledScanState
+{
+	/* must be first, generated code loads it via ExecProcNodePrivate */
+	void	  **dataptrs;
+	LLVMJitContext *context;
+	const char *funcname;
+} CompiledScanState;
+
+
+static TupleTableSlot *ExecRunCompiledScan(PlanState *pstate);
+static LLVMValueRef build_EvalExprSwitchContext(LLVMJitContext *context,
+												LLVMBuilderRef b,
+												LLVMModuleRef mod,
+												LLVMJitDataRefs *refs,
+												ExprState *state,
+												ExprContext *econtext,
+												LLVMValueRef v_isnullp);
+
+
+/*
+ * JIT compile the tuple loop of a scan node that would otherwise be executed
+ * by ExecScan(node, accessMtd, ...).
+ */
+bool
+llvm_compile_scan(ScanState *node, JitScanAccessMtd accessMtd)
+{
+	PlanState  *parent = &node->ps;
+	EState	   *estate = parent->state;
+	ExprState  *qual = parent->qual;
+	ProjectionInfo *projInfo = parent->ps_ProjInfo;
+	ExprContext *econtext = parent->ps_ExprContext;
+	TupleTableSlot *resultslot = NULL;
+	char	   *funcname;
+
+	LLVMJitContext *context;
+	LLVMModuleRef mod;
+	LLVMBuilderRef b;
+
+	LLVMTypeRef scan_sig;
+	LLVMTypeRef access_sig;
+	LLVMTypeRef clear_sig;
+	LLVMValueRef v_scan_fn;
+
+	LLVMBasicBlockRef b_entry;
+	LLVMBasicBlockRef b_loop;
+	LLVMBasicBlockRef b_interrupt;
+	LLVMBasicBlockRef b_fetch;
+	LLVMBasicBlockRef b_checkempty;
+	LLVMBasicBlockRef b_done;
+	LLVMBasicBlockRef b_tuple;
+	LLVMBasicBlockRef b_reject;
+	LLVMBasicBlockRef b_count;
+	LLVMBasicBlockRef b_next;
+	LLVMBasicBlockRef b_pass;
+
+	LLVMValueRef v_node;
+	LLVMValueRef v_tmpcontext;
+	LLVMValueRef v_isnullp;
+	LLVMValueRef v_slot;
+	LLVMValueRef v_resultslot = NULL;
+	LLVMValueRef v_clear = NULL;
+
+	/* pointers loaded at runtime, if the code may be cached */
+	LLVMJitDataRefs refsdata;
+	LLVMJitDataRefs *refs = NULL;
+
+	instr_time	starttime;
+	instr_time	endtime;
+
+	/*
+	 * EvalPlanQual rechecks need ExecScan()'s handling of substitute tuples.
+	 * And without a qual or a projection, ExecScan() just returns what the
+	 * access method fetched, so there is nothing to gain.
+	 */
+	if (estate->es_epqTupleSlot != NULL)
+		return false;
+	if (qual == NULL && projInfo == NULL)
+		return false;
+
+	llvm_enter_fatal_on_oom();
+
+	/* get or create JIT context */
+	if (estate->es_jit)
+		context = (LLVMJitContext *) estate->es_jit;
+	else
+	{
+		context = llvm_create_context(estate->es_jit_flags);
+		estate->es_jit = &context->base;
+	}
+
+	INSTR_TIME_SET_CURRENT(starttime);
+
+	mod = llvm_mutable_module(context);
+
+	b = LLVMCreateBuilder();
+
+	funcname = llvm_expand_funcname(context, "execscan");
+
+	/* TupleTableSlot *execscan(PlanState *pstate) */
+	{
+		LLVMTypeRef param_types[1];
+
+		param_types[0] = l_ptr(LLVMInt8Type());
+		scan_sig = LLVMFunctionType(l_ptr(StructTupleTableSlot),
+									param_types, lengthof(param_types),
+									false);
+		access_sig = LLVMFunctionType(l_ptr(StructTupleTableSlot),
+									  param_types, lengthof(param_types),
+									  false);
+
+		param_types[0] = l_ptr(StructTupleTableSlot);
+		clear_sig = LLVMFunctionType(LLVMVoidType(),
+									 param_types, lengthof(param_types),
+									 false);
+	}
+	v_scan_fn = LLVMAddFunction(mod, funcname, scan_sig);
+	LLVMSetLinkage(v_scan_fn, LLVMExternalLinkage);
+	LLVMSetVisibility(v_scan_fn, LLVMDefaultVisibility);
+	llvm_copy_attributes(AttributeTemplate, v_scan_fn);
+
+	b_entry = LLVMAppendBasicBlock(v_scan_fn, "entry");
+	b_loop = l_bb_append_v(v_scan_fn, "loop");
+	b_interrupt = l_bb_append_v(v_scan_fn, "interrupt");
+	b_fetch = l_bb_append_v(v_scan_fn, "fetch");
+	b_checkempty = l_bb_append_v(v_scan_fn, "checkempty");
+	b_done = l_bb_append_v(v_scan_fn, "done");
+	b_tuple = l_bb_append_v(v_scan_fn, "tuple");
+	b_reject = l_bb_append_v(v_scan_fn, "reject");
+	b_count = l_bb_append_v(v_scan_fn, "count");
+	b_next = l_bb_append_v(v_scan_fn, "next");
+	b_pass = l_bb_append_v(v_scan_fn, "pass");
+
+	LLVMPositionBuilderAtEnd(b, b_entry);
+
+	/*
+	 * The node, its expression context and its result slot live as long as
+	 * the generated code, so they can be embedded as constants. Unless the
+	 * code may be cached for later executions, in which case they're loaded
+	 * from a table hanging off the CompiledScanState.
+	 */
+	if (jit_cache_entries > 0)
+	{
+		LLVMValueRef v_off = l_int32_const(offsetof(PlanState,
+													ExecProcNodePrivate));
+		LLVMValueRef v_cstatep;
+
+		memset(&refsdata, 0, sizeof(refsdata));
+		refs = &refsdata;
+
+		v_cstatep = LLVMBuildGEP(b, LLVMGetParam(v_scan_fn, 0), &v_off, 1, "");
+		v_cstatep = LLVMBuildBitCast(b, v_cstatep,
+									 l_ptr(l_ptr(l_ptr(l_ptr(LLVMInt8Type())))),
+									 "");
+		v_cstatep = LLVMBuildLoad(b, v_cstatep, "v_cstate");
+		refs->v_ptrs = LLVMBuildLoad(b, v_cstatep, "v_dataptrs");
+	}
+
+	v_node = l_data_ptr(b, refs, node, l_ptr(LLVMInt8Type()));
+	v_tmpcontext = l_data_ptr(b, refs, econtext->ecxt_per_tuple_memory,
+							  l_ptr(StructMemoryContextData));
+	if (projInfo)
+	{
+		resultslot = projInfo->pi_state.resultslot;
+		v_resultslot = l_data_ptr(b, refs, resultslot,
+								  l_ptr(StructTupleTableSlot));
+		v_clear = l_ptr_const(resultslot->tts_ops->clear, l_ptr(clear_sig));
+	}
+
+	/*
+	 * Entry: reset per-tuple memory context to free any expression
+	 * evaluation storage allocated in the previous tuple cycle.
+	 */
+	v_isnullp = LLVMBuildAlloca(b, TypeParamBool, "v_isnullp");
+	LLVMBuildCall(b, llvm_get_decl(mod, FuncMemoryContextReset),
+				  &v_tmpcontext, 1, "");
+	LLVMBuildBr(b, b_loop);
+
+	/* CHECK_FOR_INTERRUPTS() */
+	LLVMPositionBuilderAtEnd(b, b_loop);
+	{
+		LLVMTypeRef pending_type = LLVMIntType(sizeof(sig_atomic_t) * 8);
+		LLVMValueRef v_pending;
+
+		v_pending = LLVMBuildLoad(b,
+								  l_ptr_const((void *) &InterruptPending,
+											  l_ptr(pending_type)),
+								  "pending");
+		LLVMSetVolatile(v_pending, true);
+		LLVMBuildCondBr(b,
+						LLVMBuildICmp(b, LLVMIntNE, v_pending,
+									  LLVMConstInt(pending_type, 0, false),
+									  ""),
+						b_interrupt, b_fetch);
+	}
+
+	LLVMPositionBuilderAtEnd(b, b_interrupt);
+	LLVMBuildCall(b, llvm_get_decl(mod, FuncProcessInterrupts), NULL, 0, "");
+	LLVMBuildBr(b, b_fetch);
+
+	/* fetch the next tuple through the access method */
+	LLVMPositionBuilderAtEnd(b, b_fetch);
+	v_slot = LLVMBuildCall(b,
+						   l_ptr_const((void *) accessMtd, l_ptr(access_sig)),
+						   &v_node, 1, "slot");
+	LLVMBuildCondBr(b,
+					LLVMBuildIsNull(b, v_slot, ""),
+					b_done, b_checkempty);
+
+	LLVMPositionBuilderAtEnd(b, b_checkempty);
+	{
+		LLVMValueRef v_flags;
+
+		v_flags = l_load_struct_gep(b, v_slot, FIELDNO_TUPLETABLESLOT_FLAGS,
+									"tts_flags");
+		LLVMBuildCondBr(b,
+						LLVMBuildICmp(b, LLVMIntNE,
+									  LLVMBuildAnd(b, v_flags,
+												   l_int16_const(TTS_FLAG_EMPTY),
+												   ""),
+									  l_int16_const(0), ""),
+						b_done, b_tuple);
+	}
+
+	/* end of scan, return an empty slot like ExecScan() does */
+	LLVMPositionBuilderAtEnd(b, b_done);
+	if (projInfo)
+	{
+		LLVMBuildCall(b, v_clear, &v_resultslot, 1, "");
+		LLVMBuildRet(b, v_resultslot);
+	}
+	else
+		LLVMBuildRet(b, v_slot);
+
+	/* make the tuple the scan tuple, and check the qual */
+	LLVMPositionBuilderAtEnd(b, b_tuple);
+	LLVMBuildStore(b, v_slot,
+				   l_data_ptr(b, refs, &econtext->ecxt_scantuple,
+							  l_ptr(l_ptr(StructTupleTableSlot))));
+	if (qual)
+	{
+		LLVMValueRef v_qual;
+
+		/* the qual can't return NULL, see ExecQual() */
+		v_qual = build_EvalExprSwitchContext(context, b, mod, refs, qual,
+											 econtext, v_isnullp);
+		LLVMBuildCondBr(b,
+						LLVMBuildICmp(b, LLVMIntNE, v_qual,
+									  l_sizet_const(0), ""),
+						b_pass, b_reject);
+	}
+	else
+		LLVMBuildBr(b, b_pass);
+
+	/* InstrCountFiltered1(node, 1) */
+	LLVMPositionBuilderAtEnd(b, b_reject);
+	{
+		LLVMValueRef v_instr;
+
+		v_instr = LLVMBuildLoad(b,
+								l_data_ptr(b, refs, &parent->instrument,
+										   l_ptr(l_ptr(LLVMInt8Type()))),
+								"instrument");
+		LLVMBuildCondBr(b, LLVMBuildIsNull(b, v_instr, ""), b_next, b_count);
+
+		LLVMPositionBuilderAtEnd(b, b_count);
+		{
+			LLVMValueRef v_off = l_int32_const(offsetof(Instrumentation,
+														nfiltered1));
+			LLVMValueRef v_nfilteredp;
+			LLVMValueRef v_nfiltered;
+
+			v_nfilteredp = LLVMBuildGEP(b, v_instr, &v_off, 1, "");
+			v_nfilteredp = LLVMBuildBitCast(b, v_nfilteredp,
+											l_ptr(LLVMDoubleType()), "");
+			v_nfiltered = LLVMBuildLoad(b, v_nfilteredp, "nfiltered1");
+			v_nfiltered = LLVMBuildFAdd(b, v_nfiltered,
+										LLVMConstReal(LLVMDoubleType(), 1.0),
+										"");
+			LLVMBuildStore(b, v_nfiltered, v_nfilteredp);
+			LLVMBuildBr(b, b_next);
+		}
+	}
+
+	LLVMPositionBuilderAtEnd(b, b_next);
+	LLVMBuildCall(b, llvm_get_decl(mod, FuncMemoryContextReset),
+				  &v_tmpcontext, 1, "");
+	LLVMBuildBr(b, b_loop);
+
+	/* the tuple qualifies, form the projection if required */
+	LLVMPositionBuilderAtEnd(b, b_pass);
+	if (projInfo)
+	{
+		LLVMValueRef v_flagsp;
+		LLVMValueRef v_flags;
+
+		/* see ExecProject() */
+		LLVMBuildCall(b, v_clear, &v_resultslot, 1, "");
+		build_EvalExprSwitchContext(context, b, mod, refs,
+									&projInfo->pi_state, econtext, v_isnullp);
+
+		v_flagsp = LLVMBuildStructGEP(b, v_resultslot,
+									  FIELDNO_TUPLETABLESLOT_FLAGS, "");
+		v_flags = LLVMBuildLoad(b, v_flagsp, "tts_flags");
+		v_flags = LLVMBuildAnd(b, v_flags,
+							   l_int16_const(~TTS_FLAG_EMPTY), "");
+		LLVMBuildStore(b, v_flags, v_flagsp);
+		LLVMBuildStore(b,
+					   l_int16_const(resultslot->tts_tupleDescriptor->natts),
+					   LLVMBuildStructGEP(b, v_resultslot,
+										  FIELDNO_TUPLETABLESLOT_NVALID, ""));
+		LLVMBuildRet(b, v_resultslot);
+	}
+	else
+		LLVMBuildRet(b, v_slot);
+
+	LLVMDisposeBuilder(b);
+
+	/*
+	 * As for expressions, don't emit the function right away, but only when
+	 * the node is first executed.
+	 */
+	{
+		CompiledScanState *cstate = palloc0(sizeof(CompiledScanState));
+
+		cstate->dataptrs = refs ? refs->ptrs : NULL;
+		cstate->context = context;
+		cstate->funcname = funcname;
+
+		parent->ExecProcNode = ExecRunCompiledScan;
+		parent->ExecProcNodePrivate = cstate;
+	}
+
+	llvm_leave_fatal_on_oom();
+
+	INSTR_TIME_SET_CURRENT(endtime);
+	INSTR_TIME_ACCUM_DIFF(context->base.instr.generation_counter,
+						  endtime, starttime);
+
+	return true;
+}
+
+/*
+ * Run compiled scan.
+ *
+ * This will only be called the first time the node is executed.  Get a
+ * pointer to the emitted function, which can be the first thing that
+ * triggers optimizing and emitting all the generated functions.
+ *
+ * The generated loop calls the node's compiled qual and projection directly,
+ * bypassing ExecRunCompiledExpr(), so perform the check that it would have
+ * done on their first evaluation here.
+ */
+static TupleTableSlot *
+ExecRunCompiledScan(PlanState *pstate)
+{
+	CompiledScanState *cstate = pstate->ExecProcNodePrivate;
+	ExprContext *econtext = pstate->ps_ExprContext;
+	ExecProcNodeMtd func;
+
+	/* the expressions are only ever evaluated against the scan tuple */
+	econtext->ecxt_scantuple = ((ScanState *) pstate)->ss_ScanTupleSlot;
+	if (pstate->qual)
+		CheckExprStillValid(pstate->qual, econtext);
+	if (pstate->ps_ProjInfo)
+		CheckExprStillValid(&pstate->ps_ProjInfo->pi_state, econtext);
+
+	llvm_enter_fatal_on_oom();
+	func = (ExecProcNodeMtd) llvm_get_function(cstate->context,
+											   cstate->funcname);
+	llvm_leave_fatal_on_oom();
+	Assert(func);
+
+	/* remove indirection via this function for future calls */
+	if (pstate->ExecProcNode == ExecRunCompiledScan)
+		pstate->ExecProcNode = func;
+	if (pstate->ExecProcNodeReal == ExecRunCompiledScan)
+		pstate->ExecProcNodeReal = func;
+
+	return func(pstate);
+}
+
+/*
+ * Emit the equivalent of ExecEvalExprSwitchContext(state, econtext, isnull).
+ *
+ * If the expression was JIT compiled into the current module, call the
+ * generated function directly, so it can be inlined.  Otherwise call
+ * whatever state->evalfunc points to at the time.
+ */
+static LLVMValueRef
+build_EvalExprSwitchContext(LLVMJitContext *context, LLVMBuilderRef b,
+							LLVMModuleRef mod, LLVMJitDataRefs *refs,
+							ExprState *state, ExprContext *econtext,
+							LLVMValueRef v_isnullp)
+{
+	const char *exprfuncname;
+	LLVMTypeRef eval_sig;
+	LLVMValueRef v_fn;
+	LLVMValueRef v_curcontextp;
+	LLVMValueRef v_oldcontext;
+	LLVMValueRef v_retval;
+	LLVMValueRef params[3];
+
+	{
+		LLVMTypeRef param_types[3];
+
+		param_types[0] = l_ptr(StructExprState);	/* state */
+		param_types[1] = l_ptr(StructExprContext);	/* econtext */
+		param_types[2] = l_ptr(TypeParamBool);	/* isnull */
+
+		eval_sig = LLVMFunctionType(TypeSizeT,
+									param_types, lengthof(param_types),
+									false);
+	}
+
+	exprfuncname = llvm_compiled_expr_funcname(context, state);
+	if (exprfuncname)
+		v_fn = LLVMGetNamedFunction(mod, exprfuncname);
+	else
+		v_fn = LLVMBuildLoad(b,
+							 l_data_ptr(b, refs, &state->evalfunc,
+										l_ptr(l_ptr(eval_sig))),
+							 "evalfunc");
+
+	/* MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory) */
+	v_curcontextp = l_ptr_const(&CurrentMemoryContext,
+								l_ptr(l_ptr(StructMemoryContextData)));
+	v_oldcontext = LLVMBuildLoad(b, v_curcontextp, "oldcontext");
+	LLVMBuildStore(b,
+				   l_data_ptr(b, refs, econtext->ecxt_per_tuple_memory,
+							  l_ptr(StructMemoryContextData)),
+				   v_curcontextp);
+
+	params[0] = l_data_ptr(b, refs, state, l_ptr(StructExprState));
+	params[1] = l_data_ptr(b, refs, econtext, l_ptr(StructExprContext));
+	params[2] = v_isnullp;
+	v_retval = LLVMBuildCall(b, v_fn, params, lengthof(params), "");
+
+	LLVMBuildStore(b, v_oldcontext, v_curcontextp);
+
+	return v_retval;
+}
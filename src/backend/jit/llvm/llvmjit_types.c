@@ -34,9 +34,11 @@
 #include "executor/nodeAgg.h"
 #include "executor/tuptable.h"
 #include "fmgr.h"
+#include "miscadmin.h"
 #include "nodes/execnodes.h"
 #include "nodes/memnodes.h"
 #include "utils/expandeddatum.h"
+#include "utils/memutils.h"
 #include "utils/palloc.h"
 
 
@@ -106,5 +108,7 @@ void	   *referenced_functions[] =
 	ExecEvalSubscriptingRef,
 	ExecEvalSysVar,
 	ExecAggTransReparent,
-	ExecAggInitGroup
+	ExecAggInitGroup,
+	MemoryContextReset,
+	ProcessInterrupts
 };
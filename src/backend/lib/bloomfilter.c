@@ -51,6 +51,8 @@ struct bloom_filter
 	unsigned char bitset[FLEXIBLE_ARRAY_MEMBER];
 };
 
+static bloom_filter *bloom_create_internal(int64 total_elems,
+										   uint64 bitset_bytes, uint64 seed);
 static int	my_bloom_power(uint64 target_bitset_bits);
 static int	optimal_k(uint64 bitset_bits, int64 total_elems);
 static void k_hashes(bloom_filter *filter, uint32 *hashes, unsigned char *elem,
@@ -87,10 +89,7 @@ static inline uint32 mod_m(uint32 a, uint64 m);
 bloom_filter *
 bloom_create(int64 total_elems, int bloom_work_mem, uint64 seed)
 {
-	bloom_filter *filter;
-	int			bloom_power;
 	uint64		bitset_bytes;
-	uint64		bitset_bits;
 
 	/*
 	 * Aim for two bytes per element; this is sufficient to get a false
@@ -102,6 +101,41 @@ bloom_create(int64 total_elems, int bloom_work_mem, uint64 seed)
 	bitset_bytes = Min(bloom_work_mem * UINT64CONST(1024), total_elems * 2);
 	bitset_bytes = Max(1024 * 1024, bitset_bytes);
 
+	return bloom_create_internal(total_elems, bitset_bytes, seed);
+}
+
+/*
+ * Create Bloom filter in caller's memory context, with a bitset no larger
+ * than max_bytes.
+ *
+ * Unlike bloom_create(), this doesn't insist on a bitset of at least 1MB, so
+ * it suits callers that must keep a small set within a tight memory budget.
+ * If max_bytes is less than two bytes per element, the false positive rate
+ * will be higher than bloom_create() aims for.
+ */
+bloom_filter *
+bloom_create_bounded(int64 total_elems, Size max_bytes, uint64 seed)
+{
+	uint64		bitset_bytes;
+
+	bitset_bytes = Min((uint64) max_bytes, total_elems * 2);
+	bitset_bytes = Max(1, bitset_bytes);
+
+	return bloom_create_internal(total_elems, bitset_bytes, seed);
+}
+
+/*
+ * Workhorse for bloom_create() and bloom_create_bounded(): create a Bloom
+ * filter whose bitset is the largest power of two bits that fits in
+ * bitset_bytes.
+ */
+static bloom_filter *
+bloom_create_internal(int64 total_elems, uint64 bitset_bytes, uint64 seed)
+{
+	bloom_filter *filter;
+	int			bloom_power;
+	uint64		bitset_bits;
+
 	/*
 	 * Size in bits should be the highest power of two <= target.  bitset_bits
 	 * is uint64 because PG_UINT32_MAX is 2^32 - 1, not 2^32
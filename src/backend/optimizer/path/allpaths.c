@@ -23,6 +23,7 @@
 #include "catalog/pg_class.h"
 #include "catalog/pg_operator.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
 #include "foreign/fdwapi.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
@@ -35,6 +36,7 @@
 #include "optimizer/cost.h"
 #include "optimizer/geqo.h"
 #include "optimizer/inherit.h"
+#include "optimizer/joininfo.h"
 #include "optimizer/optimizer.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
@@ -43,11 +45,13 @@
 #include "optimizer/restrictinfo.h"
 #include "optimizer/tlist.h"
 #include "parser/parse_clause.h"
+#include "parser/parse_oper.h"
 #include "parser/parsetree.h"
 #include "partitioning/partbounds.h"
 #include "partitioning/partprune.h"
 #include "rewrite/rewriteManip.h"
 #include "utils/lsyscache.h"
+#include "utils/selfuncs.h"
 
 
 /* results of subquery_is_pushdown_safe */
@@ -61,6 +65,7 @@ typedef struct pushdown_safety_info
 /* These parameters are set by GUC */
 bool		enable_geqo = false;	/* just in case GUC doesn't set it */
 int			geqo_threshold;
+int			large_join_search = LARGE_JOIN_SEARCH_GEQO;
 int			min_parallel_table_scan_size;
 int			min_parallel_index_scan_size;
 
@@ -125,6 +130,8 @@ static void set_result_pathlist(PlannerInfo *root, RelOptInfo *rel,
 static void set_worktable_pathlist(PlannerInfo *root, RelOptInfo *rel,
 								   RangeTblEntry *rte);
 static RelOptInfo *make_rel_from_joinlist(PlannerInfo *root, List *joinlist);
+static RelOptInfo **linearize_join_rels(PlannerInfo *root, List *initial_rels);
+static RelOptInfo *make_eager_agg_rel(PlannerInfo *root, List *joinlist);
 static bool subquery_is_pushdown_safe(Query *subquery, Query *topquery,
 									  pushdown_safety_info *safetyInfo);
 static bool recurse_pushdown_safe(Node *setOp, Query *topquery,
@@ -231,6 +238,13 @@ make_one_rel(PlannerInfo *root, List *joinlist)
 	 */
 	Assert(bms_equal(rel->relids, root->all_baserels));
 
+	/*
+	 * Also consider partially aggregating one of the base rels before it is
+	 * joined to the rest, if grouping_planner() can make use of that.
+	 */
+	if (enable_eager_aggregate)
+		root->eager_agg_rel = make_eager_agg_rel(root, joinlist);
+
 	return rel;
 }
 
@@ -2797,7 +2811,8 @@ make_rel_from_joinlist(PlannerInfo *root, List *joinlist)
 	{
 		/*
 		 * Consider the different orders in which we could join the rels,
-		 * using a plugin, GEQO, or the regular join search code.
+		 * using a plugin, one of the heuristic searches for large join
+		 * problems, or the regular join search code.
 		 *
 		 * We put the initial_rels list into a PlannerInfo field because
 		 * has_legal_joinclause() needs to look at it (ugly :-().
@@ -2806,6 +2821,9 @@ make_rel_from_joinlist(PlannerInfo *root, List *joinlist)
 
 		if (join_search_hook)
 			return (*join_search_hook) (root, levels_needed, initial_rels);
+		else if (enable_geqo && levels_needed >= geqo_threshold &&
+				 large_join_search == LARGE_JOIN_SEARCH_LINEARIZED)
+			return linearized_join_search(root, levels_needed, initial_rels);
 		else if (enable_geqo && levels_needed >= geqo_threshold)
 			return geqo(root, levels_needed, initial_rels);
 		else
@@ -2927,6 +2945,474 @@ standard_join_search(PlannerInfo *root, int levels_needed, List *initial_rels)
 	return rel;
 }
 
+/*
+ * linearized_join_search
+ *	  Find a join order for a large join problem by dynamic programming over
+ *	  a single linear ordering of the jointree items.
+ *
+ * This is an alternative to GEQO for problems too large for
+ * standard_join_search().  We first put the initial_rels into a heuristic
+ * order (see linearize_join_rels), then consider each contiguous run of
+ * items in that order as a join relation, building it from every pair of
+ * adjacent shorter runs.  That creates O(n^2) join relations with O(n^3)
+ * make_join_rel() calls, which stays cheap for queries joining dozens of
+ * relations, yet still admits bushy plans.  Unlike GEQO, the result does
+ * not depend on a random seed.
+ *
+ * If the ordering admits no legal way to join all the items, which can
+ * happen when outer joins constrain the join order in ways the heuristic
+ * did not anticipate, we discard the join relations built so far and let
+ * GEQO solve the problem instead.
+ */
+RelOptInfo *
+linearized_join_search(PlannerInfo *root, int levels_needed, List *initial_rels)
+{
+	RelOptInfo **order;
+	RelOptInfo **runs;
+	int			savelength;
+	struct HTAB *savehash;
+	int			len;
+	int			i;
+	RelOptInfo *rel;
+
+	Assert(root->join_rel_level == NULL);
+	Assert(levels_needed == list_length(initial_rels));
+
+	order = linearize_join_rels(root, initial_rels);
+
+	/* runs[i * levels_needed + j] is the join of order[i] .. order[j] */
+#define RUN(i, j)	runs[(i) * levels_needed + (j)]
+	runs = (RelOptInfo **)
+		palloc0(levels_needed * levels_needed * sizeof(RelOptInfo *));
+	for (i = 0; i < levels_needed; i++)
+		RUN(i, i) = order[i];
+
+	/*
+	 * Remember the join_rel_list state so that we can undo our work if we
+	 * have to fall back to GEQO.  As in geqo_eval(), we start with a fresh
+	 * join_rel_hash so the saved one is never polluted with our entries.
+	 */
+	savelength = list_length(root->join_rel_list);
+	savehash = root->join_rel_hash;
+	root->join_rel_hash = NULL;
+
+	for (len = 2; len <= levels_needed; len++)
+	{
+		for (i = 0; i + len <= levels_needed; i++)
+		{
+			int			j = i + len - 1;
+			RelOptInfo *joinrel = NULL;
+			int			pass;
+
+			/*
+			 * First try only the splits whose two sides are linked by a join
+			 * clause or a join order restriction.  If none of those yields a
+			 * legal join, consider clauseless joins too, much as
+			 * join_search_one_level() does.
+			 */
+			for (pass = 0; pass < 2 && joinrel == NULL; pass++)
+			{
+				int			k;
+
+				for (k = i; k < j; k++)
+				{
+					RelOptInfo *left = RUN(i, k);
+					RelOptInfo *right = RUN(k + 1, j);
+					RelOptInfo *result;
+
+					if (left == NULL || right == NULL)
+						continue;
+					if (pass == 0 &&
+						!have_relevant_joinclause(root, left, right) &&
+						!have_join_order_restriction(root, left, right))
+						continue;
+
+					result = make_join_rel(root, left, right);
+					if (result != NULL)
+						joinrel = result;
+				}
+			}
+
+			if (joinrel != NULL)
+			{
+				/*
+				 * As in standard_join_search(), we're now done adding paths
+				 * for this joinrel, save for partitionwise and gather paths.
+				 */
+				generate_partitionwise_join_paths(root, joinrel);
+				if (len < levels_needed)
+					generate_gather_paths(root, joinrel, false);
+				set_cheapest(joinrel);
+
+#ifdef OPTIMIZER_DEBUG
+				debug_print_rel(root, joinrel);
+#endif
+			}
+
+			RUN(i, j) = joinrel;
+		}
+	}
+
+	rel = RUN(0, levels_needed - 1);
+#undef RUN
+
+	pfree(runs);
+	pfree(order);
+
+	if (rel == NULL)
+	{
+		root->join_rel_list = list_truncate(root->join_rel_list, savelength);
+		root->join_rel_hash = savehash;
+		return geqo(root, levels_needed, initial_rels);
+	}
+
+	return rel;
+}
+
+/*
+ * linearize_join_rels
+ *	  Choose the ordering of jointree items used by linearized_join_search.
+ *
+ * We grow the ordering greedily.  We start with the item with the fewest
+ * estimated rows.  Then we repeatedly append the smallest remaining item that
+ * has a join clause or join order restriction with some item already placed,
+ * or the smallest remaining item if none is connected.  Keeping connected
+ * items next to each other lets the dynamic programming step avoid Cartesian
+ * products, and placing small inputs first tends to keep intermediate results
+ * small.
+ *
+ * Returns a palloc'd array of list_length(initial_rels) entries.
+ */
+static RelOptInfo **
+linearize_join_rels(PlannerInfo *root, List *initial_rels)
+{
+	int			nrels = list_length(initial_rels);
+	RelOptInfo **rels;
+	RelOptInfo **order;
+	bool	   *placed;
+	bool	   *connected;
+	ListCell   *lc;
+	int			n;
+	int			i;
+
+	rels = (RelOptInfo **) palloc(nrels * sizeof(RelOptInfo *));
+	order = (RelOptInfo **) palloc(nrels * sizeof(RelOptInfo *));
+	placed = (bool *) palloc0(nrels * sizeof(bool));
+	connected = (bool *) palloc0(nrels * sizeof(bool));
+
+	i = 0;
+	foreach(lc, initial_rels)
+		rels[i++] = (RelOptInfo *) lfirst(lc);
+
+	for (n = 0; n < nrels; n++)
+	{
+		int			best = -1;
+
+		for (i = 0; i < nrels; i++)
+		{
+			if (placed[i])
+				continue;
+			if (best < 0 ||
+				(connected[i] && !connected[best]) ||
+				(connected[i] == connected[best] &&
+				 rels[i]->rows < rels[best]->rows))
+				best = i;
+		}
+
+		order[n] = rels[best];
+		placed[best] = true;
+
+		/* Remaining items linked to the new one are now connected */
+		for (i = 0; i < nrels; i++)
+		{
+			if (placed[i] || connected[i])
+				continue;
+			if (have_relevant_joinclause(root, rels[best], rels[i]) ||
+				have_join_order_restriction(root, rels[best], rels[i]))
+				connected[i] = true;
+		}
+	}
+
+	pfree(rels);
+	pfree(placed);
+	pfree(connected);
+
+	return order;
+}
+
+/*****************************************************************************
+ *			EAGER AGGREGATION
+ *****************************************************************************/
+
+/*
+ * make_eager_agg_rel
+ *	  Build a second join relation for the whole query, in which one base
+ *	  relation is partially aggregated before it is joined to the others.
+ *
+ * When every aggregate's arguments come from a single base rel R, and all
+ * joins are inner joins, we can group R's rows by the columns that are
+ * still needed above R (its join columns and any columns used outside the
+ * aggregates) and compute partial aggregates for each such group.  All the
+ * rows of a group join to the same rows of the other relations, so the
+ * join of the partially aggregated R replicates each partial state exactly
+ * as often as the plain join would have replicated each of the group's
+ * rows, and combining the states afterwards gives the correct result.
+ * grouping_planner() adds Finalize Aggregate paths atop the result, and
+ * cost comparison against the plain join decides which one is used.
+ *
+ * We rerun the join search with R replaced by a grouped copy of itself.
+ * The regular join relations for the same sets of relids already exist,
+ * so the search works with an empty join_rel_list and the caller's list
+ * is restored afterwards.  The partial Aggrefs are added to the targetlist
+ * of each join relation above R at the end, since build_joinrel_tlist()
+ * only knows how to propagate Vars.
+ *
+ * Returns NULL if the query is not suitable.
+ */
+static RelOptInfo *
+make_eager_agg_rel(PlannerInfo *root, List *joinlist)
+{
+	Query	   *parse = root->parse;
+	List	   *exprs;
+	List	   *aggs = NIL;
+	List	   *outside_vars = NIL;
+	Bitmapset  *outside_attrs = NULL;
+	Relids		aggrelids = NULL;
+	int			relid;
+	RelOptInfo *rel;
+	RelOptInfo *grouped_rel;
+	PathTarget *input_target;
+	PathTarget *agg_target;
+	PathTarget *key_target;
+	List	   *group_clauses = NIL;
+	List	   *group_exprs = NIL;
+	Index		sortgroupref = 0;
+	AggClauseCosts agg_costs;
+	double		numGroups;
+	Path	   *subpath;
+	List	   *save_join_rel_list;
+	struct HTAB *save_join_rel_hash;
+	List	   *eager_join_rels;
+	RelOptInfo *result;
+	int			agg_width;
+	ListCell   *lc;
+
+	/* Only plain aggregation over inner joins of base rels is supported */
+	if (!parse->hasAggs || parse->groupingSets ||
+		root->join_info_list != NIL || root->placeholder_list != NIL ||
+		root->hasLateralRTEs ||
+		bms_membership(root->all_baserels) != BMS_MULTIPLE)
+		return NULL;
+
+	/* We'll only ever use hashed partial aggregation */
+	if (!enable_hashagg)
+		return NULL;
+
+	/* The aggregates must all support partial aggregation */
+	MemSet(&agg_costs, 0, sizeof(AggClauseCosts));
+	get_agg_clause_costs(root, (Node *) root->processed_tlist,
+						 AGGSPLIT_SIMPLE, &agg_costs);
+	get_agg_clause_costs(root, parse->havingQual,
+						 AGGSPLIT_SIMPLE, &agg_costs);
+	if (agg_costs.hasNonPartial || agg_costs.hasNonSerial)
+		return NULL;
+
+	/*
+	 * Collect the aggregates, and the Vars that are used outside them, from
+	 * the targetlist and HAVING qual.
+	 */
+	exprs = pull_var_clause((Node *) root->processed_tlist,
+							PVC_INCLUDE_AGGREGATES |
+							PVC_RECURSE_WINDOWFUNCS |
+							PVC_INCLUDE_PLACEHOLDERS);
+	exprs = list_concat(exprs,
+						pull_var_clause(parse->havingQual,
+										PVC_INCLUDE_AGGREGATES |
+										PVC_INCLUDE_PLACEHOLDERS));
+	foreach(lc, exprs)
+	{
+		Node	   *expr = (Node *) lfirst(lc);
+
+		if (IsA(expr, Aggref))
+		{
+			aggrelids = bms_join(aggrelids, pull_varnos(expr));
+			aggs = list_append_unique(aggs, expr);
+		}
+		else if (IsA(expr, Var))
+			outside_vars = lappend(outside_vars, expr);
+		else
+			return NULL;
+	}
+
+	/* The aggregates must all draw their input from the same base rel */
+	if (!bms_get_singleton_member(aggrelids, &relid))
+		return NULL;
+	rel = find_base_rel(root, relid);
+	if (rel->reloptkind != RELOPT_BASEREL || IS_DUMMY_REL(rel) ||
+		rel->cheapest_total_path == NULL || rel->lateral_relids != NULL)
+		return NULL;
+
+	foreach(lc, outside_vars)
+	{
+		Var		   *var = (Var *) lfirst(lc);
+
+		if (var->varno == relid)
+			outside_attrs = bms_add_member(outside_attrs,
+										   var->varattno - rel->min_attr);
+	}
+
+	/*
+	 * Work out which of the rel's output columns are still needed above it,
+	 * other than as aggregate arguments; those are the grouping keys.  The
+	 * input target is the rel's own target with the keys marked; the output
+	 * target has the keys followed by the partial aggregates.
+	 *
+	 * We restrict the keys to plain columns of pass-by-value types other
+	 * than floats, for which the equality operator implies identical values.
+	 * Otherwise, expressions above the join might be able to tell apart
+	 * values that we had put into one group.
+	 */
+	input_target = create_empty_pathtarget();
+	key_target = create_empty_pathtarget();
+	foreach(lc, rel->reltarget->exprs)
+	{
+		Var		   *var = (Var *) lfirst(lc);
+		Relids		needed;
+		Index		ref = 0;
+
+		if (!IsA(var, Var))
+			return NULL;
+
+		needed = bms_copy(rel->attr_needed[var->varattno - rel->min_attr]);
+		needed = bms_del_member(needed, 0);
+		needed = bms_del_member(needed, relid);
+
+		if (!bms_is_empty(needed) ||
+			bms_is_member(var->varattno - rel->min_attr, outside_attrs))
+		{
+			SortGroupClause *sgc;
+			Oid			eqop;
+			bool		hashable;
+
+			if (var->varattno <= 0 || !get_typbyval(var->vartype) ||
+				var->vartype == FLOAT4OID || var->vartype == FLOAT8OID)
+				return NULL;
+
+			get_sort_group_operators(var->vartype,
+									 false, false, false,
+									 NULL, &eqop, NULL,
+									 &hashable);
+			if (!OidIsValid(eqop) || !hashable)
+				return NULL;
+
+			ref = ++sortgroupref;
+			sgc = makeNode(SortGroupClause);
+			sgc->tleSortGroupRef = ref;
+			sgc->eqop = eqop;
+			sgc->sortop = InvalidOid;
+			sgc->nulls_first = false;
+			sgc->hashable = true;
+			group_clauses = lappend(group_clauses, sgc);
+			group_exprs = lappend(group_exprs, var);
+			add_column_to_pathtarget(key_target, (Expr *) var, 0);
+		}
+		add_column_to_pathtarget(input_target, (Expr *) var, ref);
+	}
+
+	/* Grouping by nothing would leave us with a clauseless join */
+	if (group_clauses == NIL)
+		return NULL;
+
+	input_target->cost = rel->reltarget->cost;
+	input_target->width = rel->reltarget->width;
+	set_pathtarget_cost_width(root, key_target);
+
+	/* Mark the aggregates as partial, just as grouping_planner() will */
+	aggs = copyObject(aggs);
+	agg_target = copy_pathtarget(key_target);
+	foreach(lc, aggs)
+	{
+		Aggref	   *aggref = (Aggref *) lfirst(lc);
+
+		mark_partial_aggref(aggref, AGGSPLIT_INITIAL_SERIAL);
+		add_column_to_pathtarget(agg_target, (Expr *) aggref, 0);
+	}
+	set_pathtarget_cost_width(root, agg_target);
+	agg_width = agg_target->width - key_target->width;
+
+	MemSet(&agg_costs, 0, sizeof(AggClauseCosts));
+	get_agg_clause_costs(root, (Node *) aggs, AGGSPLIT_INITIAL_SERIAL,
+						 &agg_costs);
+
+	numGroups = estimate_num_groups(root, group_exprs, rel->rows, NULL);
+
+	/*
+	 * Build the grouped rel.  It is a copy of the original with a smaller
+	 * row count and target, whose only path is a partial HashAggregate atop
+	 * the original's cheapest path.  We don't try to combine this with
+	 * parallel query or partitionwise join.
+	 */
+	grouped_rel = makeNode(RelOptInfo);
+	memcpy(grouped_rel, rel, sizeof(RelOptInfo));
+	grouped_rel->rows = numGroups;
+	grouped_rel->reltarget = key_target;
+	grouped_rel->consider_parallel = false;
+	grouped_rel->pathlist = NIL;
+	grouped_rel->ppilist = NIL;
+	grouped_rel->partial_pathlist = NIL;
+	grouped_rel->cheapest_startup_path = NULL;
+	grouped_rel->cheapest_total_path = NULL;
+	grouped_rel->cheapest_unique_path = NULL;
+	grouped_rel->cheapest_parameterized_paths = NIL;
+	grouped_rel->consider_partitionwise_join = false;
+	grouped_rel->part_scheme = NULL;
+	grouped_rel->nparts = 0;
+	grouped_rel->part_rels = NULL;
+
+	subpath = (Path *) create_projection_path(root, grouped_rel,
+											  rel->cheapest_total_path,
+											  input_target);
+	if (estimate_hashagg_tablesize(subpath, &agg_costs,
+								   numGroups) >= work_mem * 1024L)
+		return NULL;
+	add_path(grouped_rel, (Path *)
+			 create_agg_path(root, grouped_rel, subpath, agg_target,
+							 AGG_HASHED, AGGSPLIT_INITIAL_SERIAL,
+							 group_clauses, NIL, &agg_costs, numGroups));
+	set_cheapest(grouped_rel);
+
+	/* Redo the join search with the grouped rel in place of the original */
+	Assert(root->join_rel_level == NULL);
+	save_join_rel_list = root->join_rel_list;
+	save_join_rel_hash = root->join_rel_hash;
+	root->join_rel_list = NIL;
+	root->join_rel_hash = NULL;
+	root->simple_rel_array[relid] = grouped_rel;
+
+	result = make_rel_from_joinlist(root, joinlist);
+
+	root->simple_rel_array[relid] = rel;
+	eager_join_rels = root->join_rel_list;
+	root->join_rel_list = save_join_rel_list;
+	root->join_rel_hash = save_join_rel_hash;
+
+	/* Make the join rels above the grouped rel emit the partial states */
+	foreach(lc, eager_join_rels)
+	{
+		RelOptInfo *joinrel = (RelOptInfo *) lfirst(lc);
+
+		if (!bms_is_member(relid, joinrel->relids))
+			continue;
+		joinrel->reltarget->exprs = list_concat(joinrel->reltarget->exprs,
+												list_copy(aggs));
+		joinrel->reltarget->width += agg_width;
+	}
+
+	Assert(bms_equal(result->relids, root->all_baserels));
+
+	return result;
+}
+
 /*****************************************************************************
  *			PUSHING QUALS DOWN INTO SUBQUERIES
  *****************************************************************************/
@@ -3667,7 +4153,6 @@ generate_partitionwise_join_paths(PlannerInfo *root, RelOptInfo *rel)
 {
 	List	   *live_children = NIL;
 	int			cnt_parts;
-	int			num_parts;
 	RelOptInfo **part_rels;
 
 	/* Handle only join relations here. */
@@ -3684,17 +4169,15 @@ generate_partitionwise_join_paths(PlannerInfo *root, RelOptInfo *rel)
 	/* Guard against stack overflow due to overly deep partition hierarchy. */
 	check_stack_depth();
 
-	num_parts = rel->nparts;
 	part_rels = rel->part_rels;
 
 	/* Collect non-dummy child-joins. */
-	for (cnt_parts = 0; cnt_parts < num_parts; cnt_parts++)
+	cnt_parts = -1;
+	while ((cnt_parts = bms_next_member(rel->live_parts, cnt_parts)) >= 0)
 	{
 		RelOptInfo *child_rel = part_rels[cnt_parts];
 
-		/* If it's been pruned entirely, it's certainly dummy. */
-		if (child_rel == NULL)
-			continue;
+		Assert(child_rel != NULL);
 
 		/* Add partitionwise join paths for partitioned child-joins. */
 		generate_partitionwise_join_paths(root, child_rel);
@@ -3860,6 +4343,10 @@ print_path(PlannerInfo *root, Path *path, int indent)
 			ptype = "Material";
 			subpath = ((MaterialPath *) path)->subpath;
 			break;
+		case T_MemoizePath:
+			ptype = "Memoize";
+			subpath = ((MemoizePath *) path)->subpath;
+			break;
 		case T_UniquePath:
 			ptype = "Unique";
 			subpath = ((UniquePath *) path)->subpath;
@@ -3884,6 +4371,10 @@ print_path(PlannerInfo *root, Path *path, int indent)
 			ptype = "Sort";
 			subpath = ((SortPath *) path)->subpath;
 			break;
+		case T_IncrementalSortPath:
+			ptype = "IncrementalSort";
+			subpath = ((SortPath *) path)->subpath;
+			break;
 		case T_GroupPath:
 			ptype = "Group";
 			subpath = ((GroupPath *) path)->subpath;
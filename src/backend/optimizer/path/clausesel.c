@@ -95,6 +95,16 @@ clauselist_selectivity(PlannerInfo *root,
 											 jointype, sjinfo, rel,
 											 &estimatedclauses);
 	}
+	else if (varRelid == 0 && list_length(clauses) > 1)
+	{
+		/*
+		 * Otherwise these may be join clauses; equijoins on several columns
+		 * of the same two relations can be estimated together using their
+		 * extended statistics.
+		 */
+		s1 *= statext_join_clauselist_selectivity(root, clauses, jointype,
+												  sjinfo, &estimatedclauses);
+	}
 
 	/*
 	 * Apply normal selectivity estimates for the remaining clauses, passing
@@ -1319,7 +1319,9 @@ restriction_is_constant_false(List *restrictlist,
  *
  * Partitionwise join is possible when a. Joining relations have same
  * partitioning scheme b. There exists an equi-join between the partition keys
- * of the two relations.
+ * of the two relations c. Their partition bounds are the same, or the join is
+ * an inner or semi join between range partitioned relations, in which case
+ * each pair of overlapping partitions is joined.
  *
  * Partitionwise join is planned as follows (details: optimizer/README.)
  *
@@ -1339,7 +1341,10 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 {
 	bool		rel1_is_simple = IS_SIMPLE_REL(rel1);
 	bool		rel2_is_simple = IS_SIMPLE_REL(rel2);
-	int			nparts;
+	PartitionScheme part_scheme = joinrel->part_scheme;
+	int		   *parts1 = NULL;
+	int		   *parts2 = NULL;
+	Bitmapset  *candidate_parts;
 	int			cnt_parts;
 
 	/* Guard against stack overflow due to overly deep partition hierarchy. */
@@ -1372,30 +1377,84 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 		   joinrel->part_scheme == rel2->part_scheme);
 
 	/*
-	 * Since we allow partitionwise join only when the partition bounds of the
-	 * joining relations exactly match, the partition bounds of the join
-	 * should match those of the joining relations.
+	 * If the partition bounds of the joining relations match, so do those of
+	 * the join, and the join's partitions correspond one-to-one with theirs.
+	 * Otherwise build_joinrel_partition_info() gave the join the
+	 * intersections of the joining relations' range partitions, and we need
+	 * to work out which pair of partitions makes up each of its partitions.
+	 * Intersecting is associative, so every pair of joining relations should
+	 * arrive at the same bounds; but in case some pair doesn't, just don't
+	 * consider partitionwise join for it.  The pair the joinrel was built
+	 * from always agrees, so the child joins still get paths.  Matching
+	 * overlapping partitions is only correct for inner and semi joins, so
+	 * also skip pairs joined some other way.
 	 */
-	Assert(partition_bounds_equal(joinrel->part_scheme->partnatts,
-								  joinrel->part_scheme->parttyplen,
-								  joinrel->part_scheme->parttypbyval,
-								  joinrel->boundinfo, rel1->boundinfo));
-	Assert(partition_bounds_equal(joinrel->part_scheme->partnatts,
-								  joinrel->part_scheme->parttyplen,
-								  joinrel->part_scheme->parttypbyval,
-								  joinrel->boundinfo, rel2->boundinfo));
+	if (rel1->nparts == rel2->nparts &&
+		partition_bounds_equal(part_scheme->partnatts,
+							   part_scheme->parttyplen,
+							   part_scheme->parttypbyval,
+							   rel1->boundinfo, rel2->boundinfo))
+	{
+		if (joinrel->nparts != rel1->nparts ||
+			!partition_bounds_equal(part_scheme->partnatts,
+									part_scheme->parttyplen,
+									part_scheme->parttypbyval,
+									joinrel->boundinfo, rel1->boundinfo))
+			return;
+	}
+	else
+	{
+		PartitionBoundInfo boundinfo;
+		int			nparts;
 
-	nparts = joinrel->nparts;
+		if (parent_sjinfo->jointype != JOIN_INNER &&
+			parent_sjinfo->jointype != JOIN_SEMI)
+			return;
+
+		boundinfo = partition_range_bounds_intersect(part_scheme->partnatts,
+													 part_scheme->partsupfunc,
+													 part_scheme->partcollation,
+													 rel1->boundinfo,
+													 rel2->boundinfo,
+													 &nparts, &parts1, &parts2);
+		if (boundinfo == NULL || nparts != joinrel->nparts ||
+			!partition_bounds_equal(part_scheme->partnatts,
+									part_scheme->parttyplen,
+									part_scheme->parttypbyval,
+									joinrel->boundinfo, boundinfo))
+			return;
+	}
+
+	/*
+	 * A segment of the join in which both inputs have been pruned away can't
+	 * produce any rows whatever the join type, so only segments where at
+	 * least one side survived partition pruning need to be considered.
+	 */
+	if (parts1 == NULL)
+		candidate_parts = bms_union(rel1->live_parts, rel2->live_parts);
+	else
+	{
+		candidate_parts = NULL;
+		for (cnt_parts = 0; cnt_parts < joinrel->nparts; cnt_parts++)
+		{
+			if (bms_is_member(parts1[cnt_parts], rel1->live_parts) ||
+				bms_is_member(parts2[cnt_parts], rel2->live_parts))
+				candidate_parts = bms_add_member(candidate_parts, cnt_parts);
+		}
+	}
 
 	/*
 	 * Create child-join relations for this partitioned join, if those don't
 	 * exist. Add paths to child-joins for a pair of child relations
 	 * corresponding to the given pair of parent relations.
 	 */
-	for (cnt_parts = 0; cnt_parts < nparts; cnt_parts++)
+	cnt_parts = -1;
+	while ((cnt_parts = bms_next_member(candidate_parts, cnt_parts)) >= 0)
 	{
-		RelOptInfo *child_rel1 = rel1->part_rels[cnt_parts];
-		RelOptInfo *child_rel2 = rel2->part_rels[cnt_parts];
+		int			part1 = parts1 ? parts1[cnt_parts] : cnt_parts;
+		int			part2 = parts2 ? parts2[cnt_parts] : cnt_parts;
+		RelOptInfo *child_rel1 = rel1->part_rels[part1];
+		RelOptInfo *child_rel2 = rel2->part_rels[part2];
 		bool		rel1_empty = (child_rel1 == NULL ||
 								  IS_DUMMY_REL(child_rel1));
 		bool		rel2_empty = (child_rel2 == NULL ||
@@ -1504,6 +1563,8 @@ try_partitionwise_join(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2,
 												 child_sjinfo,
 												 child_sjinfo->jointype);
 			joinrel->part_rels[cnt_parts] = child_joinrel;
+			joinrel->live_parts = bms_add_member(joinrel->live_parts,
+												 cnt_parts);
 		}
 
 		Assert(bms_equal(child_joinrel->relids, child_joinrelids));
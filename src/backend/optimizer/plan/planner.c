@@ -555,6 +555,8 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 			result->jitFlags |= PGJIT_EXPR;
 		if (jit_tuple_deforming)
 			result->jitFlags |= PGJIT_DEFORM;
+		if (jit_scans)
+			result->jitFlags |= PGJIT_SCAN;
 	}
 
 	if (glob->partition_directory != NULL)
@@ -4130,12 +4132,15 @@ create_ordinary_grouping_paths(PlannerInfo *root, RelOptInfo *input_rel,
 		return;
 	}
 
-	/* Gather any partially grouped partial paths. */
+	/*
+	 * Gather any partially grouped partial paths.  The rel might instead have
+	 * only non-partial paths from eager aggregation, so set its cheapest
+	 * paths in either case.
+	 */
 	if (partially_grouped_rel && partially_grouped_rel->partial_pathlist)
-	{
 		gather_grouping_paths(root, partially_grouped_rel);
+	if (partially_grouped_rel && partially_grouped_rel->pathlist)
 		set_cheapest(partially_grouped_rel);
-	}
 
 	/*
 	 * Estimate number of groups.
@@ -4962,13 +4967,19 @@ create_ordered_paths(PlannerInfo *root,
 
 	foreach(lc, input_rel->pathlist)
 	{
-		Path	   *path = (Path *) lfirst(lc);
+		Path	   *input_path = (Path *) lfirst(lc);
+		Path	   *path;
 		bool		is_sorted;
+		int			presorted_keys;
+
+		is_sorted = pathkeys_count_contained_in(root->sort_pathkeys,
+												input_path->pathkeys,
+												&presorted_keys);
 
-		is_sorted = pathkeys_contained_in(root->sort_pathkeys,
-										  path->pathkeys);
-		if (path == cheapest_input_path || is_sorted)
+		if (is_sorted || input_path == cheapest_input_path)
 		{
+			path = input_path;
+
 			if (!is_sorted)
 			{
 				/* An explicit sort here can take advantage of LIMIT */
@@ -4986,6 +4997,29 @@ create_ordered_paths(PlannerInfo *root,
 
 			add_path(ordered_rel, path);
 		}
+
+		/*
+		 * If the path is already sorted by a prefix of the required ordering,
+		 * an incremental sort can finish the job.  It's cheaper than a full
+		 * sort when the groups are small, and it can return the first rows
+		 * early, which matters a lot with a LIMIT.
+		 */
+		if (!is_sorted && presorted_keys > 0 && enable_incremental_sort)
+		{
+			path = (Path *) create_incremental_sort_path(root,
+														 ordered_rel,
+														 input_path,
+														 root->sort_pathkeys,
+														 presorted_keys,
+														 limit_tuples);
+
+			/* Add projection step if needed */
+			if (path->pathtarget != target)
+				path = apply_projection_to_path(root, ordered_rel,
+												path, target);
+
+			add_path(ordered_rel, path);
+		}
 	}
 
 	/*
@@ -6229,7 +6263,8 @@ plan_cluster_use_sort(Oid tableOid, Oid indexOid)
  *		CREATE INDEX should request for use
  *
  * tableOid is the table on which the index is to be built.  indexOid is the
- * OID of an index to be created or reindexed (which must be a btree index).
+ * OID of an index to be created or reindexed (whose access method must
+ * support parallel builds).
  *
  * Return value is the number of parallel worker processes to request.  It
  * may be unsafe to proceed if this is 0.  Note that this does not include the
@@ -6615,6 +6650,7 @@ create_partial_grouping_paths(PlannerInfo *root,
 	AggClauseCosts *agg_final_costs = &extra->agg_final_costs;
 	Path	   *cheapest_partial_path = NULL;
 	Path	   *cheapest_total_path = NULL;
+	RelOptInfo *eager_rel = NULL;
 	double		dNumPartialGroups = 0;
 	double		dNumPartialPartialGroups = 0;
 	ListCell   *lc;
@@ -6640,13 +6676,25 @@ create_partial_grouping_paths(PlannerInfo *root,
 	if (grouped_rel->consider_parallel && input_rel->partial_pathlist != NIL)
 		cheapest_partial_path = linitial(input_rel->partial_pathlist);
 
+	/*
+	 * If make_one_rel() managed to join the base rels with one of them
+	 * partially aggregated first, those join paths need only be projected to
+	 * become partially grouped paths.  That join is only ever made for the
+	 * query's whole scan/join relation, never for a child of it.
+	 */
+	if (root->eager_agg_rel != NULL && !IS_OTHER_REL(input_rel) &&
+		bms_equal(input_rel->relids, root->eager_agg_rel->relids))
+		eager_rel = root->eager_agg_rel;
+
 	/*
 	 * If we can't partially aggregate partial paths, and we can't partially
-	 * aggregate non-partial paths, then don't bother creating the new
-	 * RelOptInfo at all, unless the caller specified force_rel_creation.
+	 * aggregate non-partial paths, and there are no eagerly aggregated paths,
+	 * then don't bother creating the new RelOptInfo at all, unless the caller
+	 * specified force_rel_creation.
 	 */
 	if (cheapest_total_path == NULL &&
 		cheapest_partial_path == NULL &&
+		eager_rel == NULL &&
 		!force_rel_creation)
 		return NULL;
 
@@ -6873,6 +6921,20 @@ create_partial_grouping_paths(PlannerInfo *root,
 		}
 	}
 
+	if (eager_rel != NULL)
+	{
+		foreach(lc, eager_rel->pathlist)
+		{
+			Path	   *path = (Path *) lfirst(lc);
+
+			add_path(partially_grouped_rel, (Path *)
+					 create_projection_path(root,
+											partially_grouped_rel,
+											path,
+											partially_grouped_rel->reltarget));
+		}
+	}
+
 	/*
 	 * If there is an FDW that's responsible for all baserels of the query,
 	 * let it consider adding partially grouped ForeignPaths.
@@ -7138,7 +7200,9 @@ apply_scanjoin_target_to_paths(PlannerInfo *root,
 		int			partition_idx;
 
 		/* Adjust each partition. */
-		for (partition_idx = 0; partition_idx < rel->nparts; partition_idx++)
+		partition_idx = -1;
+		while ((partition_idx = bms_next_member(rel->live_parts,
+												partition_idx)) >= 0)
 		{
 			RelOptInfo *child_rel = rel->part_rels[partition_idx];
 			AppendRelInfo **appinfos;
@@ -7146,8 +7210,10 @@ apply_scanjoin_target_to_paths(PlannerInfo *root,
 			List	   *child_scanjoin_targets = NIL;
 			ListCell   *lc;
 
-			/* Pruned or dummy children can be ignored. */
-			if (child_rel == NULL || IS_DUMMY_REL(child_rel))
+			Assert(child_rel != NULL);
+
+			/* Dummy children can be ignored. */
+			if (IS_DUMMY_REL(child_rel))
 				continue;
 
 			/* Translate scan/join targets for this child. */
@@ -7228,7 +7294,6 @@ create_partitionwise_grouping_paths(PlannerInfo *root,
 									PartitionwiseAggregateType patype,
 									GroupPathExtraData *extra)
 {
-	int			nparts = input_rel->nparts;
 	int			cnt_parts;
 	List	   *grouped_live_children = NIL;
 	List	   *partially_grouped_live_children = NIL;
@@ -7240,20 +7305,25 @@ create_partitionwise_grouping_paths(PlannerInfo *root,
 		   partially_grouped_rel != NULL);
 
 	/* Add paths for partitionwise aggregation/grouping. */
-	for (cnt_parts = 0; cnt_parts < nparts; cnt_parts++)
+	cnt_parts = -1;
+	while ((cnt_parts = bms_next_member(input_rel->live_parts, cnt_parts)) >= 0)
 	{
 		RelOptInfo *child_input_rel = input_rel->part_rels[cnt_parts];
-		PathTarget *child_target = copy_pathtarget(target);
+		PathTarget *child_target;
 		AppendRelInfo **appinfos;
 		int			nappinfos;
 		GroupPathExtraData child_extra;
 		RelOptInfo *child_grouped_rel;
 		RelOptInfo *child_partially_grouped_rel;
 
-		/* Pruned or dummy children can be ignored. */
-		if (child_input_rel == NULL || IS_DUMMY_REL(child_input_rel))
+		Assert(child_input_rel != NULL);
+
+		/* Dummy children can be ignored. */
+		if (IS_DUMMY_REL(child_input_rel))
 			continue;
 
+		child_target = copy_pathtarget(target);
+
 		/*
 		 * Copy the given "extra" structure as is and then override the
 		 * members specific to this child.
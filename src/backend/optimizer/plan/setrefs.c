@@ -648,6 +648,7 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 		case T_Hash:
 		case T_Material:
 		case T_Sort:
+		case T_IncrementalSort:
 		case T_Unique:
 		case T_SetOp:
 
@@ -687,6 +688,20 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 				}
 			}
 			break;
+		case T_Memoize:
+			{
+				Memoize    *mplan = (Memoize *) plan;
+
+				/*
+				 * Memoize does not evaluate its targetlist.  It just uses the
+				 * same targetlist from its outer subnode.
+				 */
+				set_dummy_tlist_references(plan, rtoffset);
+
+				mplan->param_exprs = fix_scan_list(root, mplan->param_exprs,
+												   rtoffset);
+			}
+			break;
 		case T_Limit:
 			{
 				Limit	   *splan = (Limit *) plan;
@@ -1732,6 +1747,17 @@ set_join_references(PlannerInfo *root, Join *join, int rtoffset)
 				  nlp->paramval->varno == OUTER_VAR))
 				elog(ERROR, "NestLoopParam was not reduced to a simple Var");
 		}
+
+		nl->outerHashKeys = (List *) fix_upper_expr(root,
+													(Node *) nl->outerHashKeys,
+													outer_itlist,
+													OUTER_VAR,
+													rtoffset);
+		nl->innerHashKeys = (List *) fix_upper_expr(root,
+													(Node *) nl->innerHashKeys,
+													inner_itlist,
+													INNER_VAR,
+													rtoffset);
 	}
 	else if (IsA(join, MergeJoin))
 	{
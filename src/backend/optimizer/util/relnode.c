@@ -240,6 +240,7 @@ build_simple_rel(PlannerInfo *root, int relid, RelOptInfo *parent)
 	rel->boundinfo = NULL;
 	rel->partition_qual = NIL;
 	rel->part_rels = NULL;
+	rel->live_parts = NULL;
 	rel->partexprs = NULL;
 	rel->nullable_partexprs = NULL;
 	rel->partitioned_child_rels = NIL;
@@ -652,6 +653,7 @@ build_join_rel(PlannerInfo *root,
 	joinrel->boundinfo = NULL;
 	joinrel->partition_qual = NIL;
 	joinrel->part_rels = NULL;
+	joinrel->live_parts = NULL;
 	joinrel->partexprs = NULL;
 	joinrel->nullable_partexprs = NULL;
 	joinrel->partitioned_child_rels = NIL;
@@ -827,6 +829,7 @@ build_child_join_rel(PlannerInfo *root, RelOptInfo *outer_rel,
 	joinrel->boundinfo = NULL;
 	joinrel->partition_qual = NIL;
 	joinrel->part_rels = NULL;
+	joinrel->live_parts = NULL;
 	joinrel->partexprs = NULL;
 	joinrel->nullable_partexprs = NULL;
 	joinrel->partitioned_child_rels = NIL;
@@ -1604,6 +1607,8 @@ build_joinrel_partition_info(RelOptInfo *joinrel, RelOptInfo *outer_rel,
 	int			partnatts;
 	int			cnt;
 	PartitionScheme part_scheme;
+	PartitionBoundInfo boundinfo;
+	int			nparts;
 
 	/* Nothing to do if partitionwise join technique is disabled. */
 	if (!enable_partitionwise_join)
@@ -1640,18 +1645,43 @@ build_joinrel_partition_info(RelOptInfo *joinrel, RelOptInfo *outer_rel,
 		   REL_HAS_ALL_PART_PROPS(inner_rel));
 
 	/*
-	 * For now, our partition matching algorithm can match partitions only
-	 * when the partition bounds of the joining relations are exactly same.
-	 * So, bail out otherwise.
+	 * If the partition bounds of the joining relations are exactly the same,
+	 * the join has those bounds too and partitions are matched one-to-one.
+	 * Otherwise, for an inner or semi join between range partitioned
+	 * relations, we can still match each pair of overlapping partitions; the
+	 * join is then partitioned by the intersections of their ranges.  See
+	 * partition_range_bounds_intersect().  Bail out in other cases.
 	 */
-	if (outer_rel->nparts != inner_rel->nparts ||
-		!partition_bounds_equal(part_scheme->partnatts,
-								part_scheme->parttyplen,
-								part_scheme->parttypbyval,
-								outer_rel->boundinfo, inner_rel->boundinfo))
+	if (outer_rel->nparts == inner_rel->nparts &&
+		partition_bounds_equal(part_scheme->partnatts,
+							   part_scheme->parttyplen,
+							   part_scheme->parttypbyval,
+							   outer_rel->boundinfo, inner_rel->boundinfo))
 	{
-		Assert(!IS_PARTITIONED_REL(joinrel));
-		return;
+		boundinfo = outer_rel->boundinfo;
+		nparts = outer_rel->nparts;
+	}
+	else
+	{
+		int		   *outer_parts;
+		int		   *inner_parts;
+
+		boundinfo = NULL;
+		if (part_scheme->strategy == PARTITION_STRATEGY_RANGE &&
+			(jointype == JOIN_INNER || jointype == JOIN_SEMI))
+			boundinfo = partition_range_bounds_intersect(part_scheme->partnatts,
+														 part_scheme->partsupfunc,
+														 part_scheme->partcollation,
+														 outer_rel->boundinfo,
+														 inner_rel->boundinfo,
+														 &nparts,
+														 &outer_parts,
+														 &inner_parts);
+		if (boundinfo == NULL)
+		{
+			Assert(!IS_PARTITIONED_REL(joinrel));
+			return;
+		}
 	}
 
 	/*
@@ -1665,15 +1695,15 @@ build_joinrel_partition_info(RelOptInfo *joinrel, RelOptInfo *outer_rel,
 
 	/*
 	 * Join relation is partitioned using the same partitioning scheme as the
-	 * joining relations and has same bounds.
+	 * joining relations.
 	 */
 	joinrel->part_scheme = part_scheme;
-	joinrel->boundinfo = outer_rel->boundinfo;
+	joinrel->boundinfo = boundinfo;
 	partnatts = joinrel->part_scheme->partnatts;
 	joinrel->partexprs = (List **) palloc0(sizeof(List *) * partnatts);
 	joinrel->nullable_partexprs =
 		(List **) palloc0(sizeof(List *) * partnatts);
-	joinrel->nparts = outer_rel->nparts;
+	joinrel->nparts = nparts;
 	joinrel->part_rels =
 		(RelOptInfo **) palloc0(sizeof(RelOptInfo *) * joinrel->nparts);
 
@@ -93,6 +93,11 @@ static int	partition_range_bsearch(int partnatts, FmgrInfo *partsupfunc,
 									PartitionBoundInfo boundinfo,
 									PartitionRangeBound *probe, bool *is_equal);
 static int	get_partition_bound_num_indexes(PartitionBoundInfo b);
+static int32 partition_rbound_datums_cmp(int partnatts, FmgrInfo *partsupfunc,
+										 Oid *partcollation,
+										 Datum *datums1, PartitionRangeDatumKind *kind1,
+										 Datum *datums2, PartitionRangeDatumKind *kind2);
+static int	next_range_bound_partition(PartitionBoundInfo bi, int pos);
 static Expr *make_partition_op_expr(PartitionKey key, int keynum,
 									uint16 strategy, Expr *arg1, Expr *arg2);
 static Oid	get_partition_operator(PartitionKey key, int col,
@@ -925,6 +930,162 @@ partitions_are_ordered(PartitionBoundInfo boundinfo, int nparts)
 	return false;
 }
 
+/*
+ * partition_range_bounds_intersect
+ *		Compute the partition bounds of an inner join between two range
+ *		partitioned relations whose bounds differ.
+ *
+ * Each partition of the result is the non-empty intersection of one
+ * partition from each side, so a join row whose key falls in it can only
+ * come from joining that pair of partitions.  For inner and semi joins on
+ * the partition key, the union of the pairwise joins is therefore exactly
+ * the whole join, even when one partition of a side overlaps several on the
+ * other, as with monthly partitions joined to daily ones.
+ *
+ * On success, returns the bounds of the result and sets *nparts to its
+ * number of partitions; (*outer_parts)[k] and (*inner_parts)[k] are the
+ * indexes of the two input partitions making up result partition k.
+ * Returns NULL if either side has a default partition, whose contents
+ * aren't described by its bound, or if no partitions overlap.
+ *
+ * The result's datums point into the inputs' bounds rather than being
+ * copied, so it must not outlive them.
+ */
+PartitionBoundInfo
+partition_range_bounds_intersect(int partnatts, FmgrInfo *partsupfunc,
+								 Oid *partcollation,
+								 PartitionBoundInfo outer_bi,
+								 PartitionBoundInfo inner_bi,
+								 int *nparts, int **outer_parts,
+								 int **inner_parts)
+{
+	PartitionBoundInfo merged;
+	int			max_parts;
+	int			ndatums = 0;
+	int			nmerged = 0;
+	int			o;
+	int			i;
+
+	Assert(outer_bi->strategy == PARTITION_STRATEGY_RANGE &&
+		   inner_bi->strategy == PARTITION_STRATEGY_RANGE);
+
+	if (partition_bound_has_default(outer_bi) ||
+		partition_bound_has_default(inner_bi))
+		return NULL;
+
+	/* Every result partition ends at a distinct upper bound of an input */
+	max_parts = outer_bi->ndatums + inner_bi->ndatums;
+
+	merged = (PartitionBoundInfo) palloc0(sizeof(PartitionBoundInfoData));
+	merged->strategy = PARTITION_STRATEGY_RANGE;
+	merged->datums = (Datum **) palloc(2 * max_parts * sizeof(Datum *));
+	merged->kind = (PartitionRangeDatumKind **)
+		palloc(2 * max_parts * sizeof(PartitionRangeDatumKind *));
+	merged->indexes = (int *) palloc((2 * max_parts + 1) * sizeof(int));
+	merged->null_index = -1;
+	merged->default_index = -1;
+	*outer_parts = (int *) palloc(max_parts * sizeof(int));
+	*inner_parts = (int *) palloc(max_parts * sizeof(int));
+
+	/*
+	 * Walk both sides' partitions in bound order.  A range partition's upper
+	 * bound is the datum at which its index is stored, and its lower bound is
+	 * the preceding datum.
+	 */
+	o = next_range_bound_partition(outer_bi, 0);
+	i = next_range_bound_partition(inner_bi, 0);
+	while (o < outer_bi->ndatums && i < inner_bi->ndatums)
+	{
+		Datum	   *lo_datums;
+		PartitionRangeDatumKind *lo_kind;
+		Datum	   *hi_datums;
+		PartitionRangeDatumKind *hi_kind;
+		int32		cmp_upper;
+
+		Assert(o > 0 && i > 0);
+
+		/* The intersection starts at the larger lower bound ... */
+		if (partition_rbound_datums_cmp(partnatts, partsupfunc, partcollation,
+										outer_bi->datums[o - 1],
+										outer_bi->kind[o - 1],
+										inner_bi->datums[i - 1],
+										inner_bi->kind[i - 1]) >= 0)
+		{
+			lo_datums = outer_bi->datums[o - 1];
+			lo_kind = outer_bi->kind[o - 1];
+		}
+		else
+		{
+			lo_datums = inner_bi->datums[i - 1];
+			lo_kind = inner_bi->kind[i - 1];
+		}
+
+		/* ... and ends at the smaller upper bound */
+		cmp_upper = partition_rbound_datums_cmp(partnatts, partsupfunc,
+												partcollation,
+												outer_bi->datums[o],
+												outer_bi->kind[o],
+												inner_bi->datums[i],
+												inner_bi->kind[i]);
+		if (cmp_upper <= 0)
+		{
+			hi_datums = outer_bi->datums[o];
+			hi_kind = outer_bi->kind[o];
+		}
+		else
+		{
+			hi_datums = inner_bi->datums[i];
+			hi_kind = inner_bi->kind[i];
+		}
+
+		if (partition_rbound_datums_cmp(partnatts, partsupfunc, partcollation,
+										lo_datums, lo_kind,
+										hi_datums, hi_kind) < 0)
+		{
+			/*
+			 * Store the lower bound unless it's the upper bound of the
+			 * previous result partition, as create_range_bounds() does.
+			 */
+			if (ndatums == 0 ||
+				partition_rbound_datums_cmp(partnatts, partsupfunc,
+											partcollation,
+											merged->datums[ndatums - 1],
+											merged->kind[ndatums - 1],
+											lo_datums, lo_kind) != 0)
+			{
+				merged->datums[ndatums] = lo_datums;
+				merged->kind[ndatums] = lo_kind;
+				merged->indexes[ndatums] = -1;
+				ndatums++;
+			}
+			merged->datums[ndatums] = hi_datums;
+			merged->kind[ndatums] = hi_kind;
+			merged->indexes[ndatums] = nmerged;
+			ndatums++;
+
+			(*outer_parts)[nmerged] = outer_bi->indexes[o];
+			(*inner_parts)[nmerged] = inner_bi->indexes[i];
+			nmerged++;
+		}
+
+		/* Move past whichever partition ends first, or both */
+		if (cmp_upper <= 0)
+			o = next_range_bound_partition(outer_bi, o + 1);
+		if (cmp_upper >= 0)
+			i = next_range_bound_partition(inner_bi, i + 1);
+	}
+
+	if (nmerged == 0)
+		return NULL;
+
+	/* The extra -1 element. */
+	merged->indexes[ndatums] = -1;
+	merged->ndatums = ndatums;
+	*nparts = nmerged;
+
+	return merged;
+}
+
 /*
  * check_new_partition_bound
  *
@@ -1511,6 +1672,43 @@ partition_rbound_cmp(int partnatts, FmgrInfo *partsupfunc,
 	return cmpval;
 }
 
+/*
+ * partition_rbound_datums_cmp
+ *
+ * Return for two range bound datum-tuples stored in a PartitionBoundInfo
+ * whether the first is <, =, or > the second.
+ */
+static int32
+partition_rbound_datums_cmp(int partnatts, FmgrInfo *partsupfunc,
+							Oid *partcollation,
+							Datum *datums1, PartitionRangeDatumKind *kind1,
+							Datum *datums2, PartitionRangeDatumKind *kind2)
+{
+	PartitionRangeBound b2;
+
+	b2.index = -1;
+	b2.datums = datums2;
+	b2.kind = kind2;
+	b2.lower = false;
+
+	return partition_rbound_cmp(partnatts, partsupfunc, partcollation,
+								datums1, kind1, false, &b2);
+}
+
+/*
+ * next_range_bound_partition
+ *
+ * Return the position of the first datum at or after 'pos' that is the upper
+ * bound of a partition in range bounds 'bi', or bi->ndatums if none is.
+ */
+static int
+next_range_bound_partition(PartitionBoundInfo bi, int pos)
+{
+	while (pos < bi->ndatums && bi->indexes[pos] < 0)
+		pos++;
+	return pos;
+}
+
 /*
  * partition_rbound_datum_cmp
  *
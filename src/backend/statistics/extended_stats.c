@@ -22,12 +22,14 @@
 #include "access/tuptoaster.h"
 #include "catalog/indexing.h"
 #include "catalog/pg_collation.h"
+#include "catalog/pg_statistic.h"
 #include "catalog/pg_statistic_ext.h"
 #include "catalog/pg_statistic_ext_data.h"
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/clauses.h"
 #include "optimizer/optimizer.h"
+#include "optimizer/pathnode.h"
 #include "postmaster/autovacuum.h"
 #include "statistics/extended_stats_internal.h"
 #include "statistics/statistics.h"
@@ -63,6 +65,19 @@ typedef struct StatExtEntry
 	List	   *types;			/* 'char' list of enabled statistic kinds */
 } StatExtEntry;
 
+/*
+ * An equijoin clause between columns of two base relations, as found by
+ * statext_is_join_clause().  relid1 is always the lower-numbered relation.
+ */
+typedef struct StatExtJoinClause
+{
+	int			clauseidx;		/* position in the clause list */
+	Var		   *var1;			/* column of relid1 */
+	Var		   *var2;			/* column of relid2 */
+	Oid			eqfunc;			/* equality function, var1 value first */
+	Oid			collid;			/* collation to compare with */
+} StatExtJoinClause;
+
 
 static List *fetch_statentries_for_relation(Relation pg_statext, Oid relid);
 static VacAttrStats **lookup_var_attr_stats(Relation rel, Bitmapset *attrs,
@@ -1196,3 +1211,308 @@ statext_clauselist_selectivity(PlannerInfo *root, List *clauses, int varRelid,
 
 	return sel;
 }
+
+/*
+ * statext_join_column_is_usable
+ *		Determines if a join column's relation has extended statistics and
+ *		the user may see their values when compared using function 'eqfunc'.
+ */
+static bool
+statext_join_column_is_usable(PlannerInfo *root, Var *var, Oid eqfunc)
+{
+	RelOptInfo *rel;
+	RangeTblEntry *rte;
+	Oid			userid;
+
+	if (var->varno >= root->simple_rel_array_size)
+		return false;
+	rel = root->simple_rel_array[var->varno];
+	rte = root->simple_rte_array[var->varno];
+	if (rel == NULL || rel->rtekind != RTE_RELATION || rel->statlist == NIL)
+		return false;
+
+	/* Leaky operators could expose rows hidden by security barriers */
+	if (rte->securityQuals != NIL && !get_func_leakproof(eqfunc))
+		return false;
+
+	/* Use checkAsUser if it's set, in case we're accessing via a view */
+	userid = rte->checkAsUser ? rte->checkAsUser : GetUserId();
+
+	return pg_class_aclcheck(rte->relid, userid, ACL_SELECT) == ACLCHECK_OK ||
+		pg_attribute_aclcheck(rte->relid, var->varattno, userid,
+							  ACL_SELECT) == ACLCHECK_OK;
+}
+
+/*
+ * statext_is_join_clause
+ *		Determines if the clause is an equijoin between plain columns of two
+ *		base relations that MCV lists could estimate, and fills *jc if so.
+ */
+static bool
+statext_is_join_clause(PlannerInfo *root, Node *clause, StatExtJoinClause *jc)
+{
+	RestrictInfo *rinfo;
+	OpExpr	   *expr;
+	Node	   *left;
+	Node	   *right;
+	Var		   *var1;
+	Var		   *var2;
+	Oid			opno;
+
+	if (!IsA(clause, RestrictInfo))
+		return false;
+	rinfo = (RestrictInfo *) clause;
+	if (rinfo->pseudoconstant || !is_opclause(rinfo->clause))
+		return false;
+
+	expr = (OpExpr *) rinfo->clause;
+	if (list_length(expr->args) != 2)
+		return false;
+
+	/* Only operators estimated like equality are of interest */
+	if (get_oprjoin(expr->opno) != F_EQJOINSEL)
+		return false;
+
+	left = linitial(expr->args);
+	right = lsecond(expr->args);
+	if (IsA(left, RelabelType))
+		left = (Node *) ((RelabelType *) left)->arg;
+	if (IsA(right, RelabelType))
+		right = (Node *) ((RelabelType *) right)->arg;
+	if (!IsA(left, Var) || !IsA(right, Var))
+		return false;
+
+	var1 = (Var *) left;
+	var2 = (Var *) right;
+	if (var1->varlevelsup != 0 || var2->varlevelsup != 0 ||
+		!AttrNumberIsForUserDefinedAttr(var1->varattno) ||
+		!AttrNumberIsForUserDefinedAttr(var2->varattno) ||
+		var1->varno == var2->varno)
+		return false;
+
+	/* Put the lower-numbered relation first, commuting the operator */
+	opno = expr->opno;
+	if (var1->varno > var2->varno)
+	{
+		Var		   *tmp = var1;
+
+		var1 = var2;
+		var2 = tmp;
+		opno = get_commutator(opno);
+		if (!OidIsValid(opno))
+			return false;
+	}
+
+	/*
+	 * Check there are statistics to use, and as in
+	 * statext_is_compatible_clause, that the operator can't reveal MCV values
+	 * the user isn't allowed to see.
+	 */
+	jc->eqfunc = get_opcode(opno);
+	if (!statext_join_column_is_usable(root, var1, jc->eqfunc) ||
+		!statext_join_column_is_usable(root, var2, jc->eqfunc))
+		return false;
+
+	jc->var1 = var1;
+	jc->var2 = var2;
+	jc->collid = expr->inputcollid;
+
+	return true;
+}
+
+/*
+ * statext_join_nullfrac
+ *		Estimate the fraction of rows with a NULL in any of the given join
+ *		columns of one relation, from their per-column statistics.
+ *
+ * The MCV list only tells us about NULLs among its own items, so on its own
+ * it underestimates the null fraction when NULLs are spread over many
+ * combinations.  Lacking anything better, assume the columns' NULLs are
+ * independent.
+ */
+static double
+statext_join_nullfrac(PlannerInfo *root, List *vars)
+{
+	double		notnullfrac = 1.0;
+	ListCell   *lc;
+
+	foreach(lc, vars)
+	{
+		VariableStatData vardata;
+
+		examine_variable(root, (Node *) lfirst(lc), 0, &vardata);
+		if (HeapTupleIsValid(vardata.statsTuple))
+		{
+			Form_pg_statistic stats;
+
+			stats = (Form_pg_statistic) GETSTRUCT(vardata.statsTuple);
+			notnullfrac *= 1.0 - stats->stanullfrac;
+		}
+		ReleaseVariableStats(vardata);
+	}
+
+	return 1.0 - notnullfrac;
+}
+
+/*
+ * statext_mcv_join_selectivity
+ *		Estimate a group of equijoin clauses between the same two relations
+ *		using MCV lists covering the join columns on both sides.
+ *
+ * Returns 1.0 without marking any clause as estimated if either relation
+ * lacks a suitable MCV list.
+ */
+static Selectivity
+statext_mcv_join_selectivity(PlannerInfo *root, StatExtJoinClause *group,
+							 int ngroup, Bitmapset **estimatedclauses)
+{
+	RelOptInfo *rel1 = find_base_rel(root, group[0].var1->varno);
+	RelOptInfo *rel2 = find_base_rel(root, group[0].var2->varno);
+	Bitmapset  *attnums1 = NULL;
+	Bitmapset  *attnums2 = NULL;
+	StatisticExtInfo *stat1;
+	StatisticExtInfo *stat2;
+	MCVList    *mcv1;
+	MCVList    *mcv2;
+	int			dims1[STATS_MAX_DIMENSIONS];
+	int			dims2[STATS_MAX_DIMENSIONS];
+	FmgrInfo	eqprocs[STATS_MAX_DIMENSIONS];
+	Oid			collations[STATS_MAX_DIMENSIONS];
+	List	   *vars1 = NIL;
+	List	   *vars2 = NIL;
+	double		nd1;
+	double		nd2;
+	Selectivity sel;
+	int			k;
+
+	for (k = 0; k < ngroup; k++)
+	{
+		attnums1 = bms_add_member(attnums1, group[k].var1->varattno);
+		attnums2 = bms_add_member(attnums2, group[k].var2->varattno);
+	}
+
+	stat1 = choose_best_statistics(rel1->statlist, attnums1, STATS_EXT_MCV);
+	stat2 = choose_best_statistics(rel2->statlist, attnums2, STATS_EXT_MCV);
+	if (stat1 == NULL || !bms_is_subset(attnums1, stat1->keys) ||
+		stat2 == NULL || !bms_is_subset(attnums2, stat2->keys))
+		return 1.0;
+
+	mcv1 = statext_mcv_load(stat1->statOid);
+	mcv2 = statext_mcv_load(stat2->statOid);
+
+	for (k = 0; k < ngroup; k++)
+	{
+		dims1[k] = bms_member_index(stat1->keys, group[k].var1->varattno);
+		dims2[k] = bms_member_index(stat2->keys, group[k].var2->varattno);
+		fmgr_info(group[k].eqfunc, &eqprocs[k]);
+		collations[k] = group[k].collid;
+		vars1 = lappend(vars1, group[k].var1);
+		vars2 = lappend(vars2, group[k].var2);
+	}
+
+	/* This picks up multivariate ndistinct statistics, if any */
+	nd1 = estimate_num_groups(root, vars1, Max(rel1->tuples, 1.0), NULL);
+	nd2 = estimate_num_groups(root, vars2, Max(rel2->tuples, 1.0), NULL);
+
+	sel = mcv_join_selectivity(mcv1, mcv2, ngroup, dims1, dims2, eqprocs,
+							   collations, nd1, nd2,
+							   statext_join_nullfrac(root, vars1),
+							   statext_join_nullfrac(root, vars2));
+
+	for (k = 0; k < ngroup; k++)
+		*estimatedclauses = bms_add_member(*estimatedclauses,
+										   group[k].clauseidx);
+
+	return sel;
+}
+
+/*
+ * statext_join_clauselist_selectivity
+ *		Estimate equijoin clauses using multi-column statistics.
+ *
+ * Per-column estimates of a join on several columns assume the columns are
+ * independent, which for correlated columns can underestimate the join size
+ * by orders of magnitude.  When two relations are joined on two or more
+ * column pairs and each has an MCV list covering its side's columns, we
+ * estimate those clauses together by matching the two MCV lists.
+ */
+Selectivity
+statext_join_clauselist_selectivity(PlannerInfo *root, List *clauses,
+									JoinType jointype, SpecialJoinInfo *sjinfo,
+									Bitmapset **estimatedclauses)
+{
+	StatExtJoinClause *jcs;
+	int			njcs = 0;
+	bool	   *done;
+	Selectivity sel = 1.0;
+	ListCell   *l;
+	int			listidx;
+	int			i;
+
+	/* We estimate the way eqjoinsel_inner() does, so only where it applies */
+	if (jointype != JOIN_INNER && jointype != JOIN_LEFT &&
+		jointype != JOIN_FULL)
+		return 1.0;
+
+	if (list_length(clauses) < 2)
+		return 1.0;
+
+	jcs = (StatExtJoinClause *)
+		palloc(list_length(clauses) * sizeof(StatExtJoinClause));
+	listidx = 0;
+	foreach(l, clauses)
+	{
+		if (!bms_is_member(listidx, *estimatedclauses) &&
+			statext_is_join_clause(root, (Node *) lfirst(l), &jcs[njcs]))
+		{
+			jcs[njcs].clauseidx = listidx;
+			njcs++;
+		}
+		listidx++;
+	}
+
+	/* Estimate the clauses between each pair of relations separately */
+	done = (bool *) palloc0(njcs * sizeof(bool));
+	for (i = 0; i < njcs; i++)
+	{
+		StatExtJoinClause group[STATS_MAX_DIMENSIONS];
+		Bitmapset  *attnums1 = NULL;
+		Bitmapset  *attnums2 = NULL;
+		int			ngroup = 0;
+		int			j;
+
+		if (done[i])
+			continue;
+
+		for (j = i; j < njcs; j++)
+		{
+			if (done[j] ||
+				jcs[j].var1->varno != jcs[i].var1->varno ||
+				jcs[j].var2->varno != jcs[i].var2->varno)
+				continue;
+			done[j] = true;
+
+			/*
+			 * Use each column only once per side; a second clause on the same
+			 * column is left for the per-column estimates.
+			 */
+			if (ngroup == STATS_MAX_DIMENSIONS ||
+				bms_is_member(jcs[j].var1->varattno, attnums1) ||
+				bms_is_member(jcs[j].var2->varattno, attnums2))
+				continue;
+
+			attnums1 = bms_add_member(attnums1, jcs[j].var1->varattno);
+			attnums2 = bms_add_member(attnums2, jcs[j].var2->varattno);
+			group[ngroup++] = jcs[j];
+		}
+
+		if (ngroup >= 2)
+			sel *= statext_mcv_join_selectivity(root, group, ngroup,
+												estimatedclauses);
+	}
+
+	pfree(done);
+	pfree(jcs);
+
+	return sel;
+}
@@ -31,6 +31,7 @@
 #include "utils/fmgroids.h"
 #include "utils/fmgrprotos.h"
 #include "utils/lsyscache.h"
+#include "utils/selfuncs.h"
 #include "utils/syscache.h"
 #include "utils/typcache.h"
 
@@ -1893,3 +1894,158 @@ mcv_clauselist_selectivity(PlannerInfo *root, StatisticExtInfo *stat,
 
 	return s;
 }
+
+/*
+ * mcv_join_selectivity
+ *		Estimate the selectivity of equijoin clauses on several columns by
+ *		matching the MCV lists built on the two sides of the join.
+ *
+ * The k'th of the 'nkeys' clauses compares dimension dims1[k] of mcv1 with
+ * dimension dims2[k] of mcv2 using eqprocs[k], which takes the mcv1 value
+ * first.  nd1 and nd2 are the estimated numbers of distinct combinations of
+ * the join columns on each side, and nullfrac1 and nullfrac2 the estimated
+ * fractions of rows with a NULL in any of them.
+ *
+ * This follows eqjoinsel_inner(): pairs of matching MCV items contribute the
+ * product of their frequencies, and the rest of each side is assumed to be
+ * spread evenly over the combinations not covered by its MCV list.  Items
+ * with a NULL in any join column can't match anything.
+ */
+Selectivity
+mcv_join_selectivity(MCVList *mcv1, MCVList *mcv2, int nkeys,
+					 int *dims1, int *dims2, FmgrInfo *eqprocs,
+					 Oid *collations, double nd1, double nd2,
+					 double nullfrac1, double nullfrac2)
+{
+	bool	   *hasmatch1;
+	bool	   *hasmatch2;
+	bool	   *hasnull2;
+	double		matchprodfreq = 0.0;
+	double		matchfreq1 = 0.0;
+	double		matchfreq2 = 0.0;
+	double		sumfreq1 = 0.0;
+	double		sumfreq2 = 0.0;
+	double		nullfreq1 = 0.0;
+	double		nullfreq2 = 0.0;
+	double		unmatchfreq1;
+	double		unmatchfreq2;
+	double		otherfreq1;
+	double		otherfreq2;
+	double		totalsel1;
+	double		totalsel2;
+	int			nmatches1 = 0;
+	int			nmatches2 = 0;
+	int			i;
+	int			j;
+	int			k;
+
+	hasmatch1 = (bool *) palloc0(mcv1->nitems * sizeof(bool));
+	hasmatch2 = (bool *) palloc0(mcv2->nitems * sizeof(bool));
+	hasnull2 = (bool *) palloc0(mcv2->nitems * sizeof(bool));
+
+	for (j = 0; j < mcv2->nitems; j++)
+	{
+		MCVItem    *item2 = &mcv2->items[j];
+
+		for (k = 0; k < nkeys; k++)
+			if (item2->isnull[dims2[k]])
+				hasnull2[j] = true;
+
+		if (hasnull2[j])
+			nullfreq2 += item2->frequency;
+		else
+			sumfreq2 += item2->frequency;
+	}
+
+	for (i = 0; i < mcv1->nitems; i++)
+	{
+		MCVItem    *item1 = &mcv1->items[i];
+
+		for (k = 0; k < nkeys; k++)
+			if (item1->isnull[dims1[k]])
+				break;
+		if (k < nkeys)
+		{
+			nullfreq1 += item1->frequency;
+			continue;
+		}
+		sumfreq1 += item1->frequency;
+
+		for (j = 0; j < mcv2->nitems; j++)
+		{
+			MCVItem    *item2 = &mcv2->items[j];
+
+			if (hasnull2[j])
+				continue;
+
+			for (k = 0; k < nkeys; k++)
+			{
+				if (!DatumGetBool(FunctionCall2Coll(&eqprocs[k],
+													collations[k],
+													item1->values[dims1[k]],
+													item2->values[dims2[k]])))
+					break;
+			}
+			if (k < nkeys)
+				continue;
+
+			matchprodfreq += item1->frequency * item2->frequency;
+			if (!hasmatch1[i])
+			{
+				hasmatch1[i] = true;
+				matchfreq1 += item1->frequency;
+				nmatches1++;
+			}
+			if (!hasmatch2[j])
+			{
+				hasmatch2[j] = true;
+				matchfreq2 += item2->frequency;
+				nmatches2++;
+			}
+		}
+	}
+
+	pfree(hasmatch1);
+	pfree(hasmatch2);
+	pfree(hasnull2);
+
+	/*
+	 * The MCV items with NULLs only account for some of the rows with NULLs;
+	 * prefer the estimate from the per-column statistics if it's larger.
+	 */
+	nullfreq1 = Max(nullfreq1, nullfrac1);
+	nullfreq2 = Max(nullfreq2, nullfrac2);
+
+	CLAMP_PROBABILITY(matchprodfreq);
+	unmatchfreq1 = sumfreq1 - matchfreq1;
+	CLAMP_PROBABILITY(unmatchfreq1);
+	unmatchfreq2 = sumfreq2 - matchfreq2;
+	CLAMP_PROBABILITY(unmatchfreq2);
+	otherfreq1 = 1.0 - nullfreq1 - sumfreq1;
+	CLAMP_PROBABILITY(otherfreq1);
+	otherfreq2 = 1.0 - nullfreq2 - sumfreq2;
+	CLAMP_PROBABILITY(otherfreq2);
+
+	/*
+	 * Estimate the selectivity from each side's point of view, as in
+	 * eqjoinsel_inner(), and believe the smaller one.
+	 */
+	totalsel1 = matchprodfreq;
+	if (nd2 > mcv2->nitems)
+		totalsel1 += unmatchfreq1 * otherfreq2 / (nd2 - mcv2->nitems);
+	if (nd2 > nmatches2)
+		totalsel1 += otherfreq1 * (otherfreq2 + unmatchfreq2) /
+			(nd2 - nmatches2);
+
+	totalsel2 = matchprodfreq;
+	if (nd1 > mcv1->nitems)
+		totalsel2 += unmatchfreq2 * otherfreq1 / (nd1 - mcv1->nitems);
+	if (nd1 > nmatches1)
+		totalsel2 += otherfreq2 * (otherfreq1 + unmatchfreq1) /
+			(nd1 - nmatches1);
+
+	totalsel1 = Min(totalsel1, totalsel2);
+	CLAMP_PROBABILITY(totalsel1);
+
+	return totalsel1;
+}
@@ -23,6 +23,7 @@ char	   *BufferBlocks;
 LWLockMinimallyPadded *BufferIOLWLockArray = NULL;
 WritebackContext BackendWritebackContext;
 CkptSortItem *CkptBufferIds;
+pg_atomic_uint32 *BufferDirtyMap;
 
 
 /*
@@ -70,7 +71,8 @@ InitBufferPool(void)
 	bool		foundBufs,
 				foundDescs,
 				foundIOLocks,
-				foundBufCkpt;
+				foundBufCkpt,
+				foundDirtyMap;
 
 	/* Align descriptors to a cacheline boundary. */
 	BufferDescriptors = (BufferDescPadded *)
@@ -102,10 +104,18 @@ InitBufferPool(void)
 		ShmemInitStruct("Checkpoint BufferIds",
 						NBuffers * sizeof(CkptSortItem), &foundBufCkpt);
 
-	if (foundDescs || foundBufs || foundIOLocks || foundBufCkpt)
+	/* Bitmap of possibly-dirty buffers, see buf_internals.h */
+	BufferDirtyMap = (pg_atomic_uint32 *)
+		ShmemInitStruct("Buffer Dirty Map",
+						BufferDirtyMapWords() * sizeof(pg_atomic_uint32),
+						&foundDirtyMap);
+
+	if (foundDescs || foundBufs || foundIOLocks || foundBufCkpt ||
+		foundDirtyMap)
 	{
 		/* should find all of these, or none of them */
-		Assert(foundDescs && foundBufs && foundIOLocks && foundBufCkpt);
+		Assert(foundDescs && foundBufs && foundIOLocks && foundBufCkpt &&
+			   foundDirtyMap);
 		/* note: this path is only taken in EXEC_BACKEND case */
 	}
 	else
@@ -141,6 +151,9 @@ InitBufferPool(void)
 
 		/* Correct last entry of linked list */
 		GetBufferDescriptor(NBuffers - 1)->freeNext = FREENEXT_END_OF_LIST;
+
+		for (i = 0; i < BufferDirtyMapWords(); i++)
+			pg_atomic_init_u32(&BufferDirtyMap[i], 0);
 	}
 
 	/* Init other shared buffer-management stuff */
@@ -189,5 +202,9 @@ BufferShmemSize(void)
 	/* size of checkpoint sort array in bufmgr.c */
 	size = add_size(size, mul_size(NBuffers, sizeof(CkptSortItem)));
 
+	/* size of dirty buffer bitmap */
+	size = add_size(size, mul_size(BufferDirtyMapWords(),
+								   sizeof(pg_atomic_uint32)));
+
 	return size;
 }
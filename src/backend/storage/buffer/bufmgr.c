@@ -42,6 +42,7 @@
 #include "miscadmin.h"
 #include "pg_trace.h"
 #include "pgstat.h"
+#include "port/pg_bitutils.h"
 #include "postmaster/bgwriter.h"
 #include "storage/buf_internals.h"
 #include "storage/bufmgr.h"
@@ -1492,10 +1493,13 @@ MarkBufferDirty(Buffer buffer)
 	}
 
 	/*
-	 * If the buffer was not dirty already, do vacuum accounting.
+	 * If the buffer was not dirty already, let the next checkpoint know
+	 * about it, and do vacuum accounting.
 	 */
 	if (!(old_buf_state & BM_DIRTY))
 	{
+		BufferDirtyMapSet(bufHdr->buf_id);
+
 		VacuumPageDirty++;
 		pgBufferUsage.shared_blks_dirtied++;
 		if (VacuumCostActive)
@@ -1786,6 +1790,7 @@ BufferSync(int flags)
 {
 	uint32		buf_state;
 	int			buf_id;
+	int			word;
 	int			num_to_scan;
 	int			num_spaces;
 	int			num_processed;
@@ -1810,9 +1815,10 @@ BufferSync(int flags)
 		mask |= BM_PERMANENT;
 
 	/*
-	 * Loop over all buffers, and mark the ones that need to be written with
-	 * BM_CHECKPOINT_NEEDED.  Count them as we go (num_to_scan), so that we
-	 * can estimate how much work needs to be done.
+	 * Loop over all buffers that may be dirty according to BufferDirtyMap,
+	 * and mark the ones that need to be written with BM_CHECKPOINT_NEEDED.
+	 * Count them as we go (num_to_scan), so that we can estimate how much
+	 * work needs to be done.  Buffers found clean are removed from the map.
 	 *
 	 * This allows us to write only those pages that were dirty when the
 	 * checkpoint began, and not those that get dirtied while it proceeds.
@@ -1826,31 +1832,42 @@ BufferSync(int flags)
 	 * certainly need to be written for the next checkpoint attempt, too.
 	 */
 	num_to_scan = 0;
-	for (buf_id = 0; buf_id < NBuffers; buf_id++)
+	for (word = 0; word < BufferDirtyMapWords(); word++)
 	{
-		BufferDesc *bufHdr = GetBufferDescriptor(buf_id);
-
-		/*
-		 * Header spinlock is enough to examine BM_DIRTY, see comment in
-		 * SyncOneBuffer.
-		 */
-		buf_state = LockBufHdr(bufHdr);
+		uint32		bits = pg_atomic_read_u32(&BufferDirtyMap[word]);
 
-		if ((buf_state & mask) == mask)
+		while (bits != 0)
 		{
-			CkptSortItem *item;
+			BufferDesc *bufHdr;
 
-			buf_state |= BM_CHECKPOINT_NEEDED;
+			buf_id = word * BUFFER_DIRTY_MAP_BITS + pg_rightmost_one_pos32(bits);
+			bits &= bits - 1;
+			bufHdr = GetBufferDescriptor(buf_id);
 
-			item = &CkptBufferIds[num_to_scan++];
-			item->buf_id = buf_id;
-			item->tsId = bufHdr->tag.rnode.spcNode;
-			item->relNode = bufHdr->tag.rnode.relNode;
-			item->forkNum = bufHdr->tag.forkNum;
-			item->blockNum = bufHdr->tag.blockNum;
-		}
+			/*
+			 * Header spinlock is enough to examine BM_DIRTY, see comment in
+			 * SyncOneBuffer.
+			 */
+			buf_state = LockBufHdr(bufHdr);
 
-		UnlockBufHdr(bufHdr, buf_state);
+			if ((buf_state & mask) == mask)
+			{
+				CkptSortItem *item;
+
+				buf_state |= BM_CHECKPOINT_NEEDED;
+
+				item = &CkptBufferIds[num_to_scan++];
+				item->buf_id = buf_id;
+				item->tsId = bufHdr->tag.rnode.spcNode;
+				item->relNode = bufHdr->tag.rnode.relNode;
+				item->forkNum = bufHdr->tag.forkNum;
+				item->blockNum = bufHdr->tag.blockNum;
+			}
+			else if (!(buf_state & BM_DIRTY))
+				BufferDirtyMapClear(buf_id);
+
+			UnlockBufHdr(bufHdr, buf_state);
+		}
 	}
 
 	if (num_to_scan == 0)
@@ -3530,6 +3547,9 @@ MarkBufferDirtyHint(Buffer buffer, bool buffer_std)
 			 */
 			if (!XLogRecPtrIsInvalid(lsn))
 				PageSetLSN(page, lsn);
+
+			/* before a checkpoint waiting on delayChkpt can scan the map */
+			BufferDirtyMapSet(bufHdr->buf_id);
 		}
 
 		buf_state |= BM_DIRTY | BM_JUST_DIRTIED;
@@ -172,6 +172,8 @@ static void KnownAssignedXidsReset(void);
 static inline void ProcArrayEndTransactionInternal(PGPROC *proc,
 												   PGXACT *pgxact, TransactionId latestXid);
 static void ProcArrayGroupClearXid(PGPROC *proc, TransactionId latestXid);
+static bool GetSnapshotDataReuse(Snapshot snapshot);
+static void GetSnapshotDataFinish(Snapshot snapshot);
 
 /*
  * Report shared-memory space needed by CreateSharedProcArray.
@@ -246,6 +248,7 @@ CreateSharedProcArray(void)
 		procArray->lastOverflowedXid = InvalidTransactionId;
 		procArray->replication_slot_xmin = InvalidTransactionId;
 		procArray->replication_slot_catalog_xmin = InvalidTransactionId;
+		ShmemVariableCache->xactCompletionCount = 1;
 	}
 
 	allProcs = ProcGlobal->allProcs;
@@ -352,6 +355,9 @@ ProcArrayRemove(PGPROC *proc, TransactionId latestXid)
 		if (TransactionIdPrecedes(ShmemVariableCache->latestCompletedXid,
 								  latestXid))
 			ShmemVariableCache->latestCompletedXid = latestXid;
+
+		/* Same as ProcArrayEndTransactionInternal */
+		ShmemVariableCache->xactCompletionCount++;
 	}
 	else
 	{
@@ -467,6 +473,9 @@ ProcArrayEndTransactionInternal(PGPROC *proc, PGXACT *pgxact,
 	if (TransactionIdPrecedes(ShmemVariableCache->latestCompletedXid,
 							  latestXid))
 		ShmemVariableCache->latestCompletedXid = latestXid;
+
+	/* Invalidate snapshots cached by GetSnapshotData() */
+	ShmemVariableCache->xactCompletionCount++;
 }
 
 /*
@@ -602,11 +611,16 @@ ProcArrayClearTransaction(PGPROC *proc)
 	PGXACT	   *pgxact = &allPgXact[proc->pgprocno];
 
 	/*
-	 * We can skip locking ProcArrayLock here, because this action does not
-	 * actually change anyone's view of the set of running XIDs: our entry is
-	 * duplicate with the gxact that has already been inserted into the
-	 * ProcArray.
+	 * Clearing our XID doesn't change anyone else's view of the set of
+	 * running XIDs, since our entry is duplicate with the gxact that has
+	 * already been inserted into the ProcArray.  But GetSnapshotData() omits
+	 * the backend's own XID, so a snapshot we computed while the transaction
+	 * was open lacks the prepared XID, and must not be reused for our next
+	 * transaction.  Bump xactCompletionCount to prevent that, which requires
+	 * the exclusive lock.
 	 */
+	LWLockAcquire(ProcArrayLock, LW_EXCLUSIVE);
+
 	pgxact->xid = InvalidTransactionId;
 	proc->lxid = InvalidLocalTransactionId;
 	pgxact->xmin = InvalidTransactionId;
@@ -619,6 +633,10 @@ ProcArrayClearTransaction(PGPROC *proc)
 	/* Clear the subtransaction-XID cache too */
 	pgxact->nxids = 0;
 	pgxact->overflowed = false;
+
+	ShmemVariableCache->xactCompletionCount++;
+
+	LWLockRelease(ProcArrayLock);
 }
 
 /*
@@ -1498,6 +1516,12 @@ GetMaxSnapshotSubxidCount(void)
  *		RecentGlobalDataXmin: the global xmin for non-catalog tables
  *			>= RecentGlobalXmin
  *
+ * If no transaction with an XID has completed since the given snapshot was
+ * last filled in by this function, its contents are still accurate and are
+ * reused as-is, without scanning the ProcArray; see GetSnapshotDataReuse().
+ * In that case RecentGlobalXmin and RecentGlobalDataXmin are left alone,
+ * which is safe since an older value is merely more conservative.
+ *
  * Note: this function should probably not be called with an argument that's
  * not statically allocated (see xip allocation below).
  */
@@ -1555,6 +1579,13 @@ GetSnapshotData(Snapshot snapshot)
 	 */
 	LWLockAcquire(ProcArrayLock, LW_SHARED);
 
+	if (GetSnapshotDataReuse(snapshot))
+	{
+		LWLockRelease(ProcArrayLock);
+		GetSnapshotDataFinish(snapshot);
+		return snapshot;
+	}
+
 	/* xmax is always latestCompletedXid + 1 */
 	xmax = ShmemVariableCache->latestCompletedXid;
 	Assert(TransactionIdIsNormal(xmax));
@@ -1709,6 +1740,18 @@ GetSnapshotData(Snapshot snapshot)
 	if (!TransactionIdIsValid(MyPgXact->xmin))
 		MyPgXact->xmin = TransactionXmin = xmin;
 
+	/*
+	 * Remember the completion count, so the next call can tell whether the
+	 * contents are still current.  Snapshots taken during recovery are built
+	 * from KnownAssignedXids, whose changes are not counted; never reuse
+	 * those.
+	 */
+	if (snapshot->takenDuringRecovery)
+		snapshot->snapXactCompletionCount = 0;
+	else
+		snapshot->snapXactCompletionCount =
+			ShmemVariableCache->xactCompletionCount;
+
 	LWLockRelease(ProcArrayLock);
 
 	/*
@@ -1748,8 +1791,6 @@ GetSnapshotData(Snapshot snapshot)
 	snapshot->subxcnt = subcount;
 	snapshot->suboverflowed = suboverflowed;
 
-	snapshot->curcid = GetCurrentCommandId(false);
-
 	/*
 	 * This is a new snapshot, so set both refcounts are zero, and mark it as
 	 * not copied in persistent memory.
@@ -1758,6 +1799,68 @@ GetSnapshotData(Snapshot snapshot)
 	snapshot->regd_count = 0;
 	snapshot->copied = false;
 
+	GetSnapshotDataFinish(snapshot);
+
+	return snapshot;
+}
+
+/*
+ * GetSnapshotDataReuse -- try to reuse the previous contents of a snapshot
+ *
+ * The set of XIDs considered running by GetSnapshotData() can only shrink
+ * when a transaction with an XID (or an aborted subtransaction) completes,
+ * which always happens with ProcArrayLock held exclusively and bumps
+ * ShmemVariableCache->xactCompletionCount.  XIDs assigned later are >= the
+ * snapshot's xmax and are treated as running anyway.  So if the count still
+ * matches the one recorded in the snapshot, recomputing it would produce the
+ * same xmin, xmax and xip/subxip arrays, and we can skip the O(MaxBackends)
+ * scan of the ProcArray.
+ *
+ * Re-advertising the snapshot's xmin in MyPgXact is safe for the same
+ * reason: all XIDs that were running when it was computed still are, so no
+ * concurrent xmin horizon computation can have moved past it.
+ *
+ * Caller must hold ProcArrayLock.  Returns true if the snapshot was reused.
+ */
+static bool
+GetSnapshotDataReuse(Snapshot snapshot)
+{
+	Assert(LWLockHeldByMe(ProcArrayLock));
+
+	if (snapshot->snapXactCompletionCount == 0 ||
+		snapshot->snapXactCompletionCount !=
+		ShmemVariableCache->xactCompletionCount)
+		return false;
+
+	Assert(!snapshot->takenDuringRecovery);
+
+	if (!TransactionIdIsValid(MyPgXact->xmin))
+		MyPgXact->xmin = TransactionXmin = snapshot->xmin;
+
+	RecentXmin = snapshot->xmin;
+	Assert(TransactionIdPrecedesOrEquals(TransactionXmin, RecentXmin));
+
+	/*
+	 * The static snapshot may have been handed out before; it is a new
+	 * snapshot now, so reset its refcounts and mark it as not copied.
+	 */
+	snapshot->active_count = 0;
+	snapshot->regd_count = 0;
+	snapshot->copied = false;
+
+	return true;
+}
+
+/*
+ * GetSnapshotDataFinish -- fill in the per-call fields of a snapshot
+ *
+ * These must be set whether or not the XID contents were recomputed.
+ */
+static void
+GetSnapshotDataFinish(Snapshot snapshot)
+{
+	snapshot->curcid = GetCurrentCommandId(false);
+
 	if (old_snapshot_threshold < 0)
 	{
 		/*
@@ -1776,10 +1879,8 @@ GetSnapshotData(Snapshot snapshot)
 		 */
 		snapshot->lsn = GetXLogInsertRecPtr();
 		snapshot->whenTaken = GetSnapshotCurrentTimestamp();
-		MaintainOldSnapshotTimeMapping(snapshot->whenTaken, xmin);
+		MaintainOldSnapshotTimeMapping(snapshot->whenTaken, snapshot->xmin);
 	}
-
-	return snapshot;
 }
 
 /*
@@ -3102,6 +3203,9 @@ XidCacheRemoveRunningXids(TransactionId xid,
 							  latestXid))
 		ShmemVariableCache->latestCompletedXid = latestXid;
 
+	/* The set of running XIDs changed, so cached snapshots are stale */
+	ShmemVariableCache->xactCompletionCount++;
+
 	LWLockRelease(ProcArrayLock);
 }
 
@@ -94,6 +94,7 @@ static void RemoveProcFromArray(int code, Datum arg);
 static void ProcKill(int code, Datum arg);
 static void AuxiliaryProcKill(int code, Datum arg);
 static void CheckDeadLock(void);
+static Size FastPathLockShmemSize(void);
 
 
 /*
@@ -119,6 +120,32 @@ ProcGlobalShmemSize(void)
 	size = add_size(size, mul_size(NUM_AUXILIARY_PROCS, sizeof(PGXACT)));
 	size = add_size(size, mul_size(max_prepared_xacts, sizeof(PGXACT)));
 
+	/* fast-path lock arrays */
+	size = add_size(size, FastPathLockShmemSize());
+
+	return size;
+}
+
+/*
+ * Report shared-memory space needed by the fast-path lock arrays of all
+ * PGPROCs, which are sized by FastPathLockGroupsPerBackend.
+ */
+static Size
+FastPathLockShmemSize(void)
+{
+	Size		size;
+	Size		fpLockBitsSize,
+				fpRelIdSize;
+
+	Assert(FastPathLockGroupsPerBackend > 0);
+
+	fpLockBitsSize = MAXALIGN(FastPathLockGroupsPerBackend * sizeof(uint64));
+	fpRelIdSize = MAXALIGN(FastPathLockSlotsPerBackend() * sizeof(Oid));
+
+	size = mul_size(add_size(fpLockBitsSize, fpRelIdSize),
+					add_size(add_size(MaxBackends, NUM_AUXILIARY_PROCS),
+							 max_prepared_xacts));
+
 	return size;
 }
 
@@ -169,6 +196,9 @@ InitProcGlobal(void)
 				j;
 	bool		found;
 	uint32		TotalProcs = MaxBackends + NUM_AUXILIARY_PROCS + max_prepared_xacts;
+	char	   *fpPtr;
+	Size		fpLockBitsSize,
+				fpRelIdSize;
 
 	/* Create the ProcGlobal shared structure */
 	ProcGlobal = (PROC_HDR *)
@@ -217,6 +247,17 @@ InitProcGlobal(void)
 	MemSet(pgxacts, 0, TotalProcs * sizeof(PGXACT));
 	ProcGlobal->allPgXact = pgxacts;
 
+	/*
+	 * Allocate the fast-path lock arrays for all PGPROCs in one chunk.  Their
+	 * size depends on max_locks_per_transaction, so they can't be embedded
+	 * in PGPROC itself.
+	 */
+	fpLockBitsSize = MAXALIGN(FastPathLockGroupsPerBackend * sizeof(uint64));
+	fpRelIdSize = MAXALIGN(FastPathLockSlotsPerBackend() * sizeof(Oid));
+
+	fpPtr = ShmemAlloc(FastPathLockShmemSize());
+	MemSet(fpPtr, 0, FastPathLockShmemSize());
+
 	for (i = 0; i < TotalProcs; i++)
 	{
 		/* Common initialization for all PGPROCs, regardless of type. */
@@ -234,6 +275,12 @@ InitProcGlobal(void)
 		}
 		procs[i].pgprocno = i;
 
+		/* Point the fast-path lock arrays at this PGPROC's share */
+		procs[i].fpLockBits = (uint64 *) fpPtr;
+		fpPtr += fpLockBitsSize;
+		procs[i].fpRelId = (Oid *) fpPtr;
+		fpPtr += fpRelIdSize;
+
 		/*
 		 * Newly created PGPROCs for normal backends, autovacuum and bgworkers
 		 * must be queued up on the appropriate free list.  Because there can
@@ -13,11 +13,95 @@
  */
 #include "postgres.h"
 
+#ifdef USE_AVX2_CHECKSUM_WITH_RUNTIME_CHECK
+#ifdef HAVE__GET_CPUID
+#include <cpuid.h>
+#endif
+#ifdef HAVE__CPUID
+#include <intrin.h>
+#endif
+#endif
+
 #include "storage/checksum.h"
 
+#ifdef USE_AVX2_CHECKSUM_WITH_RUNTIME_CHECK
+static bool pg_checksum_block_sums_fast(uint32 *sums, const void *page);
+
+#define PG_CHECKSUM_BLOCK_SUMS(sums, page) \
+	pg_checksum_block_sums_fast((sums), (page))
+#endif
+
 /*
  * The actual code is in storage/checksum_impl.h.  This is done so that
  * external programs can incorporate the checksum code by #include'ing
  * that file from the exported Postgres headers.  (Compare our CRC code.)
  */
 #include "storage/checksum_impl.h"
+
+#ifdef USE_AVX2_CHECKSUM_WITH_RUNTIME_CHECK
+
+/*
+ * Does the CPU we're running on support AVX2, and does the OS preserve the
+ * AVX registers across context switches?
+ */
+static bool
+pg_checksum_avx2_available(void)
+{
+	unsigned int exx[4] = {0, 0, 0, 0};
+	uint32		xcr0_lo;
+	uint32		xcr0_hi;
+
+#if defined(HAVE__GET_CPUID)
+	__get_cpuid(1, &exx[0], &exx[1], &exx[2], &exx[3]);
+#elif defined(HAVE__CPUID)
+	__cpuid(exx, 1);
+#else
+#error cpuid instruction not available
+#endif
+
+	if ((exx[2] & (1 << 27)) == 0)	/* OSXSAVE */
+		return false;
+
+#ifdef HAVE__CPUID
+	{
+		unsigned __int64 xcr0 = _xgetbv(0);
+
+		xcr0_lo = (uint32) xcr0;
+		xcr0_hi = (uint32) (xcr0 >> 32);
+	}
+#else
+	__asm__ __volatile__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+#endif
+	(void) xcr0_hi;
+	if ((xcr0_lo & 0x6) != 0x6)	/* XMM and YMM state */
+		return false;
+
+#if defined(HAVE__GET_CPUID)
+	__cpuid_count(7, 0, exx[0], exx[1], exx[2], exx[3]);
+#elif defined(HAVE__CPUID)
+	__cpuidex(exx, 7, 0);
+#endif
+
+	return (exx[1] & (1 << 5)) != 0;	/* AVX2 */
+}
+
+/*
+ * Compute the partial checksums of a page using AVX2 instructions, if the
+ * CPU supports them.  That is checked on first call.
+ */
+static bool
+pg_checksum_block_sums_fast(uint32 *sums, const void *page)
+{
+	static int	avx2_available = -1;
+
+	if (unlikely(avx2_available < 0))
+		avx2_available = pg_checksum_avx2_available() ? 1 : 0;
+
+	if (!avx2_available)
+		return false;
+
+	pg_checksum_block_sums_avx2(sums, page);
+	return true;
+}
+
+#endif							/* USE_AVX2_CHECKSUM_WITH_RUNTIME_CHECK */
@@ -0,0 +1,92 @@
+/*-------------------------------------------------------------------------
+ *
+ * checksum_avx2.c
+ *	  Data page checksum calculation using AVX2 instructions.
+ *
+ * This computes the same N_SUMS partial checksums as pg_checksum_block() in
+ * storage/checksum_impl.h, keeping all of them in four 256-bit registers.
+ * The compiler cannot be relied on to do that by itself, because the plain
+ * SSE2 instruction set that it vectorizes the generic loop for lacks a
+ * 32-bit multiply.  checksum.c only calls this after checking that the CPU
+ * supports AVX2.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/page/checksum_avx2.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "storage/checksum.h"
+
+#ifdef USE_AVX2_CHECKSUM_WITH_RUNTIME_CHECK
+
+#include <immintrin.h>
+
+/* these must match storage/checksum_impl.h */
+#define N_SUMS 32
+#define FNV_PRIME 16777619
+
+/*
+ * Calculate one round of the checksum for eight partial checksums at once.
+ */
+#define CHECKSUM_COMP_AVX2(checksum, value, prime) \
+do { \
+	__m256i		__tmp = _mm256_xor_si256((checksum), (value)); \
+	(checksum) = _mm256_xor_si256(_mm256_mullo_epi32(__tmp, (prime)), \
+								  _mm256_srli_epi32(__tmp, 17)); \
+} while (0)
+
+/*
+ * Compute the partial checksums of a page.  On entry, sums[] holds their
+ * initial values.
+ */
+void
+pg_checksum_block_sums_avx2(uint32 *sums, const void *page)
+{
+	const __m256i *data = (const __m256i *) page;
+	const __m256i prime = _mm256_set1_epi32(FNV_PRIME);
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i		s0,
+				s1,
+				s2,
+				s3;
+	int			i;
+
+	StaticAssertStmt(N_SUMS == 4 * sizeof(__m256i) / sizeof(uint32),
+					 "partial checksums must fill four registers");
+
+	s0 = _mm256_loadu_si256((const __m256i *) sums);
+	s1 = _mm256_loadu_si256((const __m256i *) (sums + 8));
+	s2 = _mm256_loadu_si256((const __m256i *) (sums + 16));
+	s3 = _mm256_loadu_si256((const __m256i *) (sums + 24));
+
+	/* main checksum calculation, one row of N_SUMS words at a time */
+	for (i = 0; i < BLCKSZ / (sizeof(uint32) * N_SUMS); i++)
+	{
+		CHECKSUM_COMP_AVX2(s0, _mm256_loadu_si256(data), prime);
+		CHECKSUM_COMP_AVX2(s1, _mm256_loadu_si256(data + 1), prime);
+		CHECKSUM_COMP_AVX2(s2, _mm256_loadu_si256(data + 2), prime);
+		CHECKSUM_COMP_AVX2(s3, _mm256_loadu_si256(data + 3), prime);
+		data += 4;
+	}
+
+	/* finally add in two rounds of zeroes for additional mixing */
+	for (i = 0; i < 2; i++)
+	{
+		CHECKSUM_COMP_AVX2(s0, zero, prime);
+		CHECKSUM_COMP_AVX2(s1, zero, prime);
+		CHECKSUM_COMP_AVX2(s2, zero, prime);
+		CHECKSUM_COMP_AVX2(s3, zero, prime);
+	}
+
+	_mm256_storeu_si256((__m256i *) sums, s0);
+	_mm256_storeu_si256((__m256i *) (sums + 8), s1);
+	_mm256_storeu_si256((__m256i *) (sums + 16), s2);
+	_mm256_storeu_si256((__m256i *) (sums + 24), s3);
+}
+
+#endif							/* USE_AVX2_CHECKSUM_WITH_RUNTIME_CHECK */
@@ -199,6 +199,8 @@ static bool get_actual_variable_range(PlannerInfo *root,
 									  Oid sortop,
 									  Datum *min, Datum *max);
 static RelOptInfo *find_join_input_rel(PlannerInfo *root, Relids relids);
+static double btree_leading_numdistinct(PlannerInfo *root, IndexOptInfo *index,
+										bool *isdefault);
 
 
 /*
@@ -5704,6 +5706,39 @@ add_predicate_to_index_quals(IndexOptInfo *index, List *indexQuals)
 	return list_concat(predExtraQuals, indexQuals);
 }
 
+/*
+ * Estimate the number of distinct values of a btree index's first column,
+ * which is the number of primitive index scans a skip scan does.
+ */
+static double
+btree_leading_numdistinct(PlannerInfo *root, IndexOptInfo *index,
+						  bool *isdefault)
+{
+	Node	   *leadcol;
+	VariableStatData vardata;
+	double		numdistinct;
+
+	if (index->indexkeys[0] != 0)
+	{
+		RangeTblEntry *rte = planner_rt_fetch(index->rel->relid, root);
+		Oid			vartype;
+		int32		vartypmod;
+		Oid			varcollid;
+
+		get_atttypetypmodcoll(rte->relid, index->indexkeys[0],
+							  &vartype, &vartypmod, &varcollid);
+		leadcol = (Node *) makeVar(index->rel->relid, index->indexkeys[0],
+								   vartype, vartypmod, varcollid, 0);
+	}
+	else
+		leadcol = (Node *) linitial(index->indexprs);
+
+	examine_variable(root, leadcol, 0, &vardata);
+	numdistinct = get_variable_numdistinct(&vardata, isdefault);
+	ReleaseVariableStats(vardata);
+
+	return numdistinct;
+}
 
 void
 btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
@@ -5724,8 +5759,37 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	bool		found_saop;
 	bool		found_is_null_op;
 	double		num_sa_scans;
+	bool		skipscan;
+	double		num_skip_descents;
 	ListCell   *lc;
 
+	/*
+	 * If there are quals on the second column but none on the first, btree
+	 * does a skip scan, doing one primitive index scan for each distinct
+	 * value of the first column, unless there are ScalarArrayOpExprs (see
+	 * _bt_preprocess_skip_key()).  The quals on the following columns then
+	 * act as boundary quals, as if there were an '=' qual on the first.
+	 */
+	skipscan = false;
+	if (path->indexclauses != NIL &&
+		linitial_node(IndexClause, path->indexclauses)->indexcol == 1)
+	{
+		skipscan = true;
+		foreach(lc, path->indexclauses)
+		{
+			IndexClause *iclause = lfirst_node(IndexClause, lc);
+			ListCell   *lc2;
+
+			foreach(lc2, iclause->indexquals)
+			{
+				RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc2);
+
+				if (IsA(rinfo->clause, ScalarArrayOpExpr))
+					skipscan = false;
+			}
+		}
+	}
+
 	/*
 	 * For a btree scan, only leading '=' quals plus inequality quals for the
 	 * immediately next attribute contribute to index selectivity (these are
@@ -5744,7 +5808,7 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	 * considered to act the same as it normally does.
 	 */
 	indexBoundQuals = NIL;
-	indexcol = 0;
+	indexcol = skipscan ? 1 : 0;
 	eqQualHere = false;
 	found_saop = false;
 	found_is_null_op = false;
@@ -5833,6 +5897,7 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	 * NullTest invalidates that theory, even though it sets eqQualHere.
 	 */
 	if (index->unique &&
+		!skipscan &&
 		indexcol == index->nkeycolumns - 1 &&
 		eqQualHere &&
 		!found_saop &&
@@ -5864,6 +5929,45 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 		numIndexTuples = rint(numIndexTuples / num_sa_scans);
 	}
 
+	/*
+	 * A skip scan descends the tree twice per distinct value of the first
+	 * column, once to find the value and once to find the first tuple
+	 * matching the boundary quals, reading a leaf page each time.  Charge
+	 * for the tuples on those leaf pages here, and for the descents below.
+	 * If that comes out more expensive than reading the whole index, the
+	 * skip scan gives up early at runtime, so cost it as a full scan.  Don't
+	 * bet on it without statistics, though.
+	 */
+	num_skip_descents = 0;
+	if (skipscan)
+	{
+		double		numdistinct;
+		bool		isdefault;
+		double		skipIndexTuples;
+		double		fullIndexTuples;
+
+		numdistinct = btree_leading_numdistinct(root, index, &isdefault);
+		skipIndexTuples = numIndexTuples;
+		if (index->pages > 1)
+			skipIndexTuples += 2 * numdistinct * index->tuples / index->pages;
+
+		fullIndexTuples =
+			clauselist_selectivity(root,
+								   add_predicate_to_index_quals(index, NIL),
+								   index->rel->relid,
+								   JOIN_INNER,
+								   NULL) * index->rel->tuples;
+		fullIndexTuples = rint(fullIndexTuples);
+
+		if (!isdefault && skipIndexTuples < fullIndexTuples)
+		{
+			numIndexTuples = rint(skipIndexTuples);
+			num_skip_descents = 2 * numdistinct;
+		}
+		else
+			numIndexTuples = fullIndexTuples;
+	}
+
 	/*
 	 * Now do generic index cost estimation.
 	 */
@@ -5888,6 +5992,7 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 		descentCost = ceil(log(index->tuples) / log(2.0)) * cpu_operator_cost;
 		costs.indexStartupCost += descentCost;
 		costs.indexTotalCost += costs.num_sa_scans * descentCost;
+		costs.indexTotalCost += num_skip_descents * descentCost;
 	}
 
 	/*
@@ -5903,6 +6008,7 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	descentCost = (index->tree_height + 1) * 50.0 * cpu_operator_cost;
 	costs.indexStartupCost += descentCost;
 	costs.indexTotalCost += costs.num_sa_scans * descentCost;
+	costs.indexTotalCost += num_skip_descents * descentCost;
 
 	/*
 	 * If we can get an estimate of the first column's ordering correlation C
@@ -1098,6 +1098,19 @@ CommandEndInvalidationMessages(void)
 							   &transInvalInfo->CurrentCmdInvalidMsgs);
 }
 
+/*
+ * TransactionHasPendingInvalidations
+ *		Has the current transaction queued any invalidation messages?
+ *
+ * If so, it has made catalog changes that other backends can't see yet, and
+ * that may still be rolled back.
+ */
+bool
+TransactionHasPendingInvalidations(void)
+{
+	return transInvalInfo != NULL;
+}
+
 
 /*
  * CacheInvalidateHeapTuple
@@ -38,6 +38,10 @@
  * catalogs to be infrequent enough that more-detailed tracking is not worth
  * the effort.
  *
+ * Generic plans can also be exchanged with other backends through the
+ * shared plan cache (see sharedplancache.c), which relies on the inval
+ * callbacks here to learn about changes.
+ *
  * In addition to full-fledged query plans, we provide a facility for
  * detecting invalidations of simple scalar expressions.  This is fairly
  * bare-bones; it's the caller's responsibility to build a new expression
@@ -71,6 +75,7 @@
 #include "utils/memutils.h"
 #include "utils/resowner_private.h"
 #include "utils/rls.h"
+#include "utils/sharedplancache.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
 
@@ -878,9 +883,11 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 				ParamListInfo boundParams, QueryEnvironment *queryEnv)
 {
 	CachedPlan *plan;
-	List	   *plist;
+	List	   *plist = NIL;
 	bool		snapshot_set;
 	bool		is_transient;
+	char	   *shared_key = NULL;
+	SharedPlanCacheStamp *stamp = NULL;
 	MemoryContext plan_context;
 	MemoryContext oldcxt = CurrentMemoryContext;
 	ListCell   *lc;
@@ -915,26 +922,94 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	}
 
 	/*
-	 * If a snapshot is already set (the normal case), we can just use that
-	 * for planning.  But if it isn't, and we need one, install one.
+	 * A generic plan may be available from the shared plan cache.  To use
+	 * it, we must lock everything it touches, which also processes any
+	 * pending invalidations, and then make sure nothing it depends on has
+	 * been invalidated since it was built.  If that fails we release those
+	 * locks again and plan locally.
+	 *
+	 * Skip the shared cache altogether if our transaction has made catalog
+	 * changes.  A plan built here might depend on them, and they can still
+	 * be rolled back; and a plan built elsewhere might not reflect them,
+	 * without any counter having moved since.
 	 */
-	snapshot_set = false;
-	if (!ActiveSnapshotSet() &&
-		plansource->raw_parse_tree &&
-		analyze_requires_snapshot(plansource->raw_parse_tree))
+	if (boundParams == NULL && shared_plan_cache_size > 0 &&
+		!plansource->is_oneshot && !plansource->dependsOnRLS &&
+		queryEnv == NULL && !TransactionHasPendingInvalidations())
+		shared_key = SharedPlanCacheMakeKey(qlist, plansource->cursor_options);
+
+	if (shared_key)
 	{
-		PushActiveSnapshot(GetTransactionSnapshot());
-		snapshot_set = true;
+		plist = SharedPlanCacheLookup(shared_key, &stamp);
+		if (plist != NIL)
+		{
+			AcquireExecutorLocks(plist, true);
+			if (plansource->is_valid && SharedPlanCacheStampIsCurrent(stamp))
+			{
+				ListCell   *lc2;
+
+				/* Restore fields that are not kept by the shared copy */
+				forboth(lc, plist, lc2, qlist)
+				{
+					PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc);
+					Query	   *query = lfirst_node(Query, lc2);
+
+					plannedstmt->queryId = query->queryId;
+					plannedstmt->stmt_location = query->stmt_location;
+					plannedstmt->stmt_len = query->stmt_len;
+				}
+
+				elog(DEBUG2, "using generic plan from shared plan cache");
+			}
+			else
+			{
+				AcquireExecutorLocks(plist, false);
+				plist = NIL;
+			}
+		}
 	}
 
-	/*
-	 * Generate the plan.
-	 */
-	plist = pg_plan_queries(qlist, plansource->cursor_options, boundParams);
+	if (plist == NIL)
+	{
+		/*
+		 * Snapshot the invalidation counters before planning, and only then
+		 * catch up with pending invalidations.  Any catalog change the
+		 * planner doesn't see yet then has a counter bump after the stamp,
+		 * which keeps SharedPlanCacheStore from publishing the plan.
+		 */
+		if (shared_key)
+		{
+			stamp = SharedPlanCacheBeginPlanning();
+			AcceptInvalidationMessages();
+		}
 
-	/* Release snapshot if we got one */
-	if (snapshot_set)
-		PopActiveSnapshot();
+		/*
+		 * If a snapshot is already set (the normal case), we can just use
+		 * that for planning.  But if it isn't, and we need one, install one.
+		 */
+		snapshot_set = false;
+		if (!ActiveSnapshotSet() &&
+			plansource->raw_parse_tree &&
+			analyze_requires_snapshot(plansource->raw_parse_tree))
+		{
+			PushActiveSnapshot(GetTransactionSnapshot());
+			snapshot_set = true;
+		}
+
+		/*
+		 * Generate the plan.
+		 */
+		plist = pg_plan_queries(qlist, plansource->cursor_options,
+								boundParams);
+
+		/* Release snapshot if we got one */
+		if (snapshot_set)
+			PopActiveSnapshot();
+
+		/* Offer the new plan to the shared plan cache */
+		if (shared_key)
+			SharedPlanCacheStore(shared_key, plist, stamp);
+	}
 
 	/*
 	 * Normally we make a dedicated memory context for the CachedPlan and its
@@ -1765,6 +1840,8 @@ PlanCacheRelCallback(Datum arg, Oid relid)
 {
 	dlist_iter	iter;
 
+	SharedPlanCacheInvalidateRel(relid);
+
 	dlist_foreach(iter, &saved_plan_list)
 	{
 		CachedPlanSource *plansource = dlist_container(CachedPlanSource,
@@ -1849,6 +1926,8 @@ PlanCacheObjectCallback(Datum arg, int cacheid, uint32 hashvalue)
 {
 	dlist_iter	iter;
 
+	SharedPlanCacheInvalidateObject(cacheid, hashvalue);
+
 	dlist_foreach(iter, &saved_plan_list)
 	{
 		CachedPlanSource *plansource = dlist_container(CachedPlanSource,
@@ -1956,6 +2035,7 @@ PlanCacheObjectCallback(Datum arg, int cacheid, uint32 hashvalue)
 static void
 PlanCacheSysCallback(Datum arg, int cacheid, uint32 hashvalue)
 {
+	SharedPlanCacheInvalidateAll();
 	ResetPlanCache();
 }
 
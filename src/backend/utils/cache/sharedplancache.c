@@ -0,0 +1,685 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedplancache.c
+ *	  Cross-backend cache of generic plans.
+ *
+ * When shared_plan_cache_size is set, generic plans built by plancache.c
+ * are serialized into a dynamic shared area carved out of the main shared
+ * memory segment, so that another backend preparing the same statement can
+ * adopt the finished plan instead of running the planner again.
+ *
+ * Entries are keyed by the text form of the analyzed and rewritten query
+ * tree, together with the database, the current user, the cursor options
+ * and every planner-relevant setting that differs from its built-in
+ * default.  Keying on the query tree rather than the query string means
+ * that anything affecting parse analysis (search_path, object creation and
+ * so on) simply produces a different key.
+ *
+ * Invalidation piggybacks on the sinval callbacks of plancache.c.  Every
+ * backend that processes a relcache or PROCOID/TYPEOID syscache inval bumps
+ * one of a fixed array of shared counters, selected by hashing the object's
+ * identity; other catalog invals and cache resets bump a global counter.
+ * A backend snapshots the counters before planning and stores the values of
+ * the slots its plan depends on along with the plan.  A backend adopting the
+ * plan first locks the plan's relations, which processes any pending invals,
+ * and then verifies that none of those counters has moved.  Counter
+ * collisions only cause spurious invalidations.
+ *
+ * Since the committing backend's own callbacks bump the counters when the
+ * catalog change becomes visible to it, and every other backend bumps them
+ * again when it receives the message, a plan built against catalog state
+ * that has since been superseded can never pass the check in a backend that
+ * already sees the new state.  The counters can't protect against catalog
+ * changes that haven't been committed yet, though, so a transaction that
+ * has made any doesn't use the shared cache at all.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/cache/sharedplancache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "catalog/pg_class.h"
+#include "lib/stringinfo.h"
+#include "miscadmin.h"
+#include "nodes/plannodes.h"
+#include "port/atomics.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/dsa.h"
+#include "utils/guc.h"
+#include "utils/guc_tables.h"
+#include "utils/hashutils.h"
+#include "utils/hsearch.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/sharedplancache.h"
+
+
+/* Number of invalidation counters; must be a power of 2 */
+#define SPC_NUM_COUNTERS	1024
+
+/* Expected shared memory consumed per cached plan, for sizing the index */
+#define SPC_BYTES_PER_ENTRY 4096
+
+/* Shared state, followed by the space for the dynamic shared area */
+typedef struct SharedPlanCacheControl
+{
+	LWLock		lock;			/* protects the index and the area contents */
+	int			max_entries;	/* capacity of the index */
+	int			num_entries;	/* current number of entries */
+	Size		area_size;		/* size of the in-place area */
+	pg_atomic_uint64 clock;		/* source of last_used values */
+	pg_atomic_uint64 global_counter;	/* bumped by "invalidate all" */
+	pg_atomic_uint64 counters[SPC_NUM_COUNTERS];
+} SharedPlanCacheControl;
+
+/*
+ * Index entry for one cached plan.  The data chunk holds the counter values
+ * (uint64 each), the matching counter numbers (uint32 each), the key string
+ * and the serialized plan, in that order, the strings null-terminated.
+ */
+typedef struct SharedPlanCacheEntry
+{
+	uint64		hash;			/* hash of the key string; hash key */
+	dsa_pointer data;			/* see above */
+	uint64		global_counter; /* global counter at planning time */
+	int			ncounters;		/* number of counters the plan depends on */
+	Size		keylen;			/* length of the key string */
+	Size		planlen;		/* length of the serialized plan */
+	pg_atomic_uint64 last_used; /* clock value at last lookup */
+} SharedPlanCacheEntry;
+
+/*
+ * Snapshot of the invalidation counters.  Stamps returned by
+ * SharedPlanCacheBeginPlanning cover every counter, in which case counterno
+ * is NULL and values is indexed by counter number.
+ */
+struct SharedPlanCacheStamp
+{
+	uint64		global_counter;
+	int			ncounters;
+	uint32	   *counterno;
+	uint64	   *values;
+};
+
+/* GUC parameter */
+int			shared_plan_cache_size = 0;
+
+static SharedPlanCacheControl *SharedPlanCache = NULL;
+static HTAB *SharedPlanHash = NULL;
+static dsa_area *SharedPlanArea = NULL;
+
+static Size SharedPlanCacheMaxEntries(void);
+static void *SharedPlanCacheAreaPlace(void);
+static void SharedPlanCacheAttach(void);
+static bool SharedPlanCacheEvictOne(void);
+static void SharedPlanCacheRemoveEntry(SharedPlanCacheEntry *entry);
+static bool SharedPlanCacheEntryIsCurrent(SharedPlanCacheEntry *entry);
+
+
+#define SharedPlanCacheEnabled() \
+	(shared_plan_cache_size > 0 && SharedPlanCache != NULL)
+
+#define RelCounter(relid) \
+	(murmurhash32((uint32) (relid)) & (SPC_NUM_COUNTERS - 1))
+#define ObjectCounter(cacheid, hashvalue) \
+	((murmurhash32((uint32) (cacheid)) ^ (hashvalue)) & (SPC_NUM_COUNTERS - 1))
+
+/*
+ * Report the amount of fixed shared memory needed.
+ */
+Size
+SharedPlanCacheShmemSize(void)
+{
+	Size		size;
+
+	if (shared_plan_cache_size <= 0)
+		return 0;
+
+	size = MAXALIGN(sizeof(SharedPlanCacheControl));
+	size = add_size(size, dsa_minimum_size());
+	size = add_size(size, mul_size(shared_plan_cache_size, 1024));
+	size = add_size(size, hash_estimate_size(SharedPlanCacheMaxEntries(),
+											 sizeof(SharedPlanCacheEntry)));
+
+	return size;
+}
+
+/*
+ * Allocate and initialize the shared state, or attach to it.
+ *
+ * The postmaster creates the dynamic shared area in place and pins it; each
+ * backend attaches on first use.
+ */
+void
+SharedPlanCacheShmemInit(void)
+{
+	HASHCTL		info;
+	bool		found;
+	Size		max_entries;
+
+	if (shared_plan_cache_size <= 0)
+		return;
+
+	max_entries = SharedPlanCacheMaxEntries();
+
+	SharedPlanCache = (SharedPlanCacheControl *)
+		ShmemInitStruct("Shared Plan Cache",
+						add_size(MAXALIGN(sizeof(SharedPlanCacheControl)),
+								 add_size(dsa_minimum_size(),
+										  mul_size(shared_plan_cache_size,
+												   1024))),
+						&found);
+
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = sizeof(uint64);
+	info.entrysize = sizeof(SharedPlanCacheEntry);
+	SharedPlanHash = ShmemInitHash("Shared Plan Cache Index",
+								   max_entries, max_entries,
+								   &info,
+								   HASH_ELEM | HASH_BLOBS);
+
+	if (!found)
+	{
+		dsa_area   *area;
+		int			i;
+
+		LWLockInitialize(&SharedPlanCache->lock, LWTRANCHE_SHARED_PLAN_CACHE);
+		SharedPlanCache->max_entries = (int) max_entries;
+		SharedPlanCache->num_entries = 0;
+		SharedPlanCache->area_size = add_size(dsa_minimum_size(),
+											  mul_size(shared_plan_cache_size,
+													   1024));
+		pg_atomic_init_u64(&SharedPlanCache->clock, 0);
+		pg_atomic_init_u64(&SharedPlanCache->global_counter, 0);
+		for (i = 0; i < SPC_NUM_COUNTERS; i++)
+			pg_atomic_init_u64(&SharedPlanCache->counters[i], 0);
+
+		area = dsa_create_in_place(SharedPlanCacheAreaPlace(),
+								   SharedPlanCache->area_size,
+								   LWTRANCHE_SHARED_PLAN_CACHE_DSA, NULL);
+		dsa_set_size_limit(area, SharedPlanCache->area_size);
+		dsa_pin(area);
+		dsa_detach(area);
+	}
+}
+
+/*
+ * Capacity of the index, derived from the configured cache size.
+ */
+static Size
+SharedPlanCacheMaxEntries(void)
+{
+	return Max((Size) shared_plan_cache_size * 1024 / SPC_BYTES_PER_ENTRY, 64);
+}
+
+static void *
+SharedPlanCacheAreaPlace(void)
+{
+	return (char *) SharedPlanCache + MAXALIGN(sizeof(SharedPlanCacheControl));
+}
+
+/*
+ * Attach this backend to the dynamic shared area, if not done yet.
+ */
+static void
+SharedPlanCacheAttach(void)
+{
+	MemoryContext oldcxt;
+
+	if (SharedPlanArea != NULL)
+		return;
+
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	SharedPlanArea = dsa_attach_in_place(SharedPlanCacheAreaPlace(), NULL);
+	MemoryContextSwitchTo(oldcxt);
+
+	on_shmem_exit(dsa_on_shmem_exit_release_in_place,
+				  PointerGetDatum(SharedPlanCacheAreaPlace()));
+}
+
+/*
+ * Build the cache key for a query list, or return NULL if plans for it must
+ * not be shared.
+ */
+char *
+SharedPlanCacheMakeKey(List *query_list, int cursor_options)
+{
+	StringInfoData buf;
+	struct config_generic **gucs;
+	int			ngucs;
+	int			i;
+	ListCell   *lc;
+
+	if (!SharedPlanCacheEnabled())
+		return NULL;
+
+	foreach(lc, query_list)
+	{
+		Query	   *query = lfirst_node(Query, lc);
+
+		if (query->commandType == CMD_UTILITY)
+			return NULL;
+	}
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "%u %u %d",
+					 MyDatabaseId, GetUserId(), cursor_options);
+
+	gucs = get_explain_guc_options(&ngucs);
+	for (i = 0; i < ngucs; i++)
+		appendStringInfo(&buf, " %s=%s", gucs[i]->name,
+						 GetConfigOptionByName(gucs[i]->name, NULL, true));
+	pfree(gucs);
+
+	appendStringInfoChar(&buf, ' ');
+	appendStringInfoString(&buf, nodeToString(query_list));
+
+	return buf.data;
+}
+
+/*
+ * Look up a shared plan for the given key.
+ *
+ * On success, returns a freshly deserialized list of PlannedStmts in the
+ * caller's memory context and sets *stamp to the counter values the plan was
+ * built against.  The caller must lock the plan's relations and then check
+ * the stamp with SharedPlanCacheStampIsCurrent before using the plan.
+ * Returns NIL if there's no usable entry.
+ */
+List *
+SharedPlanCacheLookup(const char *key, SharedPlanCacheStamp **stamp)
+{
+	SharedPlanCacheEntry *entry;
+	SharedPlanCacheStamp *result;
+	uint64		hash;
+	Size		keylen = strlen(key);
+	char	   *data;
+	char	   *plan;
+
+	*stamp = NULL;
+
+	if (!SharedPlanCacheEnabled())
+		return NIL;
+
+	SharedPlanCacheAttach();
+	hash = DatumGetUInt64(hash_any_extended((const unsigned char *) key,
+											keylen, 0));
+
+	LWLockAcquire(&SharedPlanCache->lock, LW_SHARED);
+
+	entry = (SharedPlanCacheEntry *) hash_search(SharedPlanHash, &hash,
+												 HASH_FIND, NULL);
+	if (entry == NULL || entry->keylen != keylen ||
+		!SharedPlanCacheEntryIsCurrent(entry))
+	{
+		LWLockRelease(&SharedPlanCache->lock);
+		return NIL;
+	}
+
+	data = dsa_get_address(SharedPlanArea, entry->data);
+	if (memcmp(data + entry->ncounters * (sizeof(uint64) + sizeof(uint32)),
+			   key, keylen) != 0)
+	{
+		LWLockRelease(&SharedPlanCache->lock);
+		return NIL;
+	}
+
+	result = (SharedPlanCacheStamp *) palloc(sizeof(SharedPlanCacheStamp));
+	result->global_counter = entry->global_counter;
+	result->ncounters = entry->ncounters;
+	result->values = (uint64 *) palloc(entry->ncounters * sizeof(uint64));
+	result->counterno = (uint32 *) palloc(entry->ncounters * sizeof(uint32));
+	memcpy(result->values, data, entry->ncounters * sizeof(uint64));
+	data += entry->ncounters * sizeof(uint64);
+	memcpy(result->counterno, data, entry->ncounters * sizeof(uint32));
+	data += entry->ncounters * sizeof(uint32) + keylen + 1;
+	plan = pnstrdup(data, entry->planlen);
+
+	pg_atomic_write_u64(&entry->last_used,
+						pg_atomic_fetch_add_u64(&SharedPlanCache->clock, 1));
+
+	LWLockRelease(&SharedPlanCache->lock);
+
+	*stamp = result;
+	return (List *) stringToNode(plan);
+}
+
+/*
+ * Snapshot all invalidation counters; to be called before planning a query
+ * whose plan will be passed to SharedPlanCacheStore.
+ */
+SharedPlanCacheStamp *
+SharedPlanCacheBeginPlanning(void)
+{
+	SharedPlanCacheStamp *stamp;
+	int			i;
+
+	if (!SharedPlanCacheEnabled())
+		return NULL;
+
+	stamp = (SharedPlanCacheStamp *) palloc(sizeof(SharedPlanCacheStamp));
+	stamp->global_counter =
+		pg_atomic_read_u64(&SharedPlanCache->global_counter);
+	stamp->ncounters = SPC_NUM_COUNTERS;
+	stamp->counterno = NULL;
+	stamp->values = (uint64 *) palloc(SPC_NUM_COUNTERS * sizeof(uint64));
+	for (i = 0; i < SPC_NUM_COUNTERS; i++)
+		stamp->values[i] = pg_atomic_read_u64(&SharedPlanCache->counters[i]);
+
+	return stamp;
+}
+
+/*
+ * Check whether any counter covered by the stamp has moved.
+ */
+bool
+SharedPlanCacheStampIsCurrent(SharedPlanCacheStamp *stamp)
+{
+	int			i;
+
+	if (stamp == NULL || !SharedPlanCacheEnabled())
+		return false;
+
+	if (pg_atomic_read_u64(&SharedPlanCache->global_counter) !=
+		stamp->global_counter)
+		return false;
+
+	for (i = 0; i < stamp->ncounters; i++)
+	{
+		uint32		counterno = stamp->counterno ? stamp->counterno[i] : i;
+
+		if (pg_atomic_read_u64(&SharedPlanCache->counters[counterno]) !=
+			stamp->values[i])
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Check an entry's counters against the current ones.  Caller must hold the
+ * lock.
+ */
+static bool
+SharedPlanCacheEntryIsCurrent(SharedPlanCacheEntry *entry)
+{
+	uint64	   *values;
+	uint32	   *counterno;
+	int			i;
+
+	if (pg_atomic_read_u64(&SharedPlanCache->global_counter) !=
+		entry->global_counter)
+		return false;
+
+	values = (uint64 *) dsa_get_address(SharedPlanArea, entry->data);
+	counterno = (uint32 *) (values + entry->ncounters);
+	for (i = 0; i < entry->ncounters; i++)
+	{
+		if (pg_atomic_read_u64(&SharedPlanCache->counters[counterno[i]]) !=
+			values[i])
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Offer a freshly built generic plan to the shared cache.
+ *
+ * stamp must come from SharedPlanCacheBeginPlanning, called before planning
+ * started.  Plans that depend on the current transaction or role, or that
+ * involve temporary relations, are not stored; neither are plans whose
+ * dependencies were invalidated while planning was in progress.
+ */
+void
+SharedPlanCacheStore(const char *key, List *stmt_list,
+					 SharedPlanCacheStamp *stamp)
+{
+	SharedPlanCacheEntry *entry;
+	bool	   *seen;
+	uint32	   *counterno;
+	int			ncounters = 0;
+	uint64		hash;
+	Size		keylen = strlen(key);
+	Size		planlen;
+	Size		total;
+	char	   *plan;
+	char	   *data;
+	dsa_pointer dp;
+	bool		found;
+	int			i;
+	ListCell   *lc;
+
+	if (stamp == NULL || !SharedPlanCacheEnabled())
+		return;
+
+	Assert(stamp->counterno == NULL);
+
+	/*
+	 * Collect the counters the plan depends on, checking that the plan is
+	 * fit to be shared as we go.
+	 */
+	seen = (bool *) palloc0(SPC_NUM_COUNTERS * sizeof(bool));
+	counterno = (uint32 *) palloc(SPC_NUM_COUNTERS * sizeof(uint32));
+	foreach(lc, stmt_list)
+	{
+		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc);
+		ListCell   *lc2;
+
+		if (plannedstmt->commandType == CMD_UTILITY ||
+			plannedstmt->transientPlan ||
+			plannedstmt->dependsOnRole)
+			return;
+
+		foreach(lc2, plannedstmt->relationOids)
+		{
+			Oid			relid = lfirst_oid(lc2);
+			uint32		c = RelCounter(relid);
+
+			if (get_rel_persistence(relid) == RELPERSISTENCE_TEMP)
+				return;
+			if (!seen[c])
+			{
+				seen[c] = true;
+				counterno[ncounters++] = c;
+			}
+		}
+
+		foreach(lc2, plannedstmt->invalItems)
+		{
+			PlanInvalItem *item = (PlanInvalItem *) lfirst(lc2);
+			uint32		c = ObjectCounter(item->cacheId, item->hashValue);
+
+			if (!seen[c])
+			{
+				seen[c] = true;
+				counterno[ncounters++] = c;
+			}
+		}
+	}
+
+	/* Don't bother if something the plan depends on changed meanwhile */
+	if (pg_atomic_read_u64(&SharedPlanCache->global_counter) !=
+		stamp->global_counter)
+		return;
+	for (i = 0; i < ncounters; i++)
+	{
+		if (pg_atomic_read_u64(&SharedPlanCache->counters[counterno[i]]) !=
+			stamp->values[counterno[i]])
+			return;
+	}
+
+	plan = nodeToString(stmt_list);
+	planlen = strlen(plan);
+	total = ncounters * (sizeof(uint64) + sizeof(uint32)) +
+		keylen + 1 + planlen + 1;
+
+	/* Don't let a single huge plan flush the whole cache */
+	if (total > SharedPlanCache->area_size / 4)
+		return;
+
+	SharedPlanCacheAttach();
+	hash = DatumGetUInt64(hash_any_extended((const unsigned char *) key,
+											keylen, 0));
+
+	LWLockAcquire(&SharedPlanCache->lock, LW_EXCLUSIVE);
+
+	/* Replace any existing entry; it's stale or for another key */
+	entry = (SharedPlanCacheEntry *) hash_search(SharedPlanHash, &hash,
+												 HASH_FIND, NULL);
+	if (entry != NULL)
+		SharedPlanCacheRemoveEntry(entry);
+
+	while (SharedPlanCache->num_entries >= SharedPlanCache->max_entries)
+	{
+		if (!SharedPlanCacheEvictOne())
+			break;
+	}
+
+	while ((dp = dsa_allocate_extended(SharedPlanArea, total,
+									   DSA_ALLOC_NO_OOM)) == InvalidDsaPointer)
+	{
+		if (!SharedPlanCacheEvictOne())
+		{
+			LWLockRelease(&SharedPlanCache->lock);
+			return;
+		}
+	}
+
+	entry = (SharedPlanCacheEntry *) hash_search(SharedPlanHash, &hash,
+												 HASH_ENTER_NULL, &found);
+	if (entry == NULL)
+	{
+		dsa_free(SharedPlanArea, dp);
+		LWLockRelease(&SharedPlanCache->lock);
+		return;
+	}
+	Assert(!found);
+
+	data = dsa_get_address(SharedPlanArea, dp);
+	for (i = 0; i < ncounters; i++)
+	{
+		memcpy(data, &stamp->values[counterno[i]], sizeof(uint64));
+		data += sizeof(uint64);
+	}
+	memcpy(data, counterno, ncounters * sizeof(uint32));
+	data += ncounters * sizeof(uint32);
+	memcpy(data, key, keylen + 1);
+	data += keylen + 1;
+	memcpy(data, plan, planlen + 1);
+
+	entry->data = dp;
+	entry->global_counter = stamp->global_counter;
+	entry->ncounters = ncounters;
+	entry->keylen = keylen;
+	entry->planlen = planlen;
+	pg_atomic_init_u64(&entry->last_used,
+					   pg_atomic_fetch_add_u64(&SharedPlanCache->clock, 1));
+	SharedPlanCache->num_entries++;
+
+	LWLockRelease(&SharedPlanCache->lock);
+
+	elog(DEBUG2, "stored generic plan in shared plan cache");
+}
+
+/*
+ * Evict one entry, preferring invalidated ones and otherwise choosing the
+ * least recently used.  This is a linear scan, but it only happens when the
+ * cache is full, and planning the query we're about to store cost far more.
+ * Caller must hold the lock exclusively.  Returns false if the cache is
+ * empty.
+ */
+static bool
+SharedPlanCacheEvictOne(void)
+{
+	HASH_SEQ_STATUS status;
+	SharedPlanCacheEntry *entry;
+	SharedPlanCacheEntry *victim = NULL;
+	uint64		oldest = PG_UINT64_MAX;
+
+	hash_seq_init(&status, SharedPlanHash);
+	while ((entry = (SharedPlanCacheEntry *) hash_seq_search(&status)) != NULL)
+	{
+		uint64		last_used;
+
+		if (!SharedPlanCacheEntryIsCurrent(entry))
+		{
+			victim = entry;
+			hash_seq_term(&status);
+			break;
+		}
+
+		last_used = pg_atomic_read_u64(&entry->last_used);
+		if (last_used <= oldest)
+		{
+			victim = entry;
+			oldest = last_used;
+		}
+	}
+
+	if (victim == NULL)
+		return false;
+
+	SharedPlanCacheRemoveEntry(victim);
+	return true;
+}
+
+static void
+SharedPlanCacheRemoveEntry(SharedPlanCacheEntry *entry)
+{
+	dsa_free(SharedPlanArea, entry->data);
+	hash_search(SharedPlanHash, &entry->hash, HASH_REMOVE, NULL);
+	SharedPlanCache->num_entries--;
+}
+
+/*
+ * Invalidation entry points, called from the plancache.c sinval callbacks
+ * in every backend.
+ */
+void
+SharedPlanCacheInvalidateRel(Oid relid)
+{
+	if (!SharedPlanCacheEnabled())
+		return;
+
+	if (relid == InvalidOid)
+		SharedPlanCacheInvalidateAll();
+	else
+	{
+		uint32		c = RelCounter(relid);
+
+		pg_atomic_fetch_add_u64(&SharedPlanCache->counters[c], 1);
+	}
+}
+
+void
+SharedPlanCacheInvalidateObject(int cacheid, uint32 hashvalue)
+{
+	if (!SharedPlanCacheEnabled())
+		return;
+
+	if (hashvalue == 0)
+		SharedPlanCacheInvalidateAll();
+	else
+	{
+		uint32		c = ObjectCounter(cacheid, hashvalue);
+
+		pg_atomic_fetch_add_u64(&SharedPlanCache->counters[c], 1);
+	}
+}
+
+void
+SharedPlanCacheInvalidateAll(void)
+{
+	if (!SharedPlanCacheEnabled())
+		return;
+
+	pg_atomic_fetch_add_u64(&SharedPlanCache->global_counter, 1);
+}
@@ -538,6 +538,32 @@ InitializeMaxBackends(void)
 		elog(ERROR, "too many backends configured");
 }
 
+/*
+ * Initialize the number of fast-path lock groups per backend.
+ *
+ * Enough groups are allocated to hold max_locks_per_transaction relation
+ * locks, rounded up to a power of 2 and capped at
+ * FP_LOCK_GROUPS_PER_BACKEND_MAX.  Installations that raise
+ * max_locks_per_transaction for heavily partitioned schemas thus get a
+ * proportionally larger fast path, too.
+ *
+ * This must be called before shared memory size is determined.  As with
+ * MaxBackends, in EXEC_BACKEND environment the value is passed down from
+ * postmaster to subprocesses via BackendParameters.
+ */
+void
+InitializeFastPathLocks(void)
+{
+	Assert(FastPathLockGroupsPerBackend == 0);
+
+	/* we need at least one group */
+	FastPathLockGroupsPerBackend = 1;
+
+	while (FastPathLockGroupsPerBackend < FP_LOCK_GROUPS_PER_BACKEND_MAX &&
+		   FastPathLockSlotsPerBackend() < max_locks_per_xact)
+		FastPathLockGroupsPerBackend *= 2;
+}
+
 /*
  * Early initialization of a backend (either standalone or under postmaster).
  * This happens even before InitPostgres.
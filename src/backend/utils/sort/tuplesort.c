@@ -96,6 +96,7 @@
 
 #include <limits.h>
 
+#include "access/gin_private.h"
 #include "access/hash.h"
 #include "access/htup_details.h"
 #include "access/nbtree.h"
@@ -450,6 +451,9 @@ struct Tuplesortstate
 	uint32		low_mask;
 	uint32		max_buckets;
 
+	/* These are specific to the index_gin subcase: */
+	GinState   *ginstate;		/* for comparing GIN entry keys */
+
 	/*
 	 * These variables are specific to the Datum case; they are set by
 	 * tuplesort_begin_datum and used only by the DatumTuple routines.
@@ -630,11 +634,15 @@ static int	comparetup_index_btree(const SortTuple *a, const SortTuple *b,
 								   Tuplesortstate *state);
 static int	comparetup_index_hash(const SortTuple *a, const SortTuple *b,
 								  Tuplesortstate *state);
+static int	comparetup_index_gin(const SortTuple *a, const SortTuple *b,
+								 Tuplesortstate *state);
 static void copytup_index(Tuplesortstate *state, SortTuple *stup, void *tup);
 static void writetup_index(Tuplesortstate *state, int tapenum,
 						   SortTuple *stup);
 static void readtup_index(Tuplesortstate *state, SortTuple *stup,
 						  int tapenum, unsigned int len);
+static void readtup_index_gin(Tuplesortstate *state, SortTuple *stup,
+							  int tapenum, unsigned int len);
 static int	comparetup_datum(const SortTuple *a, const SortTuple *b,
 							 Tuplesortstate *state);
 static void copytup_datum(Tuplesortstate *state, SortTuple *stup, void *tup);
@@ -1095,6 +1103,48 @@ tuplesort_begin_index_hash(Relation heapRel,
 	return state;
 }
 
+/*
+ * Sort GIN entry tuples, as formed by the parallel GIN build, by attribute
+ * number and key.  The tuples' posting lists are not considered.
+ */
+Tuplesortstate *
+tuplesort_begin_index_gin(Relation heapRel,
+						  Relation indexRel,
+						  int workMem,
+						  SortCoordinate coordinate,
+						  bool randomAccess)
+{
+	Tuplesortstate *state = tuplesort_begin_common(workMem, coordinate,
+												   randomAccess);
+	MemoryContext oldcontext;
+
+	oldcontext = MemoryContextSwitchTo(state->sortcontext);
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+		elog(LOG,
+			 "begin index sort: workMem = %d, randomAccess = %c",
+			 workMem, randomAccess ? 't' : 'f');
+#endif
+
+	state->nKeys = IndexRelationGetNumberOfKeyAttributes(indexRel);
+
+	state->comparetup = comparetup_index_gin;
+	state->copytup = copytup_index;
+	state->writetup = writetup_index;
+	state->readtup = readtup_index_gin;
+
+	state->heapRel = heapRel;
+	state->indexRel = indexRel;
+
+	state->ginstate = (GinState *) palloc(sizeof(GinState));
+	initGinState(state->ginstate, indexRel);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return state;
+}
+
 Tuplesortstate *
 tuplesort_begin_datum(Oid datumType, Oid sortOperator, Oid sortCollation,
 					  bool nullsFirstFlag, int workMem,
@@ -1546,6 +1596,32 @@ tuplesort_putindextuplevalues(Tuplesortstate *state, Relation rel,
 	MemoryContextSwitchTo(oldcontext);
 }
 
+/*
+ * Collect one GIN entry tuple while collecting input data for sort.  The
+ * tuple is copied.
+ */
+void
+tuplesort_putgintuple(Tuplesortstate *state, IndexTuple tuple)
+{
+	MemoryContext oldcontext = MemoryContextSwitchTo(state->tuplecontext);
+	SortTuple	stup;
+	Size		tuplen = IndexTupleSize(tuple);
+
+	stup.tuple = palloc(tuplen);
+	memcpy(stup.tuple, tuple, tuplen);
+	USEMEM(state, GetMemoryChunkSpace(stup.tuple));
+
+	/* comparetup_index_gin looks at the whole tuple */
+	stup.datum1 = (Datum) 0;
+	stup.isnull1 = false;
+
+	MemoryContextSwitchTo(state->sortcontext);
+
+	puttuple_common(state, &stup);
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
 /*
  * Accept one Datum while collecting input data for sort.
  *
@@ -4138,6 +4214,30 @@ comparetup_index_hash(const SortTuple *a, const SortTuple *b,
 	return 0;
 }
 
+static int
+comparetup_index_gin(const SortTuple *a, const SortTuple *b,
+					 Tuplesortstate *state)
+{
+	GinState   *ginstate = state->ginstate;
+	IndexTuple	tuple1 = (IndexTuple) a->tuple;
+	IndexTuple	tuple2 = (IndexTuple) b->tuple;
+	OffsetNumber attnum1;
+	OffsetNumber attnum2;
+	Datum		key1;
+	Datum		key2;
+	GinNullCategory category1;
+	GinNullCategory category2;
+
+	attnum1 = gintuple_get_attrnum(ginstate, tuple1);
+	attnum2 = gintuple_get_attrnum(ginstate, tuple2);
+	key1 = gintuple_get_key(ginstate, tuple1, &category1);
+	key2 = gintuple_get_key(ginstate, tuple2, &category2);
+
+	return ginCompareAttEntries(ginstate,
+								attnum1, key1, category1,
+								attnum2, key2, category2);
+}
+
 static void
 copytup_index(Tuplesortstate *state, SortTuple *stup, void *tup)
 {
@@ -4246,6 +4346,24 @@ readtup_index(Tuplesortstate *state, SortTuple *stup,
 								 &stup->isnull1);
 }
 
+static void
+readtup_index_gin(Tuplesortstate *state, SortTuple *stup,
+				  int tapenum, unsigned int len)
+{
+	unsigned int tuplen = len - sizeof(unsigned int);
+	IndexTuple	tuple = (IndexTuple) readtup_alloc(state, tuplen);
+
+	LogicalTapeReadExact(state->tapeset, tapenum,
+						 tuple, tuplen);
+	if (state->randomAccess)	/* need trailing length word? */
+		LogicalTapeReadExact(state->tapeset, tapenum,
+							 &tuplen, sizeof(tuplen));
+	stup->tuple = (void *) tuple;
+	/* comparetup_index_gin looks at the whole tuple */
+	stup->datum1 = (Datum) 0;
+	stup->isnull1 = false;
+}
+
 /*
  * Routines specialized for DatumTuple case
  */
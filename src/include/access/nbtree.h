@@ -626,6 +626,47 @@ typedef struct BTArrayKeyInfo
 	Datum	   *elem_values;	/* array of num_elems Datums */
 } BTArrayKeyInfo;
 
+/* What the implicit key on the first column of a skip scan currently is */
+typedef enum BTSkipMode
+{
+	BTSKIP_START,				/* scan not started, no value yet */
+	BTSKIP_PREFIX,				/* "= value" (or IS NULL) */
+	BTSKIP_REST					/* ">= value" in restDir, no more skipping */
+} BTSkipMode;
+
+/*
+ * Skip scan state.  A skip scan is used for scans without any keys on the
+ * first index column; it runs one primitive index scan per distinct value
+ * of the first column, with an implicit "=" key added for that value.
+ */
+typedef struct BTSkipKeyInfo
+{
+	/* operators of the first column's opfamily, indexed by strategy - 1 */
+	ScanKeyData opKeys[BTMaxStrategyNumber];
+	int16		attlen;			/* storage of the first index column */
+	bool		attbyval;
+
+	/* input keys: the implicit key, followed by a copy of scan->keyData */
+	ScanKey		keyData;
+	int			numKeys;		/* number of keyData entries in use */
+
+	/* current value of the first column */
+	BTSkipMode	mode;
+	Datum		value;
+	bool		isnull;
+	ScanDirection restDir;		/* scan direction of BTSKIP_REST */
+
+	/* statistics for deciding when to stop skipping */
+	int			numPrefixes;	/* values found by probing */
+	int			numDense;		/* ... that shared a leaf page with the next */
+
+	/* state at the marked position */
+	BTSkipMode	markMode;
+	Datum		markValue;
+	bool		markIsNull;
+	ScanDirection markRestDir;
+} BTSkipKeyInfo;
+
 typedef struct BTScanOpaqueData
 {
 	/* these fields are set by _bt_preprocess_keys(): */
@@ -642,6 +683,10 @@ typedef struct BTScanOpaqueData
 	BTArrayKeyInfo *arrayKeys;	/* info about each equality-type array key */
 	MemoryContext arrayContext; /* scan-lifespan context for array data */
 
+	/* workspace for skip scans (skipKey is NULL if not skipping) */
+	BTSkipKeyInfo *skipKey;
+	MemoryContext skipContext;	/* scan-lifespan context for skip data */
+
 	/* info about killed items if any (killedItems is NULL if never used) */
 	int		   *killedItems;	/* currPos.items indexes of killed items */
 	int			numKilled;		/* number of currently stored items */
@@ -790,6 +835,11 @@ extern void _bt_start_array_keys(IndexScanDesc scan, ScanDirection dir);
 extern bool _bt_advance_array_keys(IndexScanDesc scan, ScanDirection dir);
 extern void _bt_mark_array_keys(IndexScanDesc scan);
 extern void _bt_restore_array_keys(IndexScanDesc scan);
+extern void _bt_preprocess_skip_key(IndexScanDesc scan);
+extern void _bt_start_skip_key(IndexScanDesc scan);
+extern bool _bt_advance_skip_key(IndexScanDesc scan, ScanDirection dir);
+extern void _bt_mark_skip_key(IndexScanDesc scan);
+extern void _bt_restore_skip_key(IndexScanDesc scan);
 extern void _bt_preprocess_keys(IndexScanDesc scan);
 extern bool _bt_checkkeys(IndexScanDesc scan, IndexTuple tuple,
 						  int tupnatts, ScanDirection dir, bool *continuescan);
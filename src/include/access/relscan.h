@@ -136,6 +136,9 @@ typedef struct IndexScanDescData
 
 	bool		xs_recheck;		/* T means scan keys must be rechecked */
 
+	/* read-ahead of TIDs for heap prefetching, see index_set_prefetch() */
+	struct IndexPrefetchData *xs_prefetch;
+
 	/*
 	 * When fetching with an ordering operator, the values of the ORDER BY
 	 * expressions of the last returned tuple, according to the index.  If
@@ -182,6 +182,15 @@ typedef struct VariableCacheData
 	TransactionId latestCompletedXid;	/* newest XID that has committed or
 										 * aborted */
 
+	/*
+	 * Number of transactions with an XID that have completed (committed or
+	 * aborted), or subtransactions aborted, since server start.  Any change
+	 * in the set of XIDs considered running by GetSnapshotData() bumps this,
+	 * so it can be used to tell whether a previously computed snapshot is
+	 * still current.  Starts at 1; 0 means "unknown" in a snapshot.
+	 */
+	uint64		xactCompletionCount;
+
 	/*
 	 * These fields are protected by CLogTruncationLock
 	 */
@@ -259,6 +259,9 @@ struct XLogRecData;
 extern XLogRecPtr XLogInsertRecord(struct XLogRecData *rdata,
 								   XLogRecPtr fpw_lsn,
 								   uint8 flags);
+extern XLogRecPtr XLogInsertRecordBatch(struct XLogRecData *rdatas,
+										int nrecords, XLogRecPtr fpw_lsn,
+										uint8 flags, XLogRecPtr *EndPos);
 extern void XLogFlush(XLogRecPtr RecPtr);
 extern bool XLogBackgroundFlush(void);
 extern bool XLogNeedsFlush(XLogRecPtr RecPtr);
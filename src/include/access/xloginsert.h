@@ -52,6 +52,11 @@ extern void XLogRegisterBufData(uint8 block_id, char *data, int len);
 extern void XLogResetInsertion(void);
 extern bool XLogCheckBufferNeedsBackup(Buffer buffer);
 
+extern void XLogBeginBatch(int max_records, int max_blocks, Size max_data);
+extern int	XLogBatchAdd(RmgrId rmid, uint8 info);
+extern XLogRecPtr XLogInsertBatch(void);
+extern XLogRecPtr XLogBatchRecordEnd(int recno);
+
 extern XLogRecPtr log_newpage(RelFileNode *rnode, ForkNumber forkNum,
 							  BlockNumber blk, char *page, bool page_std);
 extern XLogRecPtr log_newpage_buffer(Buffer buffer, bool page_std);
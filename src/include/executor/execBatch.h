@@ -0,0 +1,71 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatch.h
+ *	  Support for batch-at-a-time qual evaluation in scan nodes.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/executor/execBatch.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef EXECBATCH_H
+#define EXECBATCH_H
+
+#include "nodes/execnodes.h"
+
+/* GUC: maximum number of tuples in a batch, 0 disables batch execution */
+extern PGDLLIMPORT int executor_batch_size;
+
+/*
+ * A batch of tuples fetched from a scan, together with a selection vector
+ * holding the indexes of the tuples that passed the batch quals so far.
+ *
+ * The tuples may keep buffers pinned, so scans end a batch when they move on
+ * to another page.  The tuple that was fetched from the next page is then
+ * held over in slots[ntuples], to start the next batch.
+ *
+ * Table AMs may return tuples that point into scan-private state, which the
+ * next fetch overwrites, so scans fetch into fetchslot and copy each tuple
+ * into its own slot of the batch.
+ */
+typedef struct TupleBatch
+{
+	int			capacity;		/* allocated length of the arrays below */
+	int			ntuples;		/* number of valid entries in slots[] */
+	TupleTableSlot **slots;		/* fetched tuples */
+	TupleTableSlot *fetchslot;	/* slot the scan fetches into */
+	bool		held;			/* is a tuple held over in slots[ntuples]? */
+	int			nselected;		/* number of valid entries in selection[] */
+	int			next;			/* next entry of selection[] to return */
+	int		   *selection;		/* indexes of qualifying tuples in slots[] */
+
+	/* workspace holding one column of the selected tuples */
+	int64	   *intvalues;
+	float8	   *floatvalues;
+} TupleBatch;
+
+/* Opaque representation of the batch-evaluable part of a qual */
+typedef struct BatchQual BatchQual;
+
+extern BatchQual *ExecInitBatchQual(List *qual, List **residual);
+extern TupleBatch *ExecInitTupleBatch(Relation rel, int capacity);
+extern void ExecResetTupleBatch(TupleBatch *batch);
+extern void ExecAdvanceTupleBatch(TupleBatch *batch);
+extern void ExecDropTupleBatch(TupleBatch *batch);
+extern void ExecBatchQual(BatchQual *bqual, TupleBatch *batch);
+
+/*
+ * Return the next tuple of the batch that passed the batch quals, or NULL
+ * if all of them have been returned.
+ */
+static inline TupleTableSlot *
+ExecBatchNextSelected(TupleBatch *batch)
+{
+	if (batch->next >= batch->nselected)
+		return NULL;
+	return batch->slots[batch->selection[batch->next++]];
+}
+
+#endif							/* EXECBATCH_H */
@@ -14,6 +14,7 @@
 #ifndef HASHJOIN_H
 #define HASHJOIN_H
 
+#include "lib/bloomfilter.h"
 #include "nodes/execnodes.h"
 #include "port/atomics.h"
 #include "storage/barrier.h"
@@ -359,4 +360,34 @@ typedef struct HashJoinTableData
 	dsa_pointer current_chunk_shared;
 }			HashJoinTableData;
 
+/*
+ * Runtime filter pushed down from a hash join into the scans below its outer
+ * side.
+ *
+ * While building a private hash table, the Hash node also adds the hash value
+ * of each inner tuple to a Bloom filter.  A sequential scan that produces the
+ * join's outer input computes the hash value of each tuple it fetches, just
+ * as the join would, and discards the tuples whose hash value is not in the
+ * filter, since they cannot have a join partner.  That saves passing them up
+ * through the rest of the scan and the join.  The filter is only used for
+ * joins that discard unmatched outer tuples.
+ *
+ * If the filter turns out to reject too few of the first tuples probed, it
+ * disables itself, so that an unselective join doesn't pay for it.
+ */
+typedef struct HashRuntimeFilter
+{
+	/* hash table the filter belongs to; NULL until it has been built */
+	HashJoinTable hashtable;
+	bloom_filter *bloom;		/* hash values of all inner tuples */
+	bool		disabled;		/* too unselective to be worth probing? */
+	int64		nprobed;		/* number of tuples probed so far */
+	int64		nrejected;		/* number of those that were rejected */
+} HashRuntimeFilter;
+
+/* number of probes after which we decide whether the filter is useful */
+#define HJ_RUNTIME_FILTER_SAMPLE	4096
+/* ... and the fraction of them it must reject to stay enabled */
+#define HJ_RUNTIME_FILTER_MIN_REJECTED	0.1
+
 #endif							/* HASHJOIN_H */
@@ -49,6 +49,10 @@ extern bool ExecHashGetHashValue(HashJoinTable hashtable,
 								 bool outer_tuple,
 								 bool keep_nulls,
 								 uint32 *hashvalue);
+extern bool ExecHashRuntimeFilterRejects(struct HashRuntimeFilter *filter,
+										 ExprContext *econtext,
+										 List *keys,
+										 TupleTableSlot *slot);
 extern void ExecHashGetBucketAndBatch(HashJoinTable hashtable,
 									  uint32 hashvalue,
 									  int *bucketno,
@@ -22,6 +22,7 @@
 #define PGJIT_INLINE   (1 << 2)
 #define PGJIT_EXPR	   (1 << 3)
 #define PGJIT_DEFORM   (1 << 4)
+#define PGJIT_SCAN	   (1 << 5)
 
 
 typedef struct JitInstrumentation
@@ -40,6 +41,9 @@ typedef struct JitInstrumentation
 
 	/* accumulated time for code emission */
 	instr_time	emission_counter;
+
+	/* number of modules found in the code cache, rather than emitted */
+	size_t		cache_hits;
 } JitInstrumentation;
 
 /*
@@ -69,12 +73,18 @@ typedef void (*JitProviderResetAfterErrorCB) (void);
 typedef void (*JitProviderReleaseContextCB) (JitContext *context);
 struct ExprState;
 typedef bool (*JitProviderCompileExprCB) (struct ExprState *state);
+struct ScanState;
+struct TupleTableSlot;
+typedef struct TupleTableSlot *(*JitScanAccessMtd) (struct ScanState *node);
+typedef bool (*JitProviderCompileScanCB) (struct ScanState *node,
+										  JitScanAccessMtd accessMtd);
 
 struct JitProviderCallbacks
 {
 	JitProviderResetAfterErrorCB reset_after_error;
 	JitProviderReleaseContextCB release_context;
 	JitProviderCompileExprCB compile_expr;
+	JitProviderCompileScanCB compile_scan;	/* optional, may be NULL */
 };
 
 
@@ -86,6 +96,8 @@ extern bool jit_dump_bitcode;
 extern bool jit_expressions;
 extern bool jit_profiling_support;
 extern bool jit_tuple_deforming;
+extern bool jit_scans;
+extern int	jit_cache_entries;
 extern double jit_above_cost;
 extern double jit_inline_above_cost;
 extern double jit_optimize_above_cost;
@@ -99,6 +111,8 @@ extern void jit_release_context(JitContext *context);
  * not be able to perform JIT (i.e. return false).
  */
 extern bool jit_compile_expr(struct ExprState *state);
+extern bool jit_compile_scan(struct ScanState *node,
+							 JitScanAccessMtd accessMtd);
 extern void InstrJitAgg(JitInstrumentation *dst, JitInstrumentation *add);
 
 
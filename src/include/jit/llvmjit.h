@@ -55,8 +55,23 @@ typedef struct LLVMJitContext
 
 	/* list of handles for code emitted via Orc */
 	List	   *handles;
+
+	/* list of LLVMJitCacheRefs for modules found in the code cache */
+	List	   *cache_refs;
 } LLVMJitContext;
 
+/*
+ * Table of pointers that code generated for caching loads at runtime,
+ * instead of embedding them as constants. See l_data_ptr().
+ */
+typedef struct LLVMJitDataRefs
+{
+	void	  **ptrs;			/* pointers referenced so far */
+	int			nptrs;
+	int			maxptrs;
+	LLVMValueRef v_ptrs;		/* the table, in the generated function */
+} LLVMJitDataRefs;
+
 
 /* type and struct definitions */
 extern LLVMTypeRef TypeParamBool;
@@ -89,6 +104,8 @@ extern LLVMValueRef FuncExecEvalSubscriptingRef;
 extern LLVMValueRef FuncExecEvalSysVar;
 extern LLVMValueRef FuncExecAggTransReparent;
 extern LLVMValueRef FuncExecAggInitGroup;
+extern LLVMValueRef FuncMemoryContextReset;
+extern LLVMValueRef FuncProcessInterrupts;
 
 
 extern void llvm_enter_fatal_on_oom(void);
@@ -116,6 +133,10 @@ extern void llvm_inline(LLVMModuleRef mod);
  ****************************************************************************
  */
 extern bool llvm_compile_expr(struct ExprState *state);
+extern const char *llvm_compiled_expr_funcname(LLVMJitContext *context,
+											   struct ExprState *state);
+extern bool llvm_compile_scan(struct ScanState *node,
+							  JitScanAccessMtd accessMtd);
 struct TupleTableSlotOps;
 extern LLVMValueRef slot_compile_deform(struct LLVMJitContext *context, TupleDesc desc,
 										const struct TupleTableSlotOps *ops, int natts);
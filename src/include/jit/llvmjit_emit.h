@@ -126,6 +126,52 @@ l_load_gep1(LLVMBuilderRef b, LLVMValueRef v, LLVMValueRef idx, const char *name
 	return LLVMBuildLoad(b, v_ptr, name);
 }
 
+/*
+ * Emit a reference to execution-time data at ptr.
+ *
+ * Without a data reference table this is the same as l_ptr_const().
+ * Otherwise ptr is recorded in the table, and the generated code loads it
+ * from refs->v_ptrs at runtime. That keeps the emitted code free of
+ * addresses that differ between executions, so it can be reused.
+ */
+static inline LLVMValueRef
+l_data_ptr(LLVMBuilderRef b, LLVMJitDataRefs *refs, void *ptr,
+		   LLVMTypeRef type)
+{
+	LLVMValueRef v_ptr;
+	int			i;
+
+	if (refs == NULL)
+		return l_ptr_const(ptr, type);
+
+	for (i = 0; i < refs->nptrs; i++)
+	{
+		if (refs->ptrs[i] == ptr)
+			break;
+	}
+
+	if (i == refs->nptrs)
+	{
+		if (refs->nptrs == refs->maxptrs)
+		{
+			refs->maxptrs = Max(refs->maxptrs * 2, 16);
+			if (refs->ptrs == NULL)
+				refs->ptrs = palloc(sizeof(void *) * refs->maxptrs);
+			else
+				refs->ptrs = repalloc(refs->ptrs,
+									  sizeof(void *) * refs->maxptrs);
+		}
+		refs->ptrs[refs->nptrs++] = ptr;
+	}
+
+	v_ptr = l_load_gep1(b, refs->v_ptrs, l_int32_const(i), "");
+	/* the table doesn't change while the code runs */
+	LLVMSetMetadata(v_ptr, LLVMGetMDKindID("invariant.load", 14),
+					LLVMMDNode(NULL, 0));
+
+	return LLVMBuildBitCast(b, v_ptr, type, "");
+}
+
 /* separate, because pg_attribute_printf(2, 3) can't appear in definition */
 static inline LLVMBasicBlockRef l_bb_before_v(LLVMBasicBlockRef r, const char *fmt,...) pg_attribute_printf(2, 3);
 
@@ -16,6 +16,7 @@
 
 #include "access/tupconvert.h"
 #include "executor/instrument.h"
+#include "lib/ilist.h"
 #include "lib/pairingheap.h"
 #include "nodes/params.h"
 #include "nodes/plannodes.h"
@@ -94,6 +95,7 @@ typedef struct ExprState
 	Expr	   *expr;
 
 	/* private state for an evalfunc */
+#define FIELDNO_EXPRSTATE_EVALFUNC_PRIVATE 8
 	void	   *evalfunc_private;
 
 	/*
@@ -951,6 +953,8 @@ typedef struct PlanState
 	ExecProcNodeMtd ExecProcNode;	/* function to return next tuple */
 	ExecProcNodeMtd ExecProcNodeReal;	/* actual function, if above is a
 										 * wrapper */
+	void	   *ExecProcNodePrivate;	/* JIT provider's state, if
+										 * ExecProcNode is JIT compiled */
 
 	Instrumentation *instrument;	/* Optional runtime stats for this node */
 	WorkerInstrumentation *worker_instrument;	/* per-worker instrumentation */
@@ -1291,6 +1295,16 @@ typedef struct SeqScanState
 {
 	ScanState	ss;				/* its first field is NodeTag */
 	Size		pscan_len;		/* size of parallel heap scan descriptor */
+
+	/* these fields are used only in batch mode, see execBatch.c */
+	struct BatchQual *bqual;	/* batch-evaluable part of the qual */
+	ExprState  *residual_qual;	/* rest of the qual, or NULL */
+	struct TupleBatch *batch;	/* current batch of tuples */
+	bool		batch_done;		/* no more tuples to fetch into batches */
+
+	/* runtime filter pushed down from a hash join, see hashjoin.h */
+	struct HashRuntimeFilter *rtfilter;
+	List	   *rtfilter_keys;	/* list of ExprState nodes */
 } SeqScanState;
 
 /* ----------------
@@ -1360,6 +1374,7 @@ typedef struct
  *		OrderByTypByVals   is the datatype of order by expression pass-by-value?
  *		OrderByTypLens	   typlens of the datatypes of order by expressions
  *		PscanLen		   size of parallel index scan descriptor
+ *		PrefetchMaximum	   read-ahead distance for heap prefetching, or 0
  * ----------------
  */
 typedef struct IndexScanState
@@ -1387,6 +1402,7 @@ typedef struct IndexScanState
 	bool	   *iss_OrderByTypByVals;
 	int16	   *iss_OrderByTypLens;
 	Size		iss_PscanLen;
+	int			iss_PrefetchMaximum;
 } IndexScanState;
 
 /* ----------------
@@ -1790,6 +1806,19 @@ typedef struct JoinState
  *		NeedNewOuter	   true if need new outer tuple on next call
  *		MatchedOuter	   true if found a join match for current outer tuple
  *		NullInnerTupleSlot prepared null tuple for left outer joins
+ *		OuterRows		   outer tuples fetched since the last rescan
+ *		HashTried		   true if we considered hashing the inner side
+ *		Hashed			   true if inner tuples come from HashTable
+ *		HashSwitches	   number of scans in which we started hashing
+ *		HashSwitchRow	   outer rows processed before we last started hashing
+ *		HashAbandoned	   true if building HashTable exceeded work_mem
+ *		HashTable		   hash table of materialized inner tuples
+ *		HashContext		   memory context holding HashTable and its buckets
+ *		HashTupleContext   child of HashContext holding the inner tuples
+ *		OuterKeyProj	   computes the hash key of an outer tuple
+ *		InnerKeyProj	   computes the hash key of an inner tuple
+ *		HashInnerSlot	   slot holding the current inner tuple when hashed
+ *		HashNext		   next candidate inner tuple for the outer tuple
  * ----------------
  */
 typedef struct NestLoopState
@@ -1798,6 +1827,19 @@ typedef struct NestLoopState
 	bool		nl_NeedNewOuter;
 	bool		nl_MatchedOuter;
 	TupleTableSlot *nl_NullInnerTupleSlot;
+	uint64		nl_OuterRows;
+	bool		nl_HashTried;
+	bool		nl_Hashed;
+	uint64		nl_HashSwitches;
+	uint64		nl_HashSwitchRow;
+	bool		nl_HashAbandoned;
+	TupleHashTable nl_HashTable;
+	MemoryContext nl_HashContext;
+	MemoryContext nl_HashTupleContext;
+	ProjectionInfo *nl_OuterKeyProj;
+	ProjectionInfo *nl_InnerKeyProj;
+	TupleTableSlot *nl_HashInnerSlot;
+	ListCell   *nl_HashNext;
 } NestLoopState;
 
 /* ----------------
@@ -1856,6 +1898,8 @@ typedef struct MergeJoinState
  *		hj_HashOperators		the join operators in the hashjoin condition
  *		hj_HashTable			hash table for the hashjoin
  *								(NULL if table not built yet)
+ *		hj_RuntimeFilter		filter pushed down into the outer side,
+ *								or NULL if none
  *		hj_CurHashValue			hash value for current outer tuple
  *		hj_CurBucketNo			regular bucket# for current outer tuple
  *		hj_CurSkewBucketNo		skew bucket# for current outer tuple
@@ -1887,6 +1931,7 @@ typedef struct HashJoinState
 	List	   *hj_HashOperators;	/* list of operator OIDs */
 	List	   *hj_Collations;
 	HashJoinTable hj_HashTable;
+	struct HashRuntimeFilter *hj_RuntimeFilter;
 	uint32		hj_CurHashValue;
 	int			hj_CurBucketNo;
 	int			hj_CurSkewBucketNo;
@@ -1924,6 +1969,71 @@ typedef struct MaterialState
 	Tuplestorestate *tuplestorestate;
 } MaterialState;
 
+struct MemoizeEntry;
+struct MemoizeTuple;
+struct MemoizeKey;
+
+/* ----------------
+ *	 MemoizeInstrumentation information
+ *
+ *		Statistics about a Memoize node's cache, shown by EXPLAIN ANALYZE.
+ * ----------------
+ */
+typedef struct MemoizeInstrumentation
+{
+	uint64		cache_hits;		/* number of rescans where we've found the
+								 * scan parameter values to be cached */
+	uint64		cache_misses;	/* number of rescans where we've not found the
+								 * scan parameter values to be cached. */
+	uint64		cache_evictions;	/* number of cache entries removed due to
+									 * the need to free memory */
+	uint64		cache_overflows;	/* number of times we've had to bypass the
+									 * cache when filling it due to not being
+									 * able to free enough space to store the
+									 * current scan's tuples. */
+	uint64		mem_peak;		/* peak memory usage in bytes */
+} MemoizeInstrumentation;
+
+/* ----------------
+ *	 MemoizeState information
+ *
+ *		memoize nodes are used to cache recent and commonly seen results from
+ *		a parameterized scan.
+ * ----------------
+ */
+typedef struct MemoizeState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	int			mstatus;		/* value of ExecMemoize state machine */
+	int			nkeys;			/* number of cache keys */
+	struct memoize_hash *hashtable; /* hash table for cache entries */
+	TupleDesc	hashkeydesc;	/* tuple descriptor for cache keys */
+	TupleTableSlot *tableslot;	/* min tuple slot for existing cache entries */
+	TupleTableSlot *probeslot;	/* virtual slot used for hash lookups */
+	ExprState  *cache_eq_expr;	/* Compare exec params to hash key */
+	ExprState **param_exprs;	/* exprs containing the parameters to this
+								 * node */
+	FmgrInfo   *hashfunctions;	/* lookup data for hash funcs nkeys in size */
+	Oid		   *collations;		/* collation for comparisons nkeys in size */
+	uint64		mem_used;		/* bytes of memory used by cache */
+	uint64		mem_limit;		/* memory limit in bytes for the cache */
+	MemoryContext tableContext; /* memory context to store cache data */
+	dlist_head	lru_list;		/* least recently used entry list */
+	struct MemoizeTuple *last_tuple;	/* Used to point to the last tuple
+										 * returned during a cache hit and the
+										 * tuple we last stored when
+										 * populating the cache. */
+	struct MemoizeEntry *entry; /* the entry that 'last_tuple' belongs to or
+								 * NULL if 'last_tuple' is NULL. */
+	bool		singlerow;		/* true if the cache entry is to be marked as
+								 * complete after caching the first tuple. */
+	bool		binary_mode;	/* true when cache key should be compared bit
+								 * by bit, false when using hash equality ops */
+	Bitmapset  *keyparamids;	/* Param->paramids of expressions belonging to
+								 * param_exprs */
+	MemoizeInstrumentation stats;	/* execution statistics */
+} MemoizeState;
+
 /* ----------------
  *	 Shared memory container for per-worker sort information
  * ----------------
@@ -1952,6 +2062,43 @@ typedef struct SortState
 	SharedSortInfo *shared_info;	/* one entry per worker */
 } SortState;
 
+/* ----------------
+ *	 Instrumentation information for IncrementalSort
+ * ----------------
+ */
+typedef struct IncrementalSortInfo
+{
+	int64		groupCount;		/* number of sorted batches */
+	bits32		sortMethods;	/* bitmask of (1 << TuplesortMethod) used */
+	long		maxMemorySpaceUsed; /* in kB */
+	long		totalMemorySpaceUsed;
+	long		maxDiskSpaceUsed;
+	long		totalDiskSpaceUsed;
+} IncrementalSortInfo;
+
+/* ----------------
+ *	 IncrementalSortState information
+ *
+ *	The input is consumed in batches of tuples sharing the same values of the
+ *	presorted columns (a batch always holds at least a minimum number of
+ *	tuples, so it may span several such groups).  Each batch is fully sorted
+ *	and returned before the next one is read.
+ * ----------------
+ */
+typedef struct IncrementalSortState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	bool		bounded;		/* is the result set bounded? */
+	int64		bound;			/* if bounded, how many tuples are needed */
+	int64		bound_Done;		/* tuples already returned */
+	bool		outerNodeDone;	/* finished fetching tuples from outer node */
+	ExprState  *presortedEq;	/* compares presorted columns of two slots */
+	void	   *tuplesortstate; /* private state of tuplesort.c */
+	TupleTableSlot *group_pivot;	/* last tuple of the current batch */
+	TupleTableSlot *transfer_tuple; /* first tuple of the next batch */
+	IncrementalSortInfo incsort_info;	/* instrumentation */
+} IncrementalSortState;
+
 /* ---------------------
  *	GroupState information
  * ---------------------
@@ -2032,6 +2179,22 @@ typedef struct AggState
 	AggStatePerGroup *all_pergroups;	/* array of first ->pergroups, than
 										 * ->hash_pergroup */
 	ProjectionInfo *combinedproj;	/* projection machinery */
+
+	/* these fields are used to spill hash aggregation to disk: */
+	MemoryContext hash_metacxt; /* memory for hash table itself */
+	struct HashAggSpill *hash_spills;	/* HashAggSpill for each grouping set,
+										 * exists only during first pass */
+	TupleTableSlot *hash_spill_slot;	/* for reading spill files */
+	List	   *hash_batches;	/* hash batches remaining to be processed */
+	bool		hash_ever_spilled;	/* ever spilled during this execution? */
+	bool		hash_spill_mode;	/* we hit the memory limit, don't create
+									 * new groups */
+	Size		hash_mem_limit; /* limit before spilling hash table */
+	Size		hash_mem_peak;	/* peak hash table memory usage */
+	uint64		hash_ngroups_current;	/* number of groups currently in
+										 * memory in all hash tables */
+	uint64		hash_disk_used; /* kB of disk space used */
+	int			hash_batches_used;	/* batches used during entire execution */
 } AggState;
 
 /* ----------------
@@ -2223,6 +2386,7 @@ typedef struct HashState
 	HashJoinTable hashtable;	/* hash table for the hashjoin */
 	List	   *hashkeys;		/* list of ExprState nodes */
 	/* hashkeys is same as parent's hj_InnerHashKeys */
+	struct HashRuntimeFilter *rtfilter; /* filter to build, or NULL */
 
 	SharedHashInfo *shared_info;	/* one entry per worker */
 	HashInstrumentation *hinstrument;	/* this worker's entry */
@@ -691,12 +691,23 @@ typedef struct Join
  * Vars, but perhaps someday that'd be worth relaxing.  (Note: during plan
  * creation, the paramval can actually be a PlaceHolderVar expression; but it
  * must be a Var with varno OUTER_VAR by the time it gets to the executor.)
+ *
+ * If the inner subplan is a Material node that takes no parameters from the
+ * outer side, the hashable equality join clauses are also recorded, split
+ * into outer and inner key expressions.  The executor may use these to build
+ * a hash table over the materialized inner rows when the outer side turns out
+ * to return far more rows than estimated (see adaptive_join_threshold).
  * ----------------
  */
 typedef struct NestLoop
 {
 	Join		join;
 	List	   *nestParams;		/* list of NestLoopParam nodes */
+	int			numHashKeys;	/* size of the arrays below */
+	Oid		   *hashOperators;	/* equality operators for each key */
+	Oid		   *hashCollations; /* collations for each key */
+	List	   *outerHashKeys;	/* outer key expressions */
+	List	   *innerHashKeys;	/* inner key expressions */
 } NestLoop;
 
 typedef struct NestLoopParam
@@ -748,6 +759,31 @@ typedef struct Material
 	Plan		plan;
 } Material;
 
+/* ----------------
+ *		memoize node
+ *
+ * Caches the results of its subplan for each distinct set of values of
+ * param_exprs, so that rescans with the same parameter values can be served
+ * from the cache.
+ * ----------------
+ */
+typedef struct Memoize
+{
+	Plan		plan;
+	int			numKeys;		/* size of the two arrays below */
+	Oid		   *hashOperators;	/* hash operators for each key */
+	Oid		   *collations;		/* collations for each key */
+	List	   *param_exprs;	/* cache keys in the form of exprs containing
+								 * parameters */
+	bool		singlerow;		/* true if the cache entry should be marked
+								 * as complete after we store the first
+								 * tuple in it */
+	bool		binary_mode;	/* true when cache key should be compared bit
+								 * by bit, false when using hash equality ops */
+	uint32		est_entries;	/* the number of entries the planner expects
+								 * will fit in the cache, or 0 if unknown */
+} Memoize;
+
 /* ----------------
  *		sort node
  * ----------------
@@ -762,6 +798,20 @@ typedef struct Sort
 	bool	   *nullsFirst;		/* NULLS FIRST/LAST directions */
 } Sort;
 
+/* ----------------
+ *		incremental sort node
+ *
+ * The input is known to be already sorted by the first nPresortedCols sort
+ * keys, so only the rows within each group of equal prefix values need to
+ * be sorted on the remaining keys.
+ * ----------------
+ */
+typedef struct IncrementalSort
+{
+	Sort		sort;
+	int			nPresortedCols; /* number of presorted columns */
+} IncrementalSort;
+
 /* ---------------
  *	 group node -
  *		Used for queries with GROUP BY (but no aggregates) specified.
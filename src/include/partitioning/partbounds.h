@@ -89,6 +89,14 @@ extern bool partition_bounds_equal(int partnatts, int16 *parttyplen,
 extern PartitionBoundInfo partition_bounds_copy(PartitionBoundInfo src,
 												PartitionKey key);
 extern bool partitions_are_ordered(PartitionBoundInfo boundinfo, int nparts);
+extern PartitionBoundInfo partition_range_bounds_intersect(int partnatts,
+														   FmgrInfo *partsupfunc,
+														   Oid *partcollation,
+														   PartitionBoundInfo outer_bi,
+														   PartitionBoundInfo inner_bi,
+														   int *nparts,
+														   int **outer_parts,
+														   int **inner_parts);
 extern void check_new_partition_bound(char *relname, Relation parent,
 									  PartitionBoundSpec *spec);
 extern void check_default_partition_contents(Relation parent,
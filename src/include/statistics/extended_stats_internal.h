@@ -107,5 +107,10 @@ extern Selectivity mcv_clauselist_selectivity(PlannerInfo *root,
 											  RelOptInfo *rel,
 											  Selectivity *basesel,
 											  Selectivity *totalsel);
+extern Selectivity mcv_join_selectivity(MCVList *mcv1, MCVList *mcv2,
+										int nkeys, int *dims1, int *dims2,
+										FmgrInfo *eqprocs, Oid *collations,
+										double nd1, double nd2,
+										double nullfrac1, double nullfrac2);
 
 #endif							/* EXTENDED_STATS_INTERNAL_H */
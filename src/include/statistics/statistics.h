@@ -115,6 +115,11 @@ extern Selectivity statext_clauselist_selectivity(PlannerInfo *root,
 												  SpecialJoinInfo *sjinfo,
 												  RelOptInfo *rel,
 												  Bitmapset **estimatedclauses);
+extern Selectivity statext_join_clauselist_selectivity(PlannerInfo *root,
+													   List *clauses,
+													   JoinType jointype,
+													   SpecialJoinInfo *sjinfo,
+													   Bitmapset **estimatedclauses);
 extern bool has_stats_of_kind(List *stats, char requiredkind);
 extern StatisticExtInfo *choose_best_statistics(List *stats,
 												Bitmapset *attnums, char requiredkind);
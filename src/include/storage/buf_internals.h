@@ -297,6 +297,44 @@ typedef struct CkptSortItem
 
 extern CkptSortItem *CkptBufferIds;
 
+/*
+ * Bitmap of buffers that may be dirty, one bit per buffer, so that
+ * checkpoints only need to visit the buffers dirtied since the previous one
+ * instead of every buffer descriptor.
+ *
+ * A buffer's bit is set whenever the buffer goes from clean to dirty, before
+ * any WAL record describing the change is inserted.  It is only cleared by
+ * BufferSync(), while holding the buffer header lock and having seen that
+ * BM_DIRTY is not set, so a set BM_DIRTY flag always has its bit set too
+ * (except momentarily in MarkBufferDirty(), which is harmless since no WAL
+ * record for the change exists yet).  Bits of buffers that have been written
+ * out or invalidated stay set until the next checkpoint notices.
+ */
+#define BUFFER_DIRTY_MAP_BITS	32
+
+#define BufferDirtyMapWords() \
+	((NBuffers + BUFFER_DIRTY_MAP_BITS - 1) / BUFFER_DIRTY_MAP_BITS)
+
+extern PGDLLIMPORT pg_atomic_uint32 *BufferDirtyMap;
+
+static inline void
+BufferDirtyMapSet(int buf_id)
+{
+	pg_atomic_uint32 *word = &BufferDirtyMap[buf_id / BUFFER_DIRTY_MAP_BITS];
+	uint32		bit = (uint32) 1 << (buf_id % BUFFER_DIRTY_MAP_BITS);
+
+	/* avoid dirtying the cache line if the bit is still set */
+	if ((pg_atomic_read_u32(word) & bit) == 0)
+		pg_atomic_fetch_or_u32(word, bit);
+}
+
+static inline void
+BufferDirtyMapClear(int buf_id)
+{
+	pg_atomic_fetch_and_u32(&BufferDirtyMap[buf_id / BUFFER_DIRTY_MAP_BITS],
+							~((uint32) 1 << (buf_id % BUFFER_DIRTY_MAP_BITS)));
+}
+
 /*
  * Internal buffer management routines
  */
@@ -21,4 +21,9 @@
  */
 extern uint16 pg_checksum_page(char *page, BlockNumber blkno);
 
+#ifdef USE_AVX2_CHECKSUM_WITH_RUNTIME_CHECK
+/* Partial checksum calculation using AVX2 instructions, see checksum_avx2.c */
+extern void pg_checksum_block_sums_avx2(uint32 *sums, const void *page);
+#endif
+
 #endif							/* CHECKSUM_H */
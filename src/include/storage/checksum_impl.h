@@ -98,6 +98,13 @@
  * to unroll the inner loop to avoid loop overhead and minimize register
  * spilling. For less sophisticated compilers it might be beneficial to
  * manually unroll the inner loop.
+ *
+ * The includer can supply a different implementation of the partial checksum
+ * calculation, e.g. one using explicit vector instructions, by defining
+ * PG_CHECKSUM_BLOCK_SUMS(sums, page) before including this file.  It must
+ * compute the same partial checksums as the loops in pg_checksum_block(),
+ * or return false to have those loops run instead.  The backend uses this
+ * to choose an AVX2 implementation at runtime; see checksum.c.
  */
 
 #include "storage/bufpage.h"
@@ -156,15 +163,20 @@ pg_checksum_block(const PGChecksummablePage *page)
 	/* initialize partial checksums to their corresponding offsets */
 	memcpy(sums, checksumBaseOffsets, sizeof(checksumBaseOffsets));
 
-	/* main checksum calculation */
-	for (i = 0; i < (uint32) (BLCKSZ / (sizeof(uint32) * N_SUMS)); i++)
-		for (j = 0; j < N_SUMS; j++)
-			CHECKSUM_COMP(sums[j], page->data[i][j]);
-
-	/* finally add in two rounds of zeroes for additional mixing */
-	for (i = 0; i < 2; i++)
-		for (j = 0; j < N_SUMS; j++)
-			CHECKSUM_COMP(sums[j], 0);
+#ifdef PG_CHECKSUM_BLOCK_SUMS
+	if (!PG_CHECKSUM_BLOCK_SUMS(sums, page))
+#endif
+	{
+		/* main checksum calculation */
+		for (i = 0; i < (uint32) (BLCKSZ / (sizeof(uint32) * N_SUMS)); i++)
+			for (j = 0; j < N_SUMS; j++)
+				CHECKSUM_COMP(sums[j], page->data[i][j]);
+
+		/* finally add in two rounds of zeroes for additional mixing */
+		for (i = 0; i < 2; i++)
+			for (j = 0; j < N_SUMS; j++)
+				CHECKSUM_COMP(sums[j], 0);
+	}
 
 	/* xor fold partial checksums together */
 	for (i = 0; i < N_SUMS; i++)
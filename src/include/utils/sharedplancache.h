@@ -0,0 +1,41 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedplancache.h
+ *	  Cross-backend cache of generic plans.
+ *
+ * See sharedplancache.c for comments.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/utils/sharedplancache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SHAREDPLANCACHE_H
+#define SHAREDPLANCACHE_H
+
+#include "nodes/pg_list.h"
+
+/* GUC parameter */
+extern int	shared_plan_cache_size;
+
+/* Opaque snapshot of the shared invalidation counters */
+typedef struct SharedPlanCacheStamp SharedPlanCacheStamp;
+
+extern Size SharedPlanCacheShmemSize(void);
+extern void SharedPlanCacheShmemInit(void);
+
+extern char *SharedPlanCacheMakeKey(List *query_list, int cursor_options);
+extern List *SharedPlanCacheLookup(const char *key,
+								   SharedPlanCacheStamp **stamp);
+extern SharedPlanCacheStamp *SharedPlanCacheBeginPlanning(void);
+extern bool SharedPlanCacheStampIsCurrent(SharedPlanCacheStamp *stamp);
+extern void SharedPlanCacheStore(const char *key, List *stmt_list,
+								 SharedPlanCacheStamp *stamp);
+
+extern void SharedPlanCacheInvalidateRel(Oid relid);
+extern void SharedPlanCacheInvalidateObject(int cacheid, uint32 hashvalue);
+extern void SharedPlanCacheInvalidateAll(void);
+
+#endif							/* SHAREDPLANCACHE_H */
@@ -5,7 +5,8 @@
  *
  * On first call, checks if the CPU we're running on supports Intel SSE
  * 4.2. If it does, use the special SSE instructions for CRC-32C
- * computation. Otherwise, fall back to the pure software implementation
+ * computation, and if it also supports PCLMULQDQ, use that too for large
+ * inputs. Otherwise, fall back to the pure software implementation
  * (slicing-by-8).
  *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
@@ -30,8 +31,11 @@
 
 #include "port/pg_crc32c.h"
 
-static bool
-pg_crc32c_sse42_available(void)
+/*
+ * Return the ECX feature flags of cpuid leaf 1.
+ */
+static unsigned int
+pg_crc32c_cpuid_features(void)
 {
 	unsigned int exx[4] = {0, 0, 0, 0};
 
@@ -43,7 +47,7 @@ pg_crc32c_sse42_available(void)
 #error cpuid instruction not available
 #endif
 
-	return (exx[2] & (1 << 20)) != 0;	/* SSE 4.2 */
+	return exx[2];
 }
 
 /*
@@ -53,8 +57,17 @@ pg_crc32c_sse42_available(void)
 static pg_crc32c
 pg_comp_crc32c_choose(pg_crc32c crc, const void *data, size_t len)
 {
-	if (pg_crc32c_sse42_available())
-		pg_comp_crc32c = pg_comp_crc32c_sse42;
+	unsigned int features = pg_crc32c_cpuid_features();
+
+	if ((features & (1 << 20)) != 0)	/* SSE 4.2 */
+	{
+#ifdef USE_PCLMUL_CRC32C_WITH_RUNTIME_CHECK
+		if ((features & (1 << 1)) != 0) /* PCLMULQDQ */
+			pg_comp_crc32c = pg_comp_crc32c_sse42_pclmul;
+		else
+#endif
+			pg_comp_crc32c = pg_comp_crc32c_sse42;
+	}
 	else
 		pg_comp_crc32c = pg_comp_crc32c_sb8;
 
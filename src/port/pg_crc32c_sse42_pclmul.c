@@ -0,0 +1,109 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_crc32c_sse42_pclmul.c
+ *	  Compute CRC-32C checksum using Intel SSE 4.2 and PCLMULQDQ instructions.
+ *
+ * The SSE 4.2 crc32 instruction can only process one 8-byte word at a time,
+ * and each one depends on the result of the previous one.  For large inputs,
+ * we instead fold the data into four 128-bit accumulators with carry-less
+ * multiplications, which proceed independently of each other, and only
+ * reduce the accumulators to a 32-bit CRC at the end.
+ *
+ * The accumulators hold bit-reflected polynomials, like the CRC itself.
+ * Folding a 128-bit accumulator forward by D bits multiplies its high-order
+ * 64 bits (the low quadword) by x^(D+63) mod P, and its low-order 64 bits
+ * (the high quadword) by x^(D-1) mod P; the -1 compensates for the product
+ * of two reflected 64-bit values coming out shifted by one bit.  The
+ * constants below are those values, stored multiplied by x^32 so that they
+ * fit in the low 32 bits of each quadword.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/port/pg_crc32c_sse42_pclmul.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "c.h"
+
+#include "port/pg_crc32c.h"
+
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+
+/*
+ * Inputs shorter than this are not worth setting up the accumulators for;
+ * they're processed by pg_comp_crc32c_sse42() directly.
+ */
+#define PCLMUL_MIN_LENGTH	256
+
+/* Constants for folding by 512, 384, 256 and 128 bits */
+#define FOLD_512	_mm_set_epi32(0, 0x9e4addf8, 0, 0x740eef02)
+#define FOLD_384	_mm_set_epi32(0, 0xddc0152b, 0, 0x1c291d04)
+#define FOLD_256	_mm_set_epi32(0, 0xba4fc28e, 0, 0x3da6d0cb)
+#define FOLD_128	_mm_set_epi32(0, 0x493c7d27, 0, 0xf20c0dfe)
+
+/*
+ * Fold accumulator 'x' forward by the distance that the constants 'k' are
+ * for.
+ */
+static inline __m128i
+fold(__m128i x, __m128i k)
+{
+	return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00),
+						 _mm_clmulepi64_si128(x, k, 0x11));
+}
+
+pg_crc32c
+pg_comp_crc32c_sse42_pclmul(pg_crc32c crc, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+
+	/* The reduction at the end uses 64-bit crc32 instructions */
+#ifdef __x86_64__
+	if (len >= PCLMUL_MIN_LENGTH)
+	{
+		const unsigned char *pend = p + len;
+		__m128i		x0,
+					x1,
+					x2,
+					x3;
+
+		/* Load the first 64 bytes, with the initial CRC mixed into them */
+		x0 = _mm_loadu_si128((const __m128i *) p);
+		x1 = _mm_loadu_si128((const __m128i *) (p + 16));
+		x2 = _mm_loadu_si128((const __m128i *) (p + 32));
+		x3 = _mm_loadu_si128((const __m128i *) (p + 48));
+		x0 = _mm_xor_si128(x0, _mm_cvtsi32_si128(crc));
+		p += 64;
+
+		/* Fold in 64 bytes at a time */
+		while (pend - p >= 64)
+		{
+			x0 = _mm_xor_si128(fold(x0, FOLD_512),
+							   _mm_loadu_si128((const __m128i *) p));
+			x1 = _mm_xor_si128(fold(x1, FOLD_512),
+							   _mm_loadu_si128((const __m128i *) (p + 16)));
+			x2 = _mm_xor_si128(fold(x2, FOLD_512),
+							   _mm_loadu_si128((const __m128i *) (p + 32)));
+			x3 = _mm_xor_si128(fold(x3, FOLD_512),
+							   _mm_loadu_si128((const __m128i *) (p + 48)));
+			p += 64;
+		}
+
+		/* Fold the four accumulators into one */
+		x3 = _mm_xor_si128(x3, fold(x0, FOLD_384));
+		x3 = _mm_xor_si128(x3, fold(x1, FOLD_256));
+		x3 = _mm_xor_si128(x3, fold(x2, FOLD_128));
+
+		/* Reduce it to a CRC, and process the remaining tail as usual */
+		crc = (pg_crc32c) _mm_crc32_u64(0, (uint64) _mm_cvtsi128_si64(x3));
+		crc = (pg_crc32c) _mm_crc32_u64(crc, (uint64) _mm_extract_epi64(x3, 1));
+		len = pend - p;
+	}
+#endif
+
+	return pg_comp_crc32c_sse42(crc, p, len);
+}
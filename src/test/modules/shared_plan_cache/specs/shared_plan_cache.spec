@@ -0,0 +1,71 @@
+# Shared plan cache
+#
+# A generic plan built in one session is published to the shared plan
+# cache and adopted by another session preparing the same statement.
+# Neither session may keep using a plan made stale by DDL on the table or
+# by replacing a function inlined into it, whether the replacement plan is
+# built locally or adopted.  Nor may a plan depending on catalog changes
+# that haven't been committed yet be shared.
+
+setup
+{
+	CREATE TABLE spc_tbl (a int, b int);
+	INSERT INTO spc_tbl SELECT g, g FROM generate_series(1, 1000) g;
+	ANALYZE spc_tbl;
+	CREATE FUNCTION spc_func(int) RETURNS int LANGUAGE sql IMMUTABLE
+		AS 'SELECT $1 + 1';
+}
+
+teardown
+{
+	DROP TABLE spc_tbl;
+	DROP FUNCTION spc_func(int);
+}
+
+session "s1"
+setup
+{
+	SET plan_cache_mode = force_generic_plan;
+	PREPARE q AS SELECT spc_func(b) FROM spc_tbl WHERE a = $1;
+	SET client_min_messages = debug2;
+}
+step "s1_exec" { EXECUTE q(42); }
+step "s1_explain" { EXPLAIN (COSTS OFF) EXECUTE q(42); }
+step "s1_quiet" { RESET client_min_messages; }
+
+session "s2"
+setup
+{
+	SET plan_cache_mode = force_generic_plan;
+	PREPARE q AS SELECT spc_func(b) FROM spc_tbl WHERE a = $1;
+	SET client_min_messages = debug2;
+}
+step "s2_exec" { EXECUTE q(42); }
+step "s2_explain" { EXPLAIN (COSTS OFF) EXECUTE q(42); }
+step "s2_quiet" { RESET client_min_messages; }
+
+session "s3"
+setup
+{
+	SET plan_cache_mode = force_generic_plan;
+	PREPARE q AS SELECT spc_func(b) FROM spc_tbl WHERE a = $1;
+}
+step "s3_begin" { BEGIN; }
+step "s3_index" { CREATE INDEX spc_tbl_a_idx ON spc_tbl (a); }
+step "s3_func"
+{
+	CREATE OR REPLACE FUNCTION spc_func(int) RETURNS int LANGUAGE sql IMMUTABLE
+		AS 'SELECT $1 + 2';
+}
+step "s3_exec" { EXECUTE q(42); }
+step "s3_abort" { ABORT; }
+
+# The debug messages show the plan being published and adopted.  They are
+# turned off afterwards, since which session builds the replacement plans
+# depends on when idle backends get around to processing invalidations.
+permutation "s1_exec" "s2_exec" "s1_quiet" "s2_quiet" "s2_explain" "s3_index" "s1_explain" "s2_explain" "s3_func" "s1_exec" "s2_exec"
+
+# A plan built on top of DDL in an open transaction is not published, so
+# another session doesn't adopt a plan using an index or function body that
+# goes away when that transaction aborts.
+permutation "s3_begin" "s3_index" "s3_func" "s3_exec" "s1_explain" "s1_exec" "s3_abort" "s1_exec"
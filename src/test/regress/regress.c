@@ -23,6 +23,8 @@
 #include "access/transam.h"
 #include "access/tuptoaster.h"
 #include "access/xact.h"
+#include "access/xloginsert.h"
+#include "catalog/pg_control.h"
 #include "catalog/pg_operator.h"
 #include "catalog/pg_type.h"
 #include "commands/sequence.h"
@@ -860,6 +862,26 @@ test_atomic_ops(PG_FUNCTION_ARGS)
 	PG_RETURN_BOOL(true);
 }
 
+/*
+ * Throw an error while a WAL batch is being collected.  Transaction abort
+ * must abandon the batch, so that WAL can be written again afterwards.
+ */
+PG_FUNCTION_INFO_V1(test_wal_batch_error);
+Datum
+test_wal_batch_error(PG_FUNCTION_ARGS)
+{
+	char		dummy = 0;
+
+	XLogBeginBatch(1, 0, sizeof(dummy));
+	XLogBeginInsert();
+	XLogRegisterData(&dummy, sizeof(dummy));
+	(void) XLogBatchAdd(RM_XLOG_ID, XLOG_NOOP);
+
+	elog(ERROR, "error while collecting a WAL batch");
+
+	PG_RETURN_VOID();
+}
+
 PG_FUNCTION_INFO_V1(test_fdw_handler);
 Datum
 test_fdw_handler(PG_FUNCTION_ARGS)
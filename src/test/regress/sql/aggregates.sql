@@ -1017,3 +1017,95 @@ select v||'a', case when v||'a' = 'aa' then 1 else 0 end, count(*)
 explain (costs off)
   select 1 from tenk1
    where (hundred, thousand) in (select twothousand, twothousand from onek);
+
+--
+-- Hash Aggregation Spill tests
+--
+
+-- hide memory and disk usage, which vary across platforms; a Disk Usage
+-- figure is only shown if the hash table spilled
+create function explain_hashagg(query text) returns setof text
+language plpgsql as
+$$
+declare
+    ln text;
+begin
+    for ln in
+        execute format('explain (analyze, costs off, summary off, timing off) %s',
+            query)
+    loop
+        ln := regexp_replace(ln, 'Batches: \d+', 'Batches: N');
+        ln := regexp_replace(ln, 'Memory Usage: \d+', 'Memory Usage: N');
+        ln := regexp_replace(ln, 'Disk Usage: \d+', 'Disk Usage: N');
+        return next ln;
+    end loop;
+end;
+$$;
+
+set work_mem='64kB';
+set enable_sort=false;
+
+explain (costs off)
+select g % 10000 as k, count(*), sum(g)
+  from generate_series(0, 19999) g group by g % 10000;
+
+-- the planner expects 200 groups, but the hash table spills to disk
+select explain_hashagg('
+select g % 10000 as k, count(*), sum(g)
+  from generate_series(0, 19999) g group by g % 10000');
+
+select count(*), sum(c), sum(s)
+  from (select g % 10000 as k, count(*) as c, sum(g) as s
+          from generate_series(0, 19999) g group by g % 10000) t;
+
+-- each hashed grouping set spills separately
+select explain_hashagg('
+select g % 1000 as a, g % 5000 as b, count(*)
+  from generate_series(0, 19999) g
+ group by grouping sets ((g % 1000), (g % 5000))');
+select count(*), sum(c)
+  from (select g % 1000 as a, g % 5000 as b, count(*) as c
+          from generate_series(0, 19999) g
+         group by grouping sets ((g % 1000), (g % 5000))) t;
+
+reset enable_sort;
+reset work_mem;
+drop function explain_hashagg(text);
+
+--
+-- Eager aggregation
+--
+
+create temp table eager_fact (d int, x int);
+create temp table eager_dim (id int, name text);
+insert into eager_fact select g % 10 + 1, g from generate_series(1, 10000) g;
+insert into eager_dim select g, 'dim' || g from generate_series(1, 100) g;
+analyze eager_fact;
+analyze eager_dim;
+
+set enable_eager_aggregate = on;
+set enable_nestloop = off;
+set enable_mergejoin = off;
+set enable_sort = off;
+
+-- aggregate the fact table before joining it to the dimension
+explain (costs off)
+select d.name, sum(f.x), count(*)
+  from eager_fact f join eager_dim d on f.d = d.id
+ group by d.name;
+
+select d.name, sum(f.x), count(*)
+  from eager_fact f join eager_dim d on f.d = d.id
+ group by d.name order by d.name;
+
+-- not possible when an aggregate uses columns of both relations
+explain (costs off)
+select d.name, sum(f.x + d.id)
+  from eager_fact f join eager_dim d on f.d = d.id
+ group by d.name;
+
+reset enable_sort;
+reset enable_mergejoin;
+reset enable_nestloop;
+reset enable_eager_aggregate;
+drop table eager_fact, eager_dim;
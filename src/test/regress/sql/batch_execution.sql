@@ -0,0 +1,52 @@
+--
+-- Batch execution of sequential scan quals
+--
+
+create table batch_tab (i2 int2, i4 int4, i8 int8, f4 float4, f8 float8,
+                        d date, t text);
+insert into batch_tab
+  select g, g, g * 1000000000::int8, g / 4.0, g / 8.0,
+         date '2000-01-01' + g, 'row ' || g
+  from generate_series(1, 1000) g;
+insert into batch_tab values (null, null, null, 'NaN', 'NaN', null, 'nulls');
+
+set executor_batch_size = 64;
+
+-- only scans with batchable quals use batches
+explain (costs off)
+select count(*) from batch_tab where i4 < 100 and t like '%5';
+explain (costs off)
+select count(*) from batch_tab where t like '%5';
+
+-- simple comparisons of each supported type
+select count(*) from batch_tab where i4 < 100;
+select count(*) from batch_tab where 100 > i4;
+select count(*) from batch_tab where i2 >= 990;
+select count(*) from batch_tab where i8 = 5000000000;
+select count(*) from batch_tab where i4 <> 500;
+select count(*) from batch_tab where f8 > 100;
+select count(*) from batch_tab where f4 = 'NaN';
+select count(*) from batch_tab where f4 <= 2.5;
+select count(*) from batch_tab where d < '2000-01-11';
+
+-- each tuple of a batch must keep its own values, not just the last fetched
+select i4, i2, t from batch_tab where i4 >= 12 and i4 <= 20 and i2 <> 15;
+select sum(f8 * 8), sum(i8 / 1000000000) from batch_tab where i4 <= 100;
+
+-- mixed with quals that are evaluated one tuple at a time
+select count(*) from batch_tab where i4 between 10 and 20 and t like '%5';
+select i4, t from batch_tab where i4 > 995;
+select i4 from batch_tab where i4 % 2 = 0 and i4 > 10 limit 3;
+
+-- rescans
+select count(*)
+from (values (10), (20)) v(x),
+     lateral (select * from batch_tab where i4 < 50 and i4 > v.x) s;
+
+-- batches end at page boundaries, however large they're allowed to be
+set executor_batch_size = 1024;
+select count(*), sum(i4) from batch_tab where i4 > 0;
+
+reset executor_batch_size;
+
+drop table batch_tab;
@@ -140,3 +140,107 @@ VACUUM delete_test_table;
 -- The vacuum above should've turned the leaf page into a fast root. We just
 -- need to insert some rows to cause the fast root page to split.
 INSERT INTO delete_test_table SELECT i, 1, 2, 3 FROM generate_series(1,1000) i;
+
+--
+-- Test index scans reading ahead to prefetch heap blocks, if the platform
+-- allows it
+--
+DO $$
+BEGIN
+ SET effective_io_concurrency = 50;
+EXCEPTION WHEN invalid_parameter_value THEN
+END $$;
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+set enable_indexonlyscan = off;
+explain (costs off)
+select count(*), sum(unique1) from tenk1
+  where unique1 < 1000 and stringu1 is not null;
+select count(*), sum(unique1) from tenk1
+  where unique1 < 1000 and stringu1 is not null;
+-- rows must still be returned in index order
+select unique1 from tenk1
+  where unique1 between 4995 and 5004 and stringu1 is not null;
+-- inner side of a nested loop, restarted for each outer row
+set enable_hashjoin = off;
+set enable_mergejoin = off;
+select count(b.stringu1) from tenk1 a join tenk1 b on b.unique1 = a.unique2
+  where a.unique1 < 100;
+-- backward scan
+explain (costs off)
+select unique1 from tenk1
+  where unique1 between 4995 and 5004 and stringu1 is not null
+  order by unique1 desc;
+select unique1 from tenk1
+  where unique1 between 4995 and 5004 and stringu1 is not null
+  order by unique1 desc;
+-- LIMIT stopping the scan early, in both directions
+select unique1 from tenk1
+  where unique1 > 9000 and stringu1 is not null order by unique1 limit 3;
+select unique1 from tenk1
+  where unique1 > 9000 and stringu1 is not null order by unique1 desc limit 3;
+-- rescans with new parameters, each stopped early by LIMIT
+explain (costs off)
+select a.unique1, x.unique1 from tenk1 a,
+  lateral (select b.unique1 from tenk1 b
+           where b.unique1 > a.unique1 * 1000 and b.stringu1 is not null
+           order by b.unique1 limit 2) x
+  where a.unique1 < 3;
+select a.unique1, x.unique1 from tenk1 a,
+  lateral (select b.unique1 from tenk1 b
+           where b.unique1 > a.unique1 * 1000 and b.stringu1 is not null
+           order by b.unique1 limit 2) x
+  where a.unique1 < 3;
+-- a scrollable cursor changing direction doesn't read ahead
+begin;
+declare c scroll cursor for
+  select unique1 from tenk1
+  where unique1 < 10 and stringu1 is not null order by unique1;
+fetch 3 from c;
+fetch backward 2 from c;
+fetch 4 from c;
+close c;
+commit;
+reset enable_seqscan;
+reset enable_bitmapscan;
+reset enable_indexonlyscan;
+reset enable_hashjoin;
+reset enable_mergejoin;
+reset effective_io_concurrency;
+
+--
+-- Test skip scans of indexes without quals on the first column
+--
+create temp table skip_test (a int, b int, c text);
+insert into skip_test select i % 10, i / 10, 'x' from generate_series(0, 9999) i;
+insert into skip_test values (null, 5, 'n'), (null, 6, 'n'), (null, 500, 'n');
+create index skip_test_a_b on skip_test (a, b);
+vacuum analyze skip_test;
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+explain (costs off)
+select a, b from skip_test where b = 5;
+select a, b from skip_test where b = 5;
+-- backward scan, NULLs come first
+select a, b from skip_test where b between 5 and 6 order by a desc, b desc;
+-- bitmap scan
+set enable_bitmapscan = on;
+set enable_indexscan = off;
+set enable_indexonlyscan = off;
+select count(*) from skip_test where b < 3;
+reset enable_indexscan;
+reset enable_indexonlyscan;
+set enable_bitmapscan = off;
+-- merge join, restoring marked positions on the inner side
+set enable_hashjoin = off;
+set enable_nestloop = off;
+select v.x, t.a, t.b from (values (1), (1), (3)) v(x)
+  join skip_test t on t.a = v.x where t.b = 5;
+reset enable_hashjoin;
+reset enable_nestloop;
+-- with many distinct values in the first column, the scan stops skipping
+create index skip_test_b_c on skip_test (b, c);
+select b, c from skip_test where c = 'n';
+reset enable_seqscan;
+reset enable_bitmapscan;
+drop table skip_test;
@@ -34,3 +34,20 @@ insert into gin_test_tbl select array[1, 3, g] from generate_series(1, 1000) g;
 
 delete from gin_test_tbl where i @> array[2];
 vacuum gin_test_tbl;
+
+-- Rebuild the index in parallel, and check that it returns the same rows.
+drop index gin_test_idx;
+set max_parallel_maintenance_workers = 2;
+alter table gin_test_tbl set (parallel_workers = 2);
+create index gin_test_idx on gin_test_tbl using gin (i);
+reset max_parallel_maintenance_workers;
+set enable_seqscan = off;
+select count(*) from gin_test_tbl where i @> array[1];
+select count(*) from gin_test_tbl where i @> array[1, 3];
+select count(*) from gin_test_tbl where i @> array[1000];
+select count(*) from gin_test_tbl where i @> array[2];
+reset enable_seqscan;
+-- a sequential scan must agree
+set enable_bitmapscan = off;
+select count(*) from gin_test_tbl where i @> array[1, 3];
+reset enable_bitmapscan;
@@ -0,0 +1,46 @@
+--
+-- Incremental sort
+--
+
+create table incsort_tab (a int, b int);
+insert into incsort_tab select i / 10, 1000 - i from generate_series(1, 1000) i;
+create index incsort_tab_a_idx on incsort_tab (a);
+analyze incsort_tab;
+
+-- Force the index scan, which provides the input presorted by "a".
+set enable_seqscan = off;
+
+explain (costs off)
+select a, b from incsort_tab order by a, b limit 10;
+
+-- The bound is applied across batches of several small groups.
+select a, b from incsort_tab order by a, b offset 28 limit 8;
+
+-- Check the ordering of the whole output.
+select count(*) as total,
+       count(*) filter (where (pa, pb) > (a, b)) as out_of_order
+from (select a, b, lag(a) over () as pa, lag(b) over () as pb
+      from (select a, b from incsort_tab order by a, b) s) ss;
+
+-- Same with groups larger than a single batch.
+truncate incsort_tab;
+insert into incsort_tab select i / 100, 1000 - i from generate_series(1, 1000) i;
+analyze incsort_tab;
+
+select a, b from incsort_tab order by a, b offset 97 limit 5;
+
+select count(*) as total,
+       count(*) filter (where (pa, pb) > (a, b)) as out_of_order
+from (select a, b, lag(a) over () as pa, lag(b) over () as pb
+      from (select a, b from incsort_tab order by a, b) s) ss;
+
+-- Without incremental sort, the partial ordering of the index is useless.
+set enable_incremental_sort = off;
+
+explain (costs off)
+select a, b from incsort_tab order by a, b limit 10;
+
+reset enable_incremental_sort;
+reset enable_seqscan;
+
+drop table incsort_tab;
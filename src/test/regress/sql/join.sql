@@ -373,6 +373,26 @@ select count(*) from tenk1 x where
   x.unique1 in (select a.f1 from int4_tbl a,float8_tbl b where a.f1=b.f1) and
   x.unique1 = 0 and
   x.unique1 in (select aa.f1 from int4_tbl aa,float8_tbl bb where aa.f1=bb.f1);
+-- and with the linearized join search
+set large_join_search = linearized;
+select count(*) from tenk1 x where
+  x.unique1 in (select a.f1 from int4_tbl a,float8_tbl b where a.f1=b.f1) and
+  x.unique1 = 0 and
+  x.unique1 in (select aa.f1 from int4_tbl aa,float8_tbl bb where aa.f1=bb.f1);
+select count(*) from int4_tbl c
+  join tenk1 a on a.unique1 = c.f1
+  left join tenk1 b on b.unique2 = a.unique1
+  left join onek d on d.unique1 = b.unique1;
+-- a chain of four relations, joined starting from the smallest
+explain (costs off)
+select count(*) from int4_tbl c
+  join tenk1 a on a.unique1 = c.f1
+  join tenk1 b on b.unique1 = a.unique2
+  join tenk1 d on d.unique1 = b.unique2;
+select count(*) from int4_tbl c
+  join tenk1 a on a.unique1 = c.f1
+  join tenk1 b on b.unique1 = a.unique2
+  join tenk1 d on d.unique1 = b.unique2;
 rollback;
 
 --
@@ -2067,3 +2087,80 @@ where exists (select 1 from j3
       and t1.unique1 < 1;
 
 drop table j3;
+
+--
+-- adaptive nested loops: a nestloop over a materialized inner side switches
+-- to hashing it once the outer side returns far more rows than estimated
+--
+create function adj_outer(n int) returns setof int
+language plpgsql rows 10 as
+$$ begin return query select generate_series(1, n); end $$;
+create table adj_inner (a int, b int);
+insert into adj_inner select g, g from generate_series(1, 2000) g;
+vacuum analyze adj_inner;
+
+-- hide row counts, which depend on how far the inner side got
+create function explain_adaptive(query text) returns setof text
+language plpgsql as
+$$
+declare
+    ln text;
+begin
+    for ln in
+        execute format('explain (analyze, costs off, summary off, timing off) %s',
+            query)
+    loop
+        ln := regexp_replace(ln, 'rows=\d+ loops=\d+', 'rows=N loops=N');
+        ln := regexp_replace(ln, 'Rows Removed by (Join )?Filter: \d+',
+                             'Rows Removed by \1Filter: N');
+        return next ln;
+    end loop;
+end;
+$$;
+
+set enable_hashjoin = off;
+set enable_mergejoin = off;
+set adaptive_join_threshold = 2;
+
+-- switches to hashing after twice the estimated outer rows
+select explain_adaptive('
+select count(*), count(i.a), sum(i.b)
+from adj_outer(100) o left join adj_inner i on i.a = o');
+select count(*), count(i.a), sum(i.b)
+from adj_outer(100) o left join adj_inner i on i.a = o;
+
+-- gives up hashing if the inner side doesn't fit in work_mem
+set work_mem = '64kB';
+select explain_adaptive('
+select count(*), count(i.a), sum(i.b)
+from adj_outer(100) o left join adj_inner i on i.a = o');
+select count(*), count(i.a), sum(i.b)
+from adj_outer(100) o left join adj_inner i on i.a = o;
+reset work_mem;
+
+-- a rescan with new parameter values must rebuild the hash table
+select explain_adaptive('
+select v.x,
+  (select count(i.a)
+   from adj_outer(v.x) o left join adj_inner i on i.a = o and i.b < v.x)
+from (values (30), (5), (50)) v(x)');
+select v.x,
+  (select count(i.a)
+   from adj_outer(v.x) o left join adj_inner i on i.a = o and i.b < v.x)
+from (values (30), (5), (50)) v(x);
+
+-- same answers without hashing
+set adaptive_join_threshold = 0;
+select count(*), count(i.a), sum(i.b)
+from adj_outer(100) o left join adj_inner i on i.a = o;
+select v.x,
+  (select count(i.a)
+   from adj_outer(v.x) o left join adj_inner i on i.a = o and i.b < v.x)
+from (values (30), (5), (50)) v(x);
+
+reset adaptive_join_threshold;
+reset enable_hashjoin;
+reset enable_mergejoin;
+drop function explain_adaptive(text);
+drop table adj_inner;
+drop function adj_outer(int);
@@ -0,0 +1,82 @@
+--
+-- Memoize nodes caching the inner side of parameterized nested loops
+--
+
+create table memo_tab (a int, b int);
+insert into memo_tab select g, g % 20 + 1 from generate_series(1, 1000) g;
+create unique index memo_tab_a_idx on memo_tab (a);
+vacuum analyze memo_tab;
+
+-- hide details that vary across platforms and runs
+create function explain_memoize(query text, hide_hitmiss bool)
+returns setof text
+language plpgsql as
+$$
+declare
+    ln text;
+begin
+    for ln in
+        execute format('explain (analyze, costs off, summary off, timing off) %s',
+            query)
+    loop
+        ln := regexp_replace(ln, 'loops=\d+', 'loops=N');
+        ln := regexp_replace(ln, 'Heap Fetches: \d+', 'Heap Fetches: N');
+        ln := regexp_replace(ln, 'Evictions: 0', 'Evictions: Zero');
+        ln := regexp_replace(ln, 'Evictions: \d+', 'Evictions: N');
+        ln := regexp_replace(ln, 'Memory Usage: \d+', 'Memory Usage: N');
+        if hide_hitmiss then
+            ln := regexp_replace(ln, 'Hits: \d+', 'Hits: N');
+            ln := regexp_replace(ln, 'Misses: \d+', 'Misses: N');
+        end if;
+        return next ln;
+    end loop;
+end;
+$$;
+
+set enable_memoize = on;
+set enable_hashjoin = off;
+set enable_mergejoin = off;
+set enable_bitmapscan = off;
+
+-- the 1000 outer rows only have 20 distinct join keys
+select explain_memoize('
+select count(*), avg(t1.a) from memo_tab t1
+inner join memo_tab t2 on t1.a = t2.b', false);
+select count(*), avg(t1.a) from memo_tab t1
+inner join memo_tab t2 on t1.a = t2.b;
+
+-- a tiny cache must evict entries, and still give the right answer
+create table memo_wide (a int, b int, c text);
+insert into memo_wide
+  select g, g % 100 + 1, repeat('x', 1000) from generate_series(1, 1000) g;
+create index memo_wide_a_idx on memo_wide (a);
+vacuum analyze memo_wide;
+set work_mem = '64kB';
+select explain_memoize('
+select count(*), sum(length(t1.c)) from memo_wide t1
+inner join memo_wide t2 on t1.a = t2.b', true);
+select count(*), sum(length(t1.c)) from memo_wide t1
+inner join memo_wide t2 on t1.a = t2.b;
+reset work_mem;
+drop table memo_wide;
+
+-- lateral references are cached by their binary image, so that values the
+-- equality operator can't tell apart, like numeric 1.0 and 1.00, don't share
+-- a cache entry
+create table memo_num (n numeric);
+insert into memo_num values (1.0), (1.00), (1.0), (1.00);
+analyze memo_num;
+select explain_memoize('
+select t.n, s.v from memo_num t,
+lateral (select t.n::text as v from memo_tab where a = 1 offset 0) s', false);
+select t.n, s.v from memo_num t,
+lateral (select t.n::text as v from memo_tab where a = 1 offset 0) s;
+drop table memo_num;
+
+reset enable_memoize;
+reset enable_hashjoin;
+reset enable_mergejoin;
+reset enable_bitmapscan;
+
+drop function explain_memoize(text, bool);
+drop table memo_tab;
@@ -390,7 +390,9 @@ CREATE TABLE prt4_n_p3 PARTITION OF prt4_n FOR VALUES FROM (500) TO (600);
 INSERT INTO prt4_n SELECT i, i, to_char(i, 'FM0000') FROM generate_series(0, 599, 2) i;
 ANALYZE prt4_n;
 
--- partitionwise join can not be applied if the partition ranges differ
+-- partitionwise join can be applied if the partition ranges differ, by
+-- joining each pair of overlapping partitions; but prt1_p2 overlaps two
+-- partitions of prt4_n and would be scanned twice, so a plain join wins here
 EXPLAIN (COSTS OFF)
 SELECT t1.a, t1.c, t2.b, t2.c FROM prt1 t1, prt4_n t2 WHERE t1.a = t2.a;
 EXPLAIN (COSTS OFF)
@@ -435,3 +437,46 @@ ANALYZE prt2;
 
 EXPLAIN (COSTS OFF)
 SELECT t1.a, t1.c, t2.b, t2.c FROM prt1 t1, prt2 t2 WHERE t1.a = t2.b AND t1.b = 0 ORDER BY t1.a, t2.b;
+
+--
+-- partitionwise join between range partitioned tables with different bounds
+--
+CREATE TABLE prt_month (a int, b int) PARTITION BY RANGE (a);
+CREATE TABLE prt_month_p1 PARTITION OF prt_month FOR VALUES FROM (0) TO (300);
+CREATE TABLE prt_month_p2 PARTITION OF prt_month FOR VALUES FROM (300) TO (600);
+INSERT INTO prt_month SELECT i, i FROM generate_series(0, 599) i;
+ANALYZE prt_month;
+
+CREATE TABLE prt_day (a int, b int) PARTITION BY RANGE (a);
+CREATE TABLE prt_day_p1 PARTITION OF prt_day FOR VALUES FROM (0) TO (100);
+CREATE TABLE prt_day_p2 PARTITION OF prt_day FOR VALUES FROM (100) TO (200);
+CREATE TABLE prt_day_p3 PARTITION OF prt_day FOR VALUES FROM (250) TO (400);
+CREATE TABLE prt_day_p4 PARTITION OF prt_day FOR VALUES FROM (400) TO (600);
+INSERT INTO prt_day SELECT i, i FROM generate_series(0, 599, 3) i WHERE i < 200 OR i >= 250;
+ANALYZE prt_day;
+
+CREATE TABLE prt_week (a int, b int) PARTITION BY RANGE (a);
+CREATE TABLE prt_week_p1 PARTITION OF prt_week FOR VALUES FROM (0) TO (200);
+CREATE TABLE prt_week_p2 PARTITION OF prt_week FOR VALUES FROM (300) TO (500);
+INSERT INTO prt_week SELECT i, i FROM generate_series(0, 499, 3) i WHERE i < 200 OR i >= 300;
+ANALYZE prt_week;
+
+-- each partition of prt_week lies within one partition of prt_month, so
+-- pairing them up costs no extra scans
+EXPLAIN (COSTS OFF)
+SELECT count(*), sum(t1.a) FROM prt_month t1 JOIN prt_week t2 ON t1.a = t2.a;
+SELECT count(*), sum(t1.a) FROM prt_month t1 JOIN prt_week t2 ON t1.a = t2.a;
+-- outer joins still require matching bounds
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM prt_month t1 LEFT JOIN prt_week t2 ON t1.a = t2.a;
+SELECT count(*) FROM prt_month t1 LEFT JOIN prt_week t2 ON t1.a = t2.a;
+
+-- inner and semi joins where a partition overlaps several on the other side
+SELECT count(*), sum(t1.a), sum(t2.b) FROM prt_month t1 JOIN prt_day t2 ON t1.a = t2.a;
+SELECT count(*) FROM prt_month t1 WHERE t1.a IN (SELECT t2.a FROM prt_day t2);
+SELECT count(*), sum(t1.a) FROM prt_month t1 JOIN prt_day t2 ON t1.a = t2.a JOIN prt4_n t3 ON t2.a = t3.a;
+SELECT count(*) FROM prt_month t1 LEFT JOIN prt_day t2 ON t1.a = t2.a;
+
+DROP TABLE prt_month;
+DROP TABLE prt_day;
+DROP TABLE prt_week;
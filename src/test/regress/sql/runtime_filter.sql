@@ -0,0 +1,57 @@
+--
+-- Runtime filters pushed down from hash joins into their outer side
+--
+
+create table rf_fact (id int, dim_id int);
+insert into rf_fact select g, g % 1000 from generate_series(1, 10000) g;
+create table rf_dim (id int, name text);
+insert into rf_dim select g, 'd' || g from generate_series(0, 999) g;
+create table rf_part (id int, dim_id int) partition by range (id);
+create table rf_part_1 partition of rf_part for values from (minvalue) to (5001);
+create table rf_part_2 partition of rf_part for values from (5001) to (maxvalue);
+insert into rf_part select * from rf_fact;
+analyze rf_fact;
+analyze rf_dim;
+analyze rf_part;
+
+-- hide the memory usage of the hash table, which varies across platforms
+create function explain_rf(query text) returns setof text
+language plpgsql as
+$$
+declare
+    ln text;
+begin
+    for ln in
+        execute format('explain (analyze, costs off, summary off, timing off) %s',
+            query)
+    loop
+        if ln like '%Memory Usage%' then
+            continue;
+        end if;
+        return next ln;
+    end loop;
+end;
+$$;
+
+set hashjoin_runtime_filter = on;
+set enable_nestloop = off;
+set enable_mergejoin = off;
+set max_parallel_workers_per_gather = 0;
+
+select explain_rf('select count(*) from rf_fact f join rf_dim d on f.dim_id = d.id where d.name like ''d1_''');
+select count(*) from rf_fact f join rf_dim d on f.dim_id = d.id where d.name like 'd1_';
+
+-- the filter is also pushed through Append
+select explain_rf('select count(*) from rf_part f join rf_dim d on f.dim_id = d.id where d.name like ''d1_''');
+select count(*) from rf_part f join rf_dim d on f.dim_id = d.id where d.name like 'd1_';
+
+-- not used when unmatched outer rows must be returned
+select count(*) from rf_fact f left join rf_dim d on f.dim_id = d.id and d.name like 'd1_';
+
+reset hashjoin_runtime_filter;
+reset enable_nestloop;
+reset enable_mergejoin;
+reset max_parallel_workers_per_gather;
+
+drop function explain_rf(text);
+drop table rf_fact, rf_dim, rf_part;
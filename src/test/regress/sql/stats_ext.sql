@@ -447,6 +447,28 @@ SELECT * FROM check_estimated_rows('SELECT * FROM mcv_lists_bool WHERE NOT a AND
 
 SELECT * FROM check_estimated_rows('SELECT * FROM mcv_lists_bool WHERE NOT a AND b AND NOT c');
 
+-- mcv lists used to estimate joins on several columns
+CREATE TABLE mcv_join1 (a INT, b INT);
+CREATE TABLE mcv_join2 (a INT, b INT);
+
+INSERT INTO mcv_join1 (a, b)
+     SELECT mod(i,100), mod(i,100) FROM generate_series(1,5000) s(i);
+INSERT INTO mcv_join2 (a, b)
+     SELECT mod(i,100), mod(i,100) FROM generate_series(1,5000) s(i);
+
+ANALYZE mcv_join1, mcv_join2;
+
+SELECT * FROM check_estimated_rows('SELECT * FROM mcv_join1 j1 JOIN mcv_join2 j2 ON (j1.a = j2.a AND j1.b = j2.b)');
+
+CREATE STATISTICS mcv_join1_stats (mcv) ON a, b FROM mcv_join1;
+CREATE STATISTICS mcv_join2_stats (mcv) ON a, b FROM mcv_join2;
+
+ANALYZE mcv_join1, mcv_join2;
+
+SELECT * FROM check_estimated_rows('SELECT * FROM mcv_join1 j1 JOIN mcv_join2 j2 ON (j1.a = j2.a AND j1.b = j2.b)');
+
+DROP TABLE mcv_join1, mcv_join2;
+
 -- Permission tests. Users should not be able to see specific data values in
 -- the extended statistics, if they lack permission to see those values in
 -- the underlying table.
@@ -535,6 +535,46 @@ SELECT 2\; RELEASE SAVEPOINT sp\; SELECT 3;
 -- but this is OK, because the BEGIN converts it to a regular xact
 SELECT 1\; BEGIN\; SAVEPOINT sp\; ROLLBACK TO SAVEPOINT sp\; COMMIT;
 
+-- an error raised while a WAL batch is being collected must not prevent
+-- later WAL insertions, including the abort record
+CREATE TABLE wal_batch_tbl (a int);
+BEGIN;
+INSERT INTO wal_batch_tbl VALUES (1);
+SELECT test_wal_batch_error();
+ROLLBACK;
+BEGIN;
+INSERT INTO wal_batch_tbl VALUES (2);
+SAVEPOINT sp;
+INSERT INTO wal_batch_tbl VALUES (3);
+SELECT test_wal_batch_error();
+ROLLBACK TO SAVEPOINT sp;
+INSERT INTO wal_batch_tbl VALUES (4);
+COMMIT;
+SELECT * FROM wal_batch_tbl;
+DROP TABLE wal_batch_tbl;
+
+-- snapshots are reused until a transaction completes; a cached plan must
+-- still see the effects of each command and of completed (sub)transactions
+CREATE TABLE snap_reuse_tbl (a int);
+SET plan_cache_mode = force_generic_plan;
+PREPARE snap_reuse_q AS SELECT count(*), sum(a) FROM snap_reuse_tbl;
+EXECUTE snap_reuse_q;
+INSERT INTO snap_reuse_tbl VALUES (1);
+EXECUTE snap_reuse_q;
+BEGIN;
+INSERT INTO snap_reuse_tbl VALUES (2);
+EXECUTE snap_reuse_q;
+SAVEPOINT sp;
+INSERT INTO snap_reuse_tbl VALUES (4);
+EXECUTE snap_reuse_q;
+ROLLBACK TO SAVEPOINT sp;
+EXECUTE snap_reuse_q;
+COMMIT;
+EXECUTE snap_reuse_q;
+DEALLOCATE snap_reuse_q;
+RESET plan_cache_mode;
+DROP TABLE snap_reuse_tbl;
+
 
 -- Test for successful cleanup of an aborted transaction at session exit.
 -- THIS MUST BE THE LAST TEST IN THIS FILE.